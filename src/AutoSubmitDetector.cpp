@@ -0,0 +1,40 @@
+#include "AutoSubmitDetector.h"
+
+AutoSubmitDetector::AutoSubmitDetector(unsigned long dwellMs, float maxStdDevDegrees)
+    : dwellUs((int64_t)dwellMs * 1000), maxVariance(maxStdDevDegrees * maxStdDevDegrees) {
+}
+
+void AutoSubmitDetector::reset() {
+  x.reset();
+  y.reset();
+  z.reset();
+  holdStartUs = -1;
+}
+
+void AutoSubmitDetector::addSample(const OrientationSample& sample) {
+  x.add(sample.x);
+  y.add(sample.y);
+  z.add(sample.z);
+  lastTimestampUs = sample.timestampUs;
+}
+
+bool AutoSubmitDetector::isStable() const {
+  return x.isFull() && x.getVariance() <= maxVariance && y.getVariance() <= maxVariance &&
+         z.getVariance() <= maxVariance;
+}
+
+OrientationSample AutoSubmitDetector::getMean() const {
+  return {lastTimestampUs, x.getMean(), y.getMean(), z.getMean()};
+}
+
+bool AutoSubmitDetector::holdElapsed(bool onTarget, int64_t nowUs) {
+  if (!onTarget) {
+    holdStartUs = -1;
+    return false;
+  }
+
+  if (holdStartUs < 0) {
+    holdStartUs = nowUs;
+  }
+  return nowUs - holdStartUs >= dwellUs;
+}
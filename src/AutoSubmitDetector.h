@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "OrientationHistory.h"
+#include "SlidingWindow.h"
+#include "hardware_config.h"
+
+// Decides when a hands-free submission should fire: the windowed orientation must be steady and
+// on target continuously for the dwell time. Every call is O(1) so it can run on each sample.
+class AutoSubmitDetector {
+  public:
+    AutoSubmitDetector(unsigned long dwellMs, float maxStdDevDegrees);
+
+    void reset();
+    void addSample(const OrientationSample& sample);
+
+    bool isStable() const;
+    OrientationSample getMean() const;
+
+    // Returns true once onTarget has held for the dwell time
+    bool holdElapsed(bool onTarget, int64_t nowUs);
+
+  private:
+    SlidingWindow<AUTO_SUBMIT_WINDOW_SAMPLES> x;
+    SlidingWindow<AUTO_SUBMIT_WINDOW_SAMPLES> y;
+    SlidingWindow<AUTO_SUBMIT_WINDOW_SAMPLES> z;
+
+    int64_t dwellUs;
+    float maxVariance;
+    int64_t lastTimestampUs = 0;
+    int64_t holdStartUs = -1;
+};
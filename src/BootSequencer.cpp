@@ -0,0 +1,85 @@
+#include "BootSequencer.h"
+
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+uint32_t BootSequencer::addStep(const char* name, BootStepFunction run, uint32_t dependsOn) {
+  if (numSteps >= maxSteps) {
+    Serial.printf("✗ Boot step %s dropped: too many steps\n", name);
+    return 0;
+  }
+
+  Step& step = steps[numSteps];
+  step.name = name;
+  step.run = run;
+  step.bit = 1u << numSteps;
+  step.dependsOn = dependsOn;
+  step.owner = this;
+  numSteps++;
+  return step.bit;
+}
+
+// Without an event group, or when a step's task cannot be created, the step runs right here on
+// the caller instead; the boot is slower but never waits on a bit nobody will set
+void BootSequencer::run() {
+  doneBits = xEventGroupCreate();
+  if (doneBits == nullptr) {
+    Serial.println("✗ No event group for the boot steps, running them one after another");
+  }
+
+  const uint32_t allBits = (1u << numSteps) - 1;
+  uint32_t started = 0;
+  uint32_t done = 0;
+
+  while (done != allBits) {
+    bool ranInline = false;
+    for (int i = 0; i < numSteps; i++) {
+      Step& step = steps[i];
+      if ((started & step.bit) != 0 || (step.dependsOn & done) != step.dependsOn) {
+        continue;
+      }
+      started |= step.bit;
+      step.startUs = esp_timer_get_time();
+      if (doneBits != nullptr && xTaskCreate(&BootSequencer::stepTask, step.name, stepStackSize,
+                                             &step, 1, nullptr) == pdPASS) {
+        continue;
+      }
+      if (doneBits != nullptr) {
+        Serial.printf("✗ No task for boot step %s, running it inline\n", step.name);
+      }
+      step.run();
+      step.endUs = esp_timer_get_time();
+      done |= step.bit;
+      ranInline = true;
+    }
+
+    // Steps that waited on one run inline may be ready now; otherwise wait for a task to finish
+    if (!ranInline) {
+      done |= xEventGroupWaitBits(doneBits, allBits & ~done, pdFALSE, pdFALSE, portMAX_DELAY) &
+              allBits;
+    }
+  }
+
+  if (doneBits != nullptr) {
+    vEventGroupDelete(doneBits);
+    doneBits = nullptr;
+  }
+}
+
+void BootSequencer::stepTask(void* arg) {
+  Step* step = static_cast<Step*>(arg);
+  step->run();
+  step->endUs = esp_timer_get_time();
+  xEventGroupSetBits(step->owner->doneBits, step->bit);
+  vTaskDelete(nullptr);
+}
+
+void BootSequencer::printTimeline(int64_t readyUs) const {
+  Serial.println("Boot timeline (ms since power-on):");
+  for (int i = 0; i < numSteps; i++) {
+    const Step& step = steps[i];
+    Serial.printf("  %-10s %8.1f -> %8.1f  (%.1f)\n", step.name, step.startUs / 1000.0,
+                  step.endUs / 1000.0, (step.endUs - step.startUs) / 1000.0);
+  }
+  Serial.printf("  Ready in %.1f ms\n", readyUs / 1000.0);
+}
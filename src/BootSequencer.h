@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+typedef void (*BootStepFunction)();
+
+// Runs setup steps as soon as the steps they depend on have finished, each on its own short-lived
+// task, and keeps a start/end timeline of the whole boot
+class BootSequencer {
+  public:
+    // Returns the step's bit, to be OR-ed into the dependsOn mask of later steps
+    uint32_t addStep(const char* name, BootStepFunction run, uint32_t dependsOn = 0);
+    void run();
+
+    void printTimeline(int64_t readyUs) const;
+
+  private:
+    struct Step {
+        const char* name;
+        BootStepFunction run;
+        uint32_t bit;
+        uint32_t dependsOn;
+        int64_t startUs;
+        int64_t endUs;
+        BootSequencer* owner;
+    };
+
+    static constexpr int maxSteps = 12;
+    static constexpr uint32_t stepStackSize = 8192;
+
+    Step steps[maxSteps] = {};
+    int numSteps = 0;
+    EventGroupHandle_t doneBits = nullptr;
+
+    static void stepTask(void* arg);
+};
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <esp32-hal-ledc.h>
 
+#include "TimerWheel.h"
 #include "hardware_config.h"
 
 // Use a fixed LEDC channel to avoid conflicts with FastLED (which uses RMT)
@@ -10,38 +11,84 @@
 #define BUZZER_LEDC_CHANNEL 4
 #define BUZZER_LEDC_RESOLUTION 8
 
-static void playTone(int freq, int duration_ms) {
+const BuzzerController::Note BuzzerController::successMelody[] = {
+    {1000, 200, 250},
+    {1500, 200, 250},
+    {2000, 300, 0},
+};
+
+const BuzzerController::Note BuzzerController::triumphMelody[] = {
+    {1000, 200, 250},
+    {1200, 200, 250},
+    {1500, 300, 350},
+    {2000, 400, 450},
+};
+
+const BuzzerController::Note* BuzzerController::melody = nullptr;
+int BuzzerController::melodyLength = 0;
+int BuzzerController::nextNote = 0;
+int BuzzerController::repeatsLeft = 0;
+bool BuzzerController::toneOn = false;
+
+static void startTone(int freq) {
   ledcSetup(BUZZER_LEDC_CHANNEL, freq, BUZZER_LEDC_RESOLUTION);
   ledcAttachPin(BUZZER_PIN, BUZZER_LEDC_CHANNEL);
   ledcWriteTone(BUZZER_LEDC_CHANNEL, freq);
-  delay(duration_ms);
+}
+
+static void stopTone() {
   ledcWriteTone(BUZZER_LEDC_CHANNEL, 0);
   ledcDetachPin(BUZZER_PIN);
 }
 
 void BuzzerController::playSuccessMelody() {
-  playTone(1000, 200);
-  delay(250);
-  playTone(1500, 200);
-  delay(250);
-  playTone(2000, 300);
+  play(successMelody, sizeof(successMelody) / sizeof(successMelody[0]), 1);
 }
 
 void BuzzerController::playTriumphMelody() {
-  playTone(1000, 200);
-  delay(250);
-  playTone(1200, 200);
-  delay(250);
-  playTone(1500, 300);
-  delay(350);
-  playTone(2000, 400);
-  delay(450);
-  playTone(1000, 200);
-  delay(250);
-  playTone(1200, 200);
-  delay(250);
-  playTone(1500, 300);
-  delay(350);
-  playTone(2000, 400);
-  delay(450);
-}
\ No newline at end of file
+  play(triumphMelody, sizeof(triumphMelody) / sizeof(triumphMelody[0]), 2);
+}
+
+// A new melody cuts off whatever is still playing
+void BuzzerController::play(const Note* notes, int length, int repeats) {
+  if (toneOn) {
+    stopTone();
+    toneOn = false;
+  }
+  melody = notes;
+  melodyLength = length;
+  nextNote = 0;
+  repeatsLeft = repeats - 1;
+  advance();
+}
+
+// Alternates between ending the current note and starting the next one after its pause
+void BuzzerController::advance() {
+  if (melody == nullptr) {
+    return;
+  }
+
+  if (toneOn) {
+    stopTone();
+    toneOn = false;
+    const Note& played = melody[nextNote - 1];
+    if (played.pauseMs > 0) {
+      TimerWheel::schedule(TIMER_MELODY, played.pauseMs * 1000UL);
+      return;
+    }
+  }
+
+  if (nextNote == melodyLength) {
+    if (repeatsLeft == 0) {
+      melody = nullptr;
+      return;
+    }
+    repeatsLeft--;
+    nextNote = 0;
+  }
+
+  const Note& note = melody[nextNote++];
+  startTone(note.frequency);
+  toneOn = true;
+  TimerWheel::schedule(TIMER_MELODY, note.durationMs * 1000UL);
+}
@@ -1,7 +1,30 @@
 #pragma once
 
+#include <stdint.h>
+
+// Melodies play in the background: each note is started by advance(), which the main loop calls
+// when TIMER_MELODY expires
 class BuzzerController {
   public:
     static void playSuccessMelody();
     static void playTriumphMelody();
-};
\ No newline at end of file
+    static void advance();
+
+  private:
+    struct Note {
+        uint16_t frequency;
+        uint16_t durationMs;
+        uint16_t pauseMs;  // silence after the note
+    };
+
+    static const Note successMelody[];
+    static const Note triumphMelody[];
+
+    static const Note* melody;
+    static int melodyLength;
+    static int nextNote;
+    static int repeatsLeft;
+    static bool toneOn;
+
+    static void play(const Note* notes, int length, int repeats);
+};
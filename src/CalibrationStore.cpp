@@ -0,0 +1,61 @@
+#include "CalibrationStore.h"
+
+#include <Preferences.h>
+#include <stddef.h>
+
+#include "Crc.h"
+
+static const char* NVS_NAMESPACE = "calibration";
+
+NvsCalibrationStorage::NvsCalibrationStorage(const char* key) : key(key) {
+}
+
+size_t NvsCalibrationStorage::read(void* data, size_t length) {
+  Preferences preferences;
+  if (!preferences.begin(NVS_NAMESPACE, true)) {
+    return 0;
+  }
+  size_t bytesRead =
+      preferences.getBytesLength(key) == length ? preferences.getBytes(key, data, length) : 0;
+  preferences.end();
+  return bytesRead;
+}
+
+bool NvsCalibrationStorage::write(const void* data, size_t length) {
+  Preferences preferences;
+  if (!preferences.begin(NVS_NAMESPACE, false)) {
+    return false;
+  }
+  bool written = preferences.putBytes(key, data, length) == length;
+  preferences.end();
+  return written;
+}
+
+CalibrationStore::CalibrationStore(CalibrationStorage& storage) : storage(storage) {
+}
+
+uint32_t CalibrationStore::checksum(const CalibrationRecord& record) {
+  return Crc::crc32(&record, offsetof(CalibrationRecord, crc));
+}
+
+bool CalibrationStore::load(CalibrationRecord& record) {
+  if (storage.read(&record, sizeof(record)) != sizeof(record)) {
+    return false;
+  }
+  return record.magic == recordMagic && record.version == recordVersion &&
+         record.crc == checksum(record);
+}
+
+bool CalibrationStore::save(const float gyroOffsets[3], const float accOffsets[3],
+                            float temperatureC) {
+  CalibrationRecord record = {};
+  record.magic = recordMagic;
+  record.version = recordVersion;
+  for (int axis = 0; axis < 3; axis++) {
+    record.gyroOffsets[axis] = gyroOffsets[axis];
+    record.accOffsets[axis] = accOffsets[axis];
+  }
+  record.temperatureC = temperatureC;
+  record.crc = checksum(record);
+  return storage.write(&record, sizeof(record));
+}
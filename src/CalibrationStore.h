@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+struct CalibrationRecord {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    float gyroOffsets[3];  // deg/s
+    float accOffsets[3];   // g
+    float temperatureC;    // die temperature when the offsets were captured
+    uint32_t crc;          // over every field above
+};
+
+// Where a record's bytes live. NVS on the device; anything byte-addressable elsewhere.
+class CalibrationStorage {
+  public:
+    virtual ~CalibrationStorage() {
+    }
+    virtual size_t read(void* data, size_t length) = 0;
+    virtual bool write(const void* data, size_t length) = 0;
+};
+
+class NvsCalibrationStorage : public CalibrationStorage {
+  public:
+    explicit NvsCalibrationStorage(const char* key = "mpu6050");
+
+    size_t read(void* data, size_t length) override;
+    bool write(const void* data, size_t length) override;
+
+  private:
+    const char* key;
+};
+
+// Versioned, checksummed MPU6050 offsets so a warm device can skip the full calibration
+class CalibrationStore {
+  public:
+    explicit CalibrationStore(CalibrationStorage& storage);
+
+    bool load(CalibrationRecord& record);
+    bool save(const float gyroOffsets[3], const float accOffsets[3], float temperatureC);
+
+  private:
+    static constexpr uint16_t recordMagic = 0xCA1B;
+    static constexpr uint8_t recordVersion = 1;
+
+    CalibrationStorage& storage;
+
+    static uint32_t checksum(const CalibrationRecord& record);
+};
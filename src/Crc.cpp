@@ -0,0 +1,14 @@
+#include "Crc.h"
+
+// Bitwise CRC-32 (IEEE 802.3, reflected). Records are small, so a table is not worth its RAM.
+uint32_t Crc::crc32(const void* data, size_t length, uint32_t crc) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
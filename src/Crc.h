@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Crc {
+  public:
+    static uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
+};
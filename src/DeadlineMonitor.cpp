@@ -0,0 +1,192 @@
+#include "DeadlineMonitor.h"
+
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <stddef.h>
+
+#include "Crc.h"
+#include "HotPath.h"
+#include "Log.h"
+
+DeadlineMonitor::Deadline DeadlineMonitor::deadlines[maxDeadlines];
+volatile int DeadlineMonitor::numDeadlines = 0;
+portMUX_TYPE DeadlineMonitor::addLock = portMUX_INITIALIZER_UNLOCKED;
+const volatile int* DeadlineMonitor::state = nullptr;
+DeadlineMonitor::StateNamer DeadlineMonitor::stateName = nullptr;
+
+DeadlineMonitor::EventRecord DeadlineMonitor::events[eventCount];
+volatile uint32_t DeadlineMonitor::nextEvent = 0;
+volatile int64_t DeadlineMonitor::lastSensorUs = -1;
+
+RTC_NOINIT_ATTR DeadlineMonitor::Snapshot DeadlineMonitor::snapshot;
+StackType_t DeadlineMonitor::checkerStack[checkerStackSize];
+StaticTask_t DeadlineMonitor::checkerTaskControl;
+
+void DeadlineMonitor::begin(const volatile int* currentState, StateNamer namer) {
+  state = currentState;
+  stateName = namer;
+
+  if (!isValid()) {
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.magic = snapshotMagic;
+    snapshot.reported = true;
+    seal();
+  } else if (!snapshot.reported) {
+    printReport();
+  }
+
+  // Core 0, so a stall of loop() on core 1 never holds up its own watchdog
+  xTaskCreateStaticPinnedToCore(&checkerTask, "deadline", checkerStackSize, nullptr,
+                                configMAX_PRIORITIES - 1, checkerStack, &checkerTaskControl, 0);
+}
+
+// Worker tasks register themselves as they start, so two may get here at once
+int DeadlineMonitor::add(const char* name, uint32_t periodMs) {
+  portENTER_CRITICAL(&addLock);
+  int id = numDeadlines;
+  if (id < maxDeadlines) {
+    Deadline& deadline = deadlines[id];
+    deadline.name = name;
+    deadline.task = xTaskGetCurrentTaskHandle();
+    deadline.periodMs = periodMs;
+    deadline.lastCheckInUs = esp_timer_get_time();
+    deadline.lastCheckInPc = 0;
+    deadline.paused = false;
+    deadline.overrun = false;
+    numDeadlines = id + 1;  // published last; the checker only reads registered slots
+  }
+  portEXIT_CRITICAL(&addLock);
+  return id < maxDeadlines ? id : -1;
+}
+
+void DeadlineMonitor::setPeriod(int id, uint32_t periodMs) {
+  if (id >= 0) {
+    deadlines[id].periodMs = periodMs;
+  }
+}
+
+void HOT_CODE __attribute__((noinline)) DeadlineMonitor::checkIn(int id) {
+  if (id < 0) {
+    return;
+  }
+  Deadline& deadline = deadlines[id];
+  deadline.lastCheckInUs = esp_timer_get_time();
+  deadline.lastCheckInPc = (uint32_t)(uintptr_t)__builtin_return_address(0);
+  deadline.paused = false;
+  deadline.overrun = false;
+}
+
+void DeadlineMonitor::pause(int id) {
+  if (id >= 0) {
+    deadlines[id].paused = true;
+  }
+}
+
+// Main loop only. The checker may read a record while it is written; a torn event in a snapshot
+// is an acceptable price for keeping this to a few stores.
+void HOT_CODE DeadlineMonitor::noteEvent(const Event& event) {
+  EventRecord& record = events[nextEvent % eventCount];
+  record.timestampUs = event.timestampUs;
+  record.value = event.value;
+  record.type = event.type;
+  nextEvent = nextEvent + 1;
+}
+
+void HOT_CODE DeadlineMonitor::noteSensorUpdate() {
+  lastSensorUs = esp_timer_get_time();
+}
+
+void DeadlineMonitor::printReport() {
+  if (!isValid() || snapshot.overruns == 0) {
+    Serial.println("Deadline monitor: no overruns recorded");
+    return;
+  }
+
+  Serial.printf("Deadline overruns: %u, the latest at %.3f s of uptime:\n", snapshot.overruns,
+                snapshot.uptimeUs / 1e6);
+  Serial.printf("  task %s missed its %u ms deadline, %u ms since its last check-in\n",
+                snapshot.task, snapshot.periodMs, snapshot.lateMs);
+  Serial.printf("  pc 0x%08x (%s)\n", snapshot.pc,
+                snapshot.pcAtCheckIn ? "last check-in; task was running" : "where it waits");
+  Serial.printf("  state %s\n", snapshot.state);
+  if (snapshot.sinceSensorUs >= 0) {
+    Serial.printf("  sensor last read %.1f ms before\n", snapshot.sinceSensorUs / 1000.0);
+  } else {
+    Serial.println("  sensor not read yet");
+  }
+  for (int i = 0; i < eventCount; i++) {
+    const EventRecord& event = snapshot.events[i];
+    if (event.timestampUs != 0) {
+      Serial.printf("  event %u value 0x%08x at %.3f s\n", event.type, event.value,
+                    event.timestampUs / 1e6);
+    }
+  }
+
+  snapshot.reported = true;
+  seal();
+}
+
+void DeadlineMonitor::checkerTask(void* arg) {
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(DEADLINE_CHECK_INTERVAL_MS));
+
+    int64_t nowUs = esp_timer_get_time();
+    for (int i = 0; i < numDeadlines; i++) {
+      Deadline& deadline = deadlines[i];
+      if (deadline.paused || deadline.overrun ||
+          nowUs - deadline.lastCheckInUs <= (int64_t)deadline.periodMs * 1000) {
+        continue;
+      }
+      deadline.overrun = true;  // one snapshot per stall
+      capture(deadline, nowUs);
+      LOG_WARN(LOG_CAT_STATE, "Deadline overrun: %s silent for %u ms", deadline.name,
+               (uint32_t)((nowUs - deadline.lastCheckInUs) / 1000));
+    }
+  }
+}
+
+void DeadlineMonitor::capture(const Deadline& deadline, int64_t nowUs) {
+  snapshot.overruns++;
+  snapshot.reported = false;
+  snapshot.uptimeUs = nowUs;
+  strncpy(snapshot.task, deadline.name, sizeof(snapshot.task) - 1);
+  snapshot.task[sizeof(snapshot.task) - 1] = '\0';
+  snapshot.periodMs = deadline.periodMs;
+  snapshot.lateMs = (uint32_t)((nowUs - deadline.lastCheckInUs) / 1000);
+
+  snapshot.pcAtCheckIn = eTaskGetState(deadline.task) == eRunning;
+  snapshot.pc = snapshot.pcAtCheckIn ? deadline.lastCheckInPc : getSavedPc(deadline.task);
+
+  const char* name = state != nullptr && stateName != nullptr ? stateName(*state) : "unknown";
+  strncpy(snapshot.state, name, sizeof(snapshot.state) - 1);
+  snapshot.state[sizeof(snapshot.state) - 1] = '\0';
+
+  int64_t sensorUs = lastSensorUs;
+  snapshot.sinceSensorUs = sensorUs >= 0 ? nowUs - sensorUs : -1;
+
+  uint32_t next = nextEvent;
+  for (int i = 0; i < eventCount; i++) {
+    snapshot.events[i] = events[(next + i) % eventCount];
+  }
+  seal();
+}
+
+// A task that is not running has its registers saved on its own stack. The first word of its TCB
+// points at that frame, and the Xtensa port keeps the PC in the frame's second word.
+uint32_t DeadlineMonitor::getSavedPc(TaskHandle_t task) {
+#ifdef __XTENSA__
+  const uint32_t* frame = *reinterpret_cast<const uint32_t* const*>(task);
+  return frame[1];
+#else
+  return 0;
+#endif
+}
+
+void DeadlineMonitor::seal() {
+  snapshot.crc = Crc::crc32(&snapshot, offsetof(Snapshot, crc));
+}
+
+bool DeadlineMonitor::isValid() {
+  return snapshot.magic == snapshotMagic &&
+         snapshot.crc == Crc::crc32(&snapshot, offsetof(Snapshot, crc));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "EventQueue.h"
+#include "hardware_config.h"
+
+// Watches loop() and the worker tasks for stalls. Each registers the longest it may go between
+// check-ins; a checker task at top priority looks every DEADLINE_CHECK_INTERVAL_MS, and the
+// first time a deadline is missed it writes a snapshot into RTC memory: the task, where it was,
+// the state, the last events and how long since the sensor was read. The snapshot survives the
+// watchdog or panic reset a hang usually ends in and is printed at the next boot, or any time
+// with 'w'. A check-in is one timer read and two stores.
+class DeadlineMonitor {
+  public:
+    typedef const char* (*StateNamer)(int state);
+
+    static void begin(const volatile int* state, StateNamer stateName);
+
+    // Registers the calling task; returns the id to check in with, or -1 when full
+    static int add(const char* name, uint32_t periodMs);
+    static void setPeriod(int id, uint32_t periodMs);
+    static void checkIn(int id);
+    static void pause(int id);  // for a known long wait; the next check-in resumes watching
+
+    static void noteEvent(const Event& event);
+    static void noteSensorUpdate();
+
+    static void printReport();
+
+  private:
+    struct Deadline {
+        const char* name;
+        TaskHandle_t task;
+        volatile uint32_t periodMs;
+        volatile int64_t lastCheckInUs;
+        volatile uint32_t lastCheckInPc;
+        volatile bool paused;
+        volatile bool overrun;
+    };
+
+    struct EventRecord {
+        int64_t timestampUs;
+        uint32_t value;
+        EventType type;
+    };
+
+    static constexpr int eventCount = 8;
+
+    struct Snapshot {
+        uint32_t magic;
+        uint32_t overruns;  // since power-on; the snapshot is of the latest
+        bool reported;  // printed since it was taken
+        int64_t uptimeUs;
+        char task[16];
+        uint32_t periodMs;
+        uint32_t lateMs;  // since the last check-in
+        uint32_t pc;
+        bool pcAtCheckIn;  // the task was running, so only its last check-in is known
+        char state[32];
+        int64_t sinceSensorUs;  // -1 if the sensor was never read
+        EventRecord events[eventCount];  // oldest first
+        uint32_t crc;
+    };
+
+    static constexpr uint32_t snapshotMagic = 0xDEAD0001;
+    static constexpr int maxDeadlines = 4;
+    static constexpr uint32_t checkerStackSize = 2048;
+
+    static Deadline deadlines[maxDeadlines];
+    static volatile int numDeadlines;
+    static portMUX_TYPE addLock;
+    static const volatile int* state;
+    static StateNamer stateName;
+
+    static EventRecord events[eventCount];
+    static volatile uint32_t nextEvent;
+    static volatile int64_t lastSensorUs;
+
+    static Snapshot snapshot;
+    static StackType_t checkerStack[checkerStackSize];
+    static StaticTask_t checkerTaskControl;
+
+    static void checkerTask(void* arg);
+    static void capture(const Deadline& deadline, int64_t nowUs);
+    static uint32_t getSavedPc(TaskHandle_t task);
+    static void seal();
+    static bool isValid();
+};
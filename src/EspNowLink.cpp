@@ -0,0 +1,278 @@
+#include "EspNowLink.h"
+
+#include <esp_timer.h>
+
+#include "Crc.h"
+#include "EventQueue.h"
+#include "HotPath.h"
+#include "Log.h"
+#include "TimerWheel.h"
+#include "TraceRecorder.h"
+#include "hardware_config.h"
+
+LinkFrameHandler EspNowLink::handlers[LINK_FRAME_TYPE_COUNT] = {};
+LinkHandlerContext EspNowLink::contexts[LINK_FRAME_TYPE_COUNT] = {};
+LinkSendStatusHandler EspNowLink::sendStatusHandler = nullptr;
+
+EspNowLink::Outbox EspNowLink::outboxes[maxOutboxes];
+int EspNowLink::numOutboxes = 0;
+portMUX_TYPE EspNowLink::outboxLock = portMUX_INITIALIZER_UNLOCKED;
+bool EspNowLink::flushScheduled = false;
+
+EspNowLink::InboxMessage EspNowLink::inbox[inboxLength];
+int EspNowLink::inboxHead = 0;
+int EspNowLink::inboxCount = 0;
+uint32_t EspNowLink::droppedMessages = 0;
+uint32_t EspNowLink::reportedDrops = 0;
+portMUX_TYPE EspNowLink::inboxLock = portMUX_INITIALIZER_UNLOCKED;
+
+void EspNowLink::begin() {
+  esp_now_register_recv_cb(&onReceive);
+  esp_now_register_send_cb(&onSent);
+}
+
+void EspNowLink::registerHandler(LinkFrameType type, LinkFrameHandler handler,
+                                 LinkHandlerContext context) {
+  contexts[type] = context;
+  handlers[type] = handler;
+}
+
+void EspNowLink::registerSendStatusHandler(LinkSendStatusHandler handler) {
+  sendStatusHandler = handler;
+}
+
+bool EspNowLink::send(const uint8_t* mac, LinkFrameType type, const void* payload,
+                      size_t length) {
+  return enqueue(mac, type, payload, length, false);
+}
+
+bool EspNowLink::queue(const uint8_t* mac, LinkFrameType type, const void* payload,
+                       size_t length) {
+  if (!enqueue(mac, type, payload, length, LINK_AGGREGATION_WINDOW_US > 0)) {
+    return false;
+  }
+  if (LINK_AGGREGATION_WINDOW_US > 0 && !flushScheduled) {
+    TimerWheel::schedule(TIMER_LINK_FLUSH, LINK_AGGREGATION_WINDOW_US);
+    flushScheduled = true;
+  }
+  return true;
+}
+
+void EspNowLink::flush() {
+  flushScheduled = false;
+
+  uint8_t messages[bundleCapacity];
+  for (int i = 0; i < numOutboxes; i++) {
+    portENTER_CRITICAL(&outboxLock);
+    Outbox& box = outboxes[i];
+    size_t length = box.length;
+    int count = box.count;
+    memcpy(messages, box.messages, length);
+    box.length = 0;
+    box.count = 0;
+    portEXIT_CRITICAL(&outboxLock);
+
+    if (count > 0) {
+      transmit(box.mac, messages, length, count);
+    }
+  }
+}
+
+// Appends the message to its peer's outbox. What is held there goes out first if the message
+// does not fit alongside it, and all of it goes out now unless the message can wait.
+bool EspNowLink::enqueue(const uint8_t* mac, LinkFrameType type, const void* payload,
+                         size_t length, bool deferrable) {
+  if (messageHeaderSize + length > bundleCapacity) {
+    return false;
+  }
+  TraceRecorder::recordLinkMessage(esp_timer_get_time(), mac, type, length, deferrable);
+
+  uint8_t taken[bundleCapacity];
+  size_t takenLength = 0;
+  int takenCount = 0;
+  bool sent = true;
+
+  portENTER_CRITICAL(&outboxLock);
+  Outbox* box = findOutbox(mac);
+  if (box == nullptr) {
+    portEXIT_CRITICAL(&outboxLock);
+    taken[0] = type;
+    taken[1] = (uint8_t)length;
+    memcpy(taken + messageHeaderSize, payload, length);
+    return transmit(mac, taken, messageHeaderSize + length, 1);
+  }
+
+  if (box->length + messageHeaderSize + length > bundleCapacity) {
+    takenLength = box->length;
+    takenCount = box->count;
+    memcpy(taken, box->messages, takenLength);
+    box->length = 0;
+    box->count = 0;
+    portEXIT_CRITICAL(&outboxLock);
+    sent = transmit(mac, taken, takenLength, takenCount);
+    portENTER_CRITICAL(&outboxLock);
+  }
+
+  uint8_t* out = box->messages + box->length;
+  out[0] = type;
+  out[1] = (uint8_t)length;
+  memcpy(out + messageHeaderSize, payload, length);
+  box->length += messageHeaderSize + length;
+  box->count++;
+
+  takenCount = 0;
+  if (!deferrable) {
+    takenLength = box->length;
+    takenCount = box->count;
+    memcpy(taken, box->messages, takenLength);
+    box->length = 0;
+    box->count = 0;
+  }
+  portEXIT_CRITICAL(&outboxLock);
+
+  if (takenCount > 0) {
+    sent = transmit(mac, taken, takenLength, takenCount) && sent;
+  }
+  return sent;
+}
+
+// Runs the main loop handlers for every message in the inbox, oldest first
+void EspNowLink::service() {
+  InboxMessage message;
+  while (true) {
+    portENTER_CRITICAL(&inboxLock);
+    bool empty = inboxCount == 0;
+    if (!empty) {
+      message = inbox[inboxHead];
+      inboxHead = (inboxHead + 1) % inboxLength;
+      inboxCount--;
+    }
+    uint32_t dropped = droppedMessages;
+    portEXIT_CRITICAL(&inboxLock);
+
+    if (dropped != reportedDrops) {
+      LOG_WARN(LOG_CAT_RADIO, "Link inbox full: %u messages dropped", dropped - reportedDrops);
+      reportedDrops = dropped;
+    }
+    if (empty) {
+      return;
+    }
+
+    LinkFrameHandler handler = handlers[message.type];
+    if (handler != nullptr) {
+      handler(message.mac, message.payload, message.length);
+    }
+  }
+}
+
+// Called with outboxLock held. Outboxes are never removed, so a pointer stays valid.
+EspNowLink::Outbox* EspNowLink::findOutbox(const uint8_t* mac) {
+  for (int i = 0; i < numOutboxes; i++) {
+    if (memcmp(outboxes[i].mac, mac, sizeof(outboxes[i].mac)) == 0) {
+      return &outboxes[i];
+    }
+  }
+  if (numOutboxes >= maxOutboxes) {
+    return nullptr;
+  }
+
+  Outbox& box = outboxes[numOutboxes++];
+  memcpy(box.mac, mac, sizeof(box.mac));
+  box.count = 0;
+  box.length = 0;
+  return &box;
+}
+
+bool EspNowLink::transmit(const uint8_t* mac, const uint8_t* messages, size_t length,
+                          int count) {
+  uint8_t frame[ESP_NOW_MAX_DATA_LEN];
+  size_t frameLength;
+  frame[0] = magic;
+
+  if (count == 1) {
+    size_t payloadLength = messages[1];
+    frame[1] = messages[0];
+    memcpy(frame + headerSize, messages + messageHeaderSize, payloadLength);
+    frameLength = headerSize + payloadLength;
+  } else {
+    frame[1] = LINK_FRAME_BUNDLE;
+    frame[headerSize] = bundleVersion;
+    memcpy(frame + headerSize + 1, messages, length);
+    uint32_t crc = Crc::crc32(frame + headerSize, 1 + length);
+    memcpy(frame + headerSize + 1 + length, &crc, crcSize);
+    frameLength = headerSize + 1 + length + crcSize;
+  }
+  return esp_now_send(mac, frame, frameLength) == ESP_OK;
+}
+
+// Frames without the magic byte, of an unknown type or with no handler are dropped, and so is a
+// bundle of another version or with a bad CRC. The loop is woken once per frame that left
+// messages in the inbox.
+void HOT_CODE EspNowLink::onReceive(const uint8_t* mac, const uint8_t* data, int length) {
+  if (length < (int)headerSize || data[0] != magic) {
+    return;
+  }
+  if (data[1] != LINK_FRAME_BUNDLE) {
+    if (dispatch(mac, data[1], data + headerSize, length - headerSize)) {
+      EventQueue::post({EVENT_LINK_MESSAGE, esp_timer_get_time()});
+    }
+    return;
+  }
+
+  if (length < (int)(headerSize + 1 + crcSize) || data[headerSize] != bundleVersion) {
+    return;
+  }
+  size_t end = length - crcSize;
+  uint32_t crc;
+  memcpy(&crc, data + end, crcSize);
+  if (crc != Crc::crc32(data + headerSize, end - headerSize)) {
+    return;
+  }
+
+  bool held = false;
+  size_t pos = headerSize + 1;
+  while (pos + messageHeaderSize <= end) {
+    size_t messageLength = data[pos + 1];
+    if (pos + messageHeaderSize + messageLength > end) {
+      break;
+    }
+    held = dispatch(mac, data[pos], data + pos + messageHeaderSize, messageLength) || held;
+    pos += messageHeaderSize + messageLength;
+  }
+  if (held) {
+    EventQueue::post({EVENT_LINK_MESSAGE, esp_timer_get_time()});
+  }
+}
+
+// Runs a WiFi task handler now, or holds the message for service(). True when it was held.
+bool HOT_CODE EspNowLink::dispatch(const uint8_t* mac, uint8_t type, const uint8_t* payload,
+                                   size_t length) {
+  if (type >= LINK_FRAME_TYPE_COUNT || type == LINK_FRAME_BUNDLE || handlers[type] == nullptr) {
+    return false;
+  }
+  if (contexts[type] == LINK_HANDLER_WIFI_TASK) {
+    handlers[type](mac, payload, length);
+    return false;
+  }
+
+  portENTER_CRITICAL(&inboxLock);
+  bool held = inboxCount < inboxLength;
+  if (held) {
+    InboxMessage& message = inbox[(inboxHead + inboxCount) % inboxLength];
+    memcpy(message.mac, mac, sizeof(message.mac));
+    message.type = type;
+    message.length = (uint8_t)length;
+    memcpy(message.payload, payload, length);
+    inboxCount++;
+  } else {
+    droppedMessages++;
+  }
+  portEXIT_CRITICAL(&inboxLock);
+  return held;
+}
+
+void EspNowLink::onSent(const uint8_t* mac, esp_now_send_status_t status) {
+  if (sendStatusHandler != nullptr) {
+    sendStatusHandler(mac, status == ESP_NOW_SEND_SUCCESS);
+  }
+}
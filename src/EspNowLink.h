@@ -0,0 +1,140 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include <freertos/FreeRTOS.h>
+
+enum LinkFrameType : uint8_t {
+  LINK_FRAME_SUBMISSION = 1,
+  LINK_FRAME_PHASE = 2,
+  LINK_FRAME_TRANSMISSION = 3,
+  LINK_FRAME_PING = 4,
+  LINK_FRAME_PONG = 5,
+  LINK_FRAME_ORIENTATION = 6,   // see OrientationStream
+  LINK_FRAME_SCRIPT_OFFER = 7,  // see PhaseScriptTransfer
+  LINK_FRAME_SCRIPT_REQUEST = 8,
+  LINK_FRAME_SCRIPT_CHUNK = 9,
+  LINK_FRAME_BUNDLE = 10,   // several messages for one peer in one frame
+  LINK_FRAME_REJOIN = 11,   // a slave that resumed a session asks where it stands
+  LINK_FRAME_SESSION = 12,  // the master's answer
+  LINK_FRAME_TYPE_COUNT,
+};
+
+struct __attribute__((packed)) SubmissionFrame {
+    uint8_t deviceId;
+    uint8_t phase;
+    int16_t roll;
+    int16_t pitch;
+    int16_t yaw;
+    uint8_t success;
+};
+
+struct __attribute__((packed)) PhaseFrame {
+    uint8_t phase;
+};
+
+struct __attribute__((packed)) TransmissionFrame {
+    uint8_t success;
+};
+
+struct __attribute__((packed)) RejoinFrame {
+    uint8_t deviceId;
+};
+
+enum SessionStanding : uint8_t {
+  SESSION_BETWEEN_PHASES,
+  SESSION_PHASE_PLAYING,
+  SESSION_PHASE_SUBMITTED,  // the asking slave's match is in; it waits for the others
+  SESSION_TRANSMITTED,
+};
+
+struct __attribute__((packed)) SessionFrame {
+    uint8_t phase;
+    uint8_t standing;
+    uint32_t timeLeftMs;  // of a timed phase, counted on the master from when it went out
+};
+
+// Where a handler runs. A main loop handler may change any firmware state. A WiFi task handler
+// must only touch state of its own that it guards against the main loop.
+enum LinkHandlerContext : uint8_t {
+  LINK_HANDLER_MAIN_LOOP,  // held in the inbox until processEvents calls service()
+  LINK_HANDLER_WIFI_TASK,  // called straight from the receive callback
+};
+
+typedef void (*LinkFrameHandler)(const uint8_t* mac, const uint8_t* payload, size_t length);
+typedef void (*LinkSendStatusHandler)(const uint8_t* mac, bool delivered);
+
+// Carries all traffic between orientation modules as typed frames. ESP-NOW allows one receive
+// and one send callback, so begin() takes both over from EspNowHelper, which is then only used
+// to talk to the hub. Messages for main loop handlers wait in an inbox, and EVENT_LINK_MESSAGE
+// tells the loop to run them.
+//
+// Messages that can wait are held per peer for up to LINK_AGGREGATION_WINDOW_US and go out
+// together in one bundle frame: a version byte, then type, length and payload for each message,
+// then a CRC-32. A message sent at once takes whatever is held for its peer along with it. A
+// message that ends up alone goes out as a plain frame, exactly as before bundling.
+class EspNowLink {
+  public:
+    static void begin();
+    static void registerHandler(LinkFrameType type, LinkFrameHandler handler,
+                                LinkHandlerContext context = LINK_HANDLER_MAIN_LOOP);
+    static void registerSendStatusHandler(LinkSendStatusHandler handler);
+    static bool send(const uint8_t* mac, LinkFrameType type, const void* payload, size_t length);
+
+    // Main loop only. Holds the message to share a frame with others for the same peer.
+    static bool queue(const uint8_t* mac, LinkFrameType type, const void* payload, size_t length);
+    static void flush();  // on TIMER_LINK_FLUSH
+
+    static void service();  // on EVENT_LINK_MESSAGE
+
+  private:
+    static constexpr uint8_t magic = 0x7E;
+    static constexpr size_t headerSize = 2;  // magic, type
+    static constexpr uint8_t bundleVersion = 1;
+    static constexpr size_t messageHeaderSize = 2;  // type, length
+    static constexpr size_t crcSize = 4;
+    static constexpr size_t bundleCapacity = ESP_NOW_MAX_DATA_LEN - headerSize - 1 - crcSize;
+
+    struct Outbox {
+        uint8_t mac[6];
+        int count;
+        size_t length;  // of messages, each with its type and length
+        uint8_t messages[bundleCapacity];
+    };
+
+    static constexpr int maxOutboxes = 4;
+
+    struct InboxMessage {
+        uint8_t mac[6];
+        uint8_t type;
+        uint8_t length;
+        uint8_t payload[ESP_NOW_MAX_DATA_LEN - headerSize];
+    };
+
+    static constexpr int inboxLength = 8;
+
+    static LinkFrameHandler handlers[LINK_FRAME_TYPE_COUNT];
+    static LinkHandlerContext contexts[LINK_FRAME_TYPE_COUNT];
+    static LinkSendStatusHandler sendStatusHandler;
+
+    static Outbox outboxes[maxOutboxes];
+    static int numOutboxes;
+    static portMUX_TYPE outboxLock;
+    static bool flushScheduled;
+
+    static InboxMessage inbox[inboxLength];
+    static int inboxHead;
+    static int inboxCount;
+    static uint32_t droppedMessages;  // inbox full
+    static uint32_t reportedDrops;
+    static portMUX_TYPE inboxLock;
+
+    static bool enqueue(const uint8_t* mac, LinkFrameType type, const void* payload,
+                        size_t length, bool deferrable);
+    static Outbox* findOutbox(const uint8_t* mac);
+    static bool transmit(const uint8_t* mac, const uint8_t* messages, size_t length, int count);
+
+    static void onReceive(const uint8_t* mac, const uint8_t* data, int length);
+    static bool dispatch(const uint8_t* mac, uint8_t type, const uint8_t* payload, size_t length);
+    static void onSent(const uint8_t* mac, esp_now_send_status_t status);
+};
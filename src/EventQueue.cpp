@@ -0,0 +1,35 @@
+#include "EventQueue.h"
+
+#include "HotPath.h"
+
+QueueHandle_t EventQueue::queue = nullptr;
+StaticQueue_t EventQueue::queueControl;
+uint8_t EventQueue::queueStorage[queueLength * sizeof(Event)];
+
+void EventQueue::begin() {
+  if (queue == nullptr) {
+    queue = xQueueCreateStatic(queueLength, sizeof(Event), queueStorage, &queueControl);
+  }
+}
+
+bool EventQueue::post(const Event& event) {
+  return queue != nullptr && xQueueSend(queue, &event, 0) == pdTRUE;
+}
+
+bool IRAM_ATTR EventQueue::postFromISR(const Event& event) {
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  bool posted = xQueueSendFromISR(queue, &event, &higherPriorityTaskWoken) == pdTRUE;
+  if (higherPriorityTaskWoken) {
+    portYIELD_FROM_ISR();
+  }
+  return posted;
+}
+
+bool HOT_CODE EventQueue::poll(Event& event) {
+  return queue != nullptr && xQueueReceive(queue, &event, 0) == pdTRUE;
+}
+
+bool EventQueue::waitForEvent(TickType_t timeout) {
+  Event event;
+  return queue != nullptr && xQueuePeek(queue, &event, timeout) == pdTRUE;
+}
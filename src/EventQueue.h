@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+enum EventType : uint8_t {
+  EVENT_SUBMIT_PRESSED,
+  EVENT_RECALIBRATE_REQUESTED,
+  EVENT_WAKE,  // nothing to handle; only ends an idle wait early
+  EVENT_TIMER_EXPIRED,
+  EVENT_SCRIPT_FRAME,  // a phase script frame is waiting in PhaseScriptTransfer
+  EVENT_LINK_MESSAGE,  // received link messages are waiting in EspNowLink's inbox
+  EVENT_CHECKPOINT,    // a completed phase is waiting to be journaled to NVS
+  EVENT_LOAD_PHASE_PRESSED,
+  EVENT_TRANSMIT_PRESSED,
+};
+
+struct Event {
+    EventType type;
+    int64_t timestampUs;  // esp_timer time at which the event happened, not when it was queued
+    uint32_t value;       // event-specific; the packed timer and generation for EVENT_TIMER_EXPIRED
+};
+
+class EventQueue {
+  public:
+    static void begin();
+
+    static bool post(const Event& event);
+    static bool IRAM_ATTR postFromISR(const Event& event);
+    static bool poll(Event& event);
+
+    // Blocks until an event is queued or the timeout passes, leaving the event in the queue
+    static bool waitForEvent(TickType_t timeout);
+
+  private:
+    static constexpr UBaseType_t queueLength = 16;
+    static QueueHandle_t queue;
+    static StaticQueue_t queueControl;
+    static uint8_t queueStorage[queueLength * sizeof(Event)];
+};
@@ -0,0 +1,160 @@
+#include "GyroBiasModel.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#include "Crc.h"
+#include "HotPath.h"
+
+GyroBiasModel::GyroBiasModel(CalibrationStorage& storage)
+    : storage(storage), learned(), weight(), empty(true), dirty(false), base(), slope() {
+}
+
+bool GyroBiasModel::load() {
+  GyroBiasRecord record;
+  if (storage.read(&record, sizeof(record)) != sizeof(record) || record.magic != recordMagic ||
+      record.version != recordVersion || record.nodes != BIAS_MODEL_NODES ||
+      record.crc != checksum(record)) {
+    return false;
+  }
+
+  for (int node = 0; node < BIAS_MODEL_NODES; node++) {
+    for (int axis = 0; axis < 3; axis++) {
+      learned[node][axis] = record.bias[node][axis] / 1000.0f;
+    }
+    weight[node] = record.weight[node];
+  }
+  rebuild();
+  dirty = false;
+  return true;
+}
+
+bool GyroBiasModel::save() {
+  GyroBiasRecord record = {};
+  record.magic = recordMagic;
+  record.version = recordVersion;
+  record.nodes = BIAS_MODEL_NODES;
+  for (int node = 0; node < BIAS_MODEL_NODES; node++) {
+    for (int axis = 0; axis < 3; axis++) {
+      record.bias[node][axis] =
+          (int16_t)constrain(lroundf(learned[node][axis] * 1000.0f), -32768L, 32767L);
+    }
+    record.weight[node] = weight[node];
+  }
+  record.crc = checksum(record);
+
+  dirty = !storage.write(&record, sizeof(record));
+  return !dirty;
+}
+
+// A calibration that disagrees with the curve means the sensor has shifted as a whole, so every
+// learned node moves with it; afterwards lookup() at this temperature reads the calibration. Its
+// node then averages on from BIAS_MODEL_CALIBRATION_WEIGHT, so the windows that follow refine it
+// without one of them undoing it.
+void GyroBiasModel::calibrate(float temperatureC, const float bias[3]) {
+  float current[3];
+  lookup(temperatureC, current);
+  int calibrated = nearestNode(temperatureC);
+  for (int node = 0; node < BIAS_MODEL_NODES; node++) {
+    if (weight[node] == 0 && node != calibrated) {
+      continue;
+    }
+    // base is the curve itself, so an unlearned calibrated node starts on it
+    for (int axis = 0; axis < 3; axis++) {
+      learned[node][axis] = base[node][axis] + bias[axis] - current[axis];
+    }
+  }
+  weight[calibrated] = BIAS_MODEL_CALIBRATION_WEIGHT;
+  dirty = true;
+  rebuild();
+}
+
+// A running mean per node until it holds BIAS_MODEL_MAX_WEIGHT windows, then an exponential
+// one, so a sensor that ages is still followed
+void GyroBiasModel::observe(float temperatureC, const float bias[3], int observedWeight) {
+  int node = nearestNode(temperatureC);
+  int total = weight[node] + observedWeight;
+  if (total > BIAS_MODEL_MAX_WEIGHT) {
+    total = BIAS_MODEL_MAX_WEIGHT;
+  }
+
+  float share = (float)observedWeight / total;
+  share = share > 1.0f ? 1.0f : share;
+  for (int axis = 0; axis < 3; axis++) {
+    learned[node][axis] += share * (bias[axis] - learned[node][axis]);
+  }
+  weight[node] = total;
+  dirty = true;
+  rebuild();
+}
+
+// Clamped ternaries compile to conditional moves
+void HOT_CODE GyroBiasModel::lookup(float temperatureC, float bias[3]) const {
+  float x = (temperatureC - BIAS_MODEL_MIN_C) * (1.0f / BIAS_MODEL_STEP_C);
+  x = x < 0.0f ? 0.0f : x;
+  x = x > BIAS_MODEL_NODES - 1 ? BIAS_MODEL_NODES - 1 : x;
+  int node = (int)x;
+  float fraction = x - node;
+  bias[0] = base[node][0] + fraction * slope[node][0];
+  bias[1] = base[node][1] + fraction * slope[node][1];
+  bias[2] = base[node][2] + fraction * slope[node][2];
+}
+
+bool HOT_CODE GyroBiasModel::isEmpty() const {
+  return empty;
+}
+
+bool GyroBiasModel::covers(float temperatureC) const {
+  return weight[nearestNode(temperatureC)] > 0;
+}
+
+bool GyroBiasModel::isDirty() const {
+  return dirty;
+}
+
+int GyroBiasModel::getLearnedNodes() const {
+  int count = 0;
+  for (int node = 0; node < BIAS_MODEL_NODES; node++) {
+    count += weight[node] > 0;
+  }
+  return count;
+}
+
+int GyroBiasModel::nearestNode(float temperatureC) {
+  int node = (int)lroundf((temperatureC - BIAS_MODEL_MIN_C) / BIAS_MODEL_STEP_C);
+  return constrain(node, 0, BIAS_MODEL_NODES - 1);
+}
+
+uint32_t GyroBiasModel::checksum(const GyroBiasRecord& record) {
+  return Crc::crc32(&record, offsetof(GyroBiasRecord, crc));
+}
+
+// Unlearned nodes are interpolated between the nearest learned ones and held flat past the ends.
+// The last node's slope stays zero, so a lookup clamped onto it reads it exactly.
+void GyroBiasModel::rebuild() {
+  int previous = -1;
+  for (int node = 0; node < BIAS_MODEL_NODES; node++) {
+    if (weight[node] == 0) {
+      continue;
+    }
+    for (int fill = previous + 1; fill <= node; fill++) {
+      float t = previous < 0 ? 1.0f : (float)(fill - previous) / (node - previous);
+      for (int axis = 0; axis < 3; axis++) {
+        float from = previous < 0 ? learned[node][axis] : learned[previous][axis];
+        base[fill][axis] = from + t * (learned[node][axis] - from);
+      }
+    }
+    previous = node;
+  }
+  empty = previous < 0;
+  for (int fill = previous + 1; previous >= 0 && fill < BIAS_MODEL_NODES; fill++) {
+    memcpy(base[fill], learned[previous], sizeof(base[fill]));
+  }
+
+  for (int node = 0; node < BIAS_MODEL_NODES; node++) {
+    for (int axis = 0; axis < 3; axis++) {
+      slope[node][axis] = node + 1 < BIAS_MODEL_NODES ? base[node + 1][axis] - base[node][axis]
+                                                      : 0.0f;
+    }
+  }
+}
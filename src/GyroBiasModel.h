@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "CalibrationStore.h"
+#include "hardware_config.h"
+
+// Stored form: biases in milli-deg/s, plus how many still windows back each node
+struct GyroBiasRecord {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t nodes;
+    int16_t bias[BIAS_MODEL_NODES][3];
+    uint8_t weight[BIAS_MODEL_NODES];
+    uint32_t crc;  // over every field above
+};
+
+// Gyro bias against die temperature, learned over the life of the device. Nodes sit every
+// BIAS_MODEL_STEP_C; each averages the biases of the still windows the stillness detector finds
+// near its temperature mid-session. A calibration is taken as exact: it moves the whole curve onto
+// what it measured and restarts the average at its node. Nodes with nothing learned
+// are filled in from their neighbours, so lookup() is a clamp, one table read and a multiply-add
+// per axis, with no branches on the data.
+class GyroBiasModel {
+  public:
+    explicit GyroBiasModel(CalibrationStorage& storage);
+
+    bool load();
+    bool save();
+
+    void calibrate(float temperatureC, const float bias[3]);
+    void observe(float temperatureC, const float bias[3], int weight);
+    void lookup(float temperatureC, float bias[3]) const;
+
+    bool isEmpty() const;
+    bool covers(float temperatureC) const;  // learned at the node nearest this temperature
+    bool isDirty() const;
+    int getLearnedNodes() const;
+
+  private:
+    static constexpr uint16_t recordMagic = 0xB1A5;
+    static constexpr uint8_t recordVersion = 1;
+
+    CalibrationStorage& storage;
+    float learned[BIAS_MODEL_NODES][3];
+    uint8_t weight[BIAS_MODEL_NODES];
+    bool empty;
+    bool dirty;
+
+    // Rebuilt on every observe: the value at each node and the slope to the next
+    float base[BIAS_MODEL_NODES][3];
+    float slope[BIAS_MODEL_NODES][3];
+
+    static int nearestNode(float temperatureC);
+    static uint32_t checksum(const GyroBiasRecord& record);
+    void rebuild();
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <esp_attr.h>
+
+#include "hardware_config.h"
+
+// Placement for the per-sample path. With HOT_PATH_IN_IRAM, marked functions run from IRAM and
+// marked tables sit in DRAM, so neither waits on a flash cache miss. Without it they stay in
+// flash, which keeps the IRAM free for builds that need it elsewhere.
+#ifdef HOT_PATH_IN_IRAM
+#define HOT_CODE IRAM_ATTR
+#define HOT_DATA DRAM_ATTR
+#else
+#define HOT_CODE
+#define HOT_DATA
+#endif
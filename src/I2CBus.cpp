@@ -0,0 +1,73 @@
+#include "I2CBus.h"
+
+#include "Wire.h"
+#include "hardware_config.h"
+
+I2CFaultCounters I2CBus::counters = {};
+
+void I2CBus::begin() {
+  Wire.begin();
+  Wire.setTimeOut(I2C_TIMEOUT_MS);
+}
+
+bool I2CBus::probe(uint8_t address) {
+  Wire.beginTransmission(address);
+  return Wire.endTransmission() == 0;
+}
+
+bool I2CBus::recover() {
+  Wire.end();
+
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, OUTPUT_OPEN_DRAIN);
+  digitalWrite(SCL, HIGH);
+
+  // A slave interrupted mid-byte holds SDA low until it has clocked out its remaining bits
+  for (int pulse = 0; pulse < 9 && digitalRead(SDA) == LOW; pulse++) {
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(halfClockUs);
+    digitalWrite(SCL, HIGH);
+    delayMicroseconds(halfClockUs);
+  }
+
+  // STOP condition: SDA rises while SCL is high
+  pinMode(SDA, OUTPUT_OPEN_DRAIN);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(halfClockUs);
+  digitalWrite(SCL, HIGH);
+  delayMicroseconds(halfClockUs);
+  digitalWrite(SDA, HIGH);
+  delayMicroseconds(halfClockUs);
+
+  pinMode(SDA, INPUT_PULLUP);
+  bool released = digitalRead(SDA) == HIGH && digitalRead(SCL) == HIGH;
+
+  begin();
+  return released;
+}
+
+void I2CBus::recordFault(I2CDevice device) {
+  counters.deviceFaults[device]++;
+}
+
+void I2CBus::recordRecovery(bool succeeded, uint32_t elapsedUs) {
+  if (succeeded) {
+    counters.recoveries++;
+  } else {
+    counters.failedRecoveries++;
+  }
+  counters.lastRecoveryUs = elapsedUs;
+}
+
+const I2CFaultCounters& I2CBus::getFaultCounters() {
+  return counters;
+}
+
+void I2CBus::printFaultCounters() {
+  Serial.println("I2C fault counters:");
+  Serial.printf("  MPU6050 faults:     %u\n", counters.deviceFaults[I2C_DEVICE_MPU]);
+  Serial.printf("  OLED faults:        %u\n", counters.deviceFaults[I2C_DEVICE_OLED]);
+  Serial.printf("  Recoveries:         %u\n", counters.recoveries);
+  Serial.printf("  Failed recoveries:  %u\n", counters.failedRecoveries);
+  Serial.printf("  Last recovery time: %u us\n", counters.lastRecoveryUs);
+}
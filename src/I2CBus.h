@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+enum I2CDevice : uint8_t {
+  I2C_DEVICE_MPU,
+  I2C_DEVICE_OLED,
+  I2C_DEVICE_COUNT,
+};
+
+struct I2CFaultCounters {
+    uint32_t deviceFaults[I2C_DEVICE_COUNT];
+    uint32_t recoveries;
+    uint32_t failedRecoveries;
+    uint32_t lastRecoveryUs;
+};
+
+// Bounded-time fault handling for the shared I2C bus: short transaction timeouts, cheap address
+// probes, and recovery of a bus held low by a slave stuck mid-byte
+class I2CBus {
+  public:
+    static void begin();
+
+    // Address-only write; true when the device ACKs
+    static bool probe(uint8_t address);
+
+    // Clocks out a stuck SDA, issues a STOP and restarts the peripheral. Returns true when the
+    // bus lines are released afterwards.
+    static bool recover();
+
+    static void recordFault(I2CDevice device);
+    static void recordRecovery(bool succeeded, uint32_t elapsedUs);
+    static const I2CFaultCounters& getFaultCounters();
+    static void printFaultCounters();
+
+  private:
+    static constexpr int halfClockUs = 5;  // 100 kHz bit-banged clock
+    static I2CFaultCounters counters;
+};
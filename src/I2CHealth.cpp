@@ -0,0 +1,35 @@
+#include "I2CHealth.h"
+
+#include "I2CBus.h"
+#include "hardware_config.h"
+
+bool I2CHealth::check(const float reading[6], unsigned long nowMs) {
+  bool frozen = memcmp(reading, lastReading, sizeof(lastReading)) == 0;
+  memcpy(lastReading, reading, sizeof(lastReading));
+  frozenSamples = frozen ? frozenSamples + 1 : 0;
+
+  bool faulted = false;
+  if (frozenSamples >= I2C_FROZEN_SAMPLE_LIMIT) {
+    I2CBus::recordFault(I2C_DEVICE_MPU);
+    frozenSamples = 0;
+    faulted = true;
+  }
+
+  if (nowMs - checkTime >= I2C_HEALTH_CHECK_INTERVAL_MS) {
+    checkTime = nowMs;
+    if (!I2CBus::probe(MPU_I2C_ADDRESS)) {
+      I2CBus::recordFault(I2C_DEVICE_MPU);
+      faulted = true;
+    }
+    if (!I2CBus::probe(OLED_I2C_ADDRESS)) {
+      I2CBus::recordFault(I2C_DEVICE_OLED);
+      faulted = true;
+    }
+  }
+
+  return faulted && nowMs - recoveryTime >= I2C_RECOVERY_BACKOFF_MS;
+}
+
+void I2CHealth::noteRecovery(unsigned long nowMs) {
+  recoveryTime = nowMs;
+}
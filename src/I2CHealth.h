@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Decides when the shared I2C bus needs recovering. The sensor library never reports I2C errors,
+// so faults are found two ways: a failed read leaves the sample frozen at identical values, and
+// both devices are probed every I2C_HEALTH_CHECK_INTERVAL_MS. Recoveries are at least
+// I2C_RECOVERY_BACKOFF_MS apart, so a device that stays down cannot stall every loop pass.
+class I2CHealth {
+  public:
+    // Fed the MPU6050 reading (accel, then gyro) once per sample. True when the caller should
+    // recover the bus now; faults found are counted in I2CBus either way.
+    bool check(const float reading[6], unsigned long nowMs);
+    void noteRecovery(unsigned long nowMs);
+
+  private:
+    float lastReading[6] = {};
+    int frozenSamples = 0;
+    unsigned long checkTime = 0;
+    unsigned long recoveryTime = 0;
+};
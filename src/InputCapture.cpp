@@ -0,0 +1,60 @@
+#include "InputCapture.h"
+
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+
+#include "hardware_config.h"
+
+InputCapture::Channel InputCapture::channels[InputCapture::maxChannels];
+int InputCapture::numChannels = 0;
+
+bool InputCapture::attach(gpio_num_t pin, EventType type) {
+  if (numChannels >= maxChannels) {
+    return false;
+  }
+
+  Channel& channel = channels[numChannels++];
+  channel.pin = pin;
+  channel.type = type;
+  channel.lastEdgeUs = 0;
+
+  // Arduino's attachInterrupt installs the GPIO ISR service without ESP_INTR_FLAG_IRAM, which
+  // masks it while the flash cache is off for an NVS or trace write. Installed here with the flag,
+  // edges are still timestamped then. The service is installed once; the first caller's flags hold.
+  esp_err_t installed = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+  if (installed != ESP_OK && installed != ESP_ERR_INVALID_STATE) {
+    numChannels--;
+    return false;
+  }
+
+  pinMode(pin, INPUT_PULLUP);
+  gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+  if (gpio_isr_handler_add(pin, &InputCapture::onEdge, &channel) != ESP_OK) {
+    numChannels--;
+    return false;
+  }
+  gpio_intr_enable(pin);
+  return true;
+}
+
+// gpio_get_level() lives in flash, so the ISR reads the input register itself
+int IRAM_ATTR InputCapture::readLevel(gpio_num_t pin) {
+  if (pin < 32) {
+    return (REG_READ(GPIO_IN_REG) >> pin) & 1;
+  }
+  return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+}
+
+// A press is the first falling edge after the line has been quiet for the debounce window, so
+// contact bounce on both press and release is rejected without any deferred confirmation.
+void IRAM_ATTR InputCapture::onEdge(void* arg) {
+  Channel* channel = static_cast<Channel*>(arg);
+  int64_t now = esp_timer_get_time();
+  int64_t quietUs = now - channel->lastEdgeUs;
+  channel->lastEdgeUs = now;
+
+  if (readLevel(channel->pin) == 0 && quietUs >= BUTTON_DEBOUNCE_US) {
+    EventQueue::postFromISR({channel->type, now});
+  }
+}
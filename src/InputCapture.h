@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "EventQueue.h"
+
+// Timestamps button presses in the GPIO interrupt so handlers can judge the moment of the press
+// rather than the moment the event was processed. Buttons are active low. The interrupt and all
+// it calls sit in IRAM, so it keeps running while flash is being written.
+class InputCapture {
+  public:
+    static bool attach(gpio_num_t pin, EventType type);
+
+  private:
+    struct Channel {
+        gpio_num_t pin;
+        EventType type;
+        volatile int64_t lastEdgeUs;
+    };
+
+    static constexpr int maxChannels = 4;
+    static Channel channels[maxChannels];
+    static int numChannels;
+
+    static void IRAM_ATTR onEdge(void* arg);
+    static int IRAM_ATTR readLevel(gpio_num_t pin);
+};
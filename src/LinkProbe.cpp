@@ -0,0 +1,156 @@
+#include "LinkProbe.h"
+
+#include <esp_timer.h>
+
+#include "TimerWheel.h"
+
+LinkProbe::Peer LinkProbe::peers[maxPeers];
+int LinkProbe::numPeers = 0;
+int LinkProbe::nextPeer = 0;
+volatile bool LinkProbe::paused = false;
+
+void LinkProbe::begin() {
+  // Answered and timed on arrival, so the loop's latency never counts as link latency
+  EspNowLink::registerHandler(LINK_FRAME_PING, &onPing, LINK_HANDLER_WIFI_TASK);
+  EspNowLink::registerHandler(LINK_FRAME_PONG, &onPong, LINK_HANDLER_WIFI_TASK);
+  EspNowLink::registerSendStatusHandler(&onSendStatus);
+  TimerWheel::schedule(TIMER_LINK_PROBE, LINK_PROBE_INTERVAL_MS * 1000UL);
+}
+
+bool LinkProbe::addPeer(const char* name, const uint8_t* mac, bool answersPings) {
+  if (numPeers >= maxPeers) {
+    return false;
+  }
+
+  Peer& peer = peers[numPeers++];
+  peer.name = name;
+  memcpy(peer.mac, mac, sizeof(peer.mac));
+  peer.answersPings = answersPings;
+  peer.sequence = 0;
+  peer.sendStartUs = -1;
+  return true;
+}
+
+// A resumed probe waits a full interval, so it never lands on the heels of a submission
+void LinkProbe::setPaused(bool pause) {
+  if (pause) {
+    TimerWheel::cancel(TIMER_LINK_PROBE);
+  } else if (paused) {
+    TimerWheel::schedule(TIMER_LINK_PROBE, LINK_PROBE_INTERVAL_MS * 1000UL);
+  }
+  paused = pause;
+}
+
+void LinkProbe::probe() {
+  if (paused) {
+    return;
+  }
+  TimerWheel::schedule(TIMER_LINK_PROBE, LINK_PROBE_INTERVAL_MS * 1000UL);
+
+  for (int tries = 0; tries < numPeers; tries++) {
+    Peer& peer = peers[nextPeer];
+    nextPeer = (nextPeer + 1) % numPeers;
+    if (!peer.answersPings) {
+      continue;
+    }
+
+    PingFrame ping = {peer.sequence++, esp_timer_get_time()};
+    peer.stats.recordPingSent();
+    peer.sendStartUs = ping.sentUs;
+    EspNowLink::send(peer.mac, LINK_FRAME_PING, &ping, sizeof(ping));
+    return;
+  }
+}
+
+// Marks the start of a send so its delivery ack can be timed; used for traffic to peers that do
+// not answer pings
+void LinkProbe::noteSend(const uint8_t* mac, int64_t nowUs) {
+  Peer* peer = findPeer(mac);
+  if (peer != nullptr) {
+    peer->sendStartUs = nowUs;
+  }
+}
+
+uint32_t LinkProbe::getOneWayUs(const uint8_t* mac, uint32_t fallbackUs) {
+  Peer* peer = findPeer(mac);
+  if (peer == nullptr || !peer->stats.hasOneWayEstimate()) {
+    return fallbackUs;
+  }
+  return peer->stats.getOneWayEstimateUs();
+}
+
+void LinkProbe::printReport() {
+  Serial.println("Link report:");
+  for (int i = 0; i < numPeers; i++) {
+    const Peer& peer = peers[i];
+    const LinkStats& stats = peer.stats;
+
+    Serial.printf("  %s (%02x:%02x:%02x:%02x:%02x:%02x)\n", peer.name, peer.mac[0], peer.mac[1],
+                  peer.mac[2], peer.mac[3], peer.mac[4], peer.mac[5]);
+    if (peer.answersPings) {
+      Serial.printf("    pings %u, pongs %u, loss %.1f%%, one-way estimate %u us, drift %.1f ppm\n",
+                    stats.getPingsSent(), stats.getPongsReceived(), stats.getLossRate() * 100.0f,
+                    stats.getOneWayEstimateUs(), stats.getDriftPpm());
+      printHistogram("rtt", stats.getRoundTrip());
+      printHistogram("forward", stats.getForward());
+      printHistogram("reverse", stats.getReverse());
+    }
+    Serial.printf("    ack failures %.1f%%\n", stats.getAckFailureRate() * 100.0f);
+    printHistogram("ack", stats.getAck());
+  }
+}
+
+LinkProbe::Peer* LinkProbe::findPeer(const uint8_t* mac) {
+  for (int i = 0; i < numPeers; i++) {
+    if (memcmp(peers[i].mac, mac, sizeof(peers[i].mac)) == 0) {
+      return &peers[i];
+    }
+  }
+  return nullptr;
+}
+
+// Answered straight from the WiFi task; the turnaround is stamped into the pong so the sender
+// can take it out of the round trip
+void LinkProbe::onPing(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  int64_t receivedUs = esp_timer_get_time();
+  if (length != sizeof(PingFrame)) {
+    return;
+  }
+
+  PingFrame ping;
+  memcpy(&ping, payload, sizeof(ping));
+  PongFrame pong = {ping.sequence, ping.sentUs, receivedUs, esp_timer_get_time()};
+  EspNowLink::send(mac, LINK_FRAME_PONG, &pong, sizeof(pong));
+}
+
+void LinkProbe::onPong(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  int64_t receivedUs = esp_timer_get_time();
+  Peer* peer = findPeer(mac);
+  if (peer == nullptr || length != sizeof(PongFrame)) {
+    return;
+  }
+
+  PongFrame pong;
+  memcpy(&pong, payload, sizeof(pong));
+  peer->stats.recordExchange(pong.sentUs, pong.peerReceivedUs, pong.peerSentUs, receivedUs);
+}
+
+void LinkProbe::onSendStatus(const uint8_t* mac, bool delivered) {
+  int64_t nowUs = esp_timer_get_time();
+  Peer* peer = findPeer(mac);
+  if (peer == nullptr || peer->sendStartUs < 0) {
+    return;
+  }
+
+  peer->stats.recordAck((uint32_t)(nowUs - peer->sendStartUs), delivered);
+  peer->sendStartUs = -1;
+}
+
+void LinkProbe::printHistogram(const char* label, const LatencyHistogram& histogram) {
+  Serial.printf("    %-8s n=%u min=%u mean=%u max=%u us |", label, histogram.getCount(),
+                histogram.getMinUs(), histogram.getMeanUs(), histogram.getMaxUs());
+  for (int i = 0; i < LatencyHistogram::bucketCount; i++) {
+    Serial.printf(" %u", histogram.getBucket(i));
+  }
+  Serial.println();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "EspNowLink.h"
+#include "LinkStats.h"
+#include "hardware_config.h"
+
+// Pings the other modules in turn at a low rate and keeps latency histograms and loss per peer.
+// Peers that do not run this firmware (the hub) are never pinged; only the delivery acks of what
+// is already sent to them are timed. Probing pauses while a phase is being played.
+class LinkProbe {
+  public:
+    static void begin();
+    static bool addPeer(const char* name, const uint8_t* mac, bool answersPings);
+    static void setPaused(bool paused);
+    static void probe();  // on TIMER_LINK_PROBE
+    static void noteSend(const uint8_t* mac, int64_t nowUs);
+
+    static uint32_t getOneWayUs(const uint8_t* mac, uint32_t fallbackUs);
+    static void printReport();
+
+  private:
+    struct __attribute__((packed)) PingFrame {
+        uint32_t sequence;
+        int64_t sentUs;
+    };
+
+    struct __attribute__((packed)) PongFrame {
+        uint32_t sequence;
+        int64_t sentUs;
+        int64_t peerReceivedUs;
+        int64_t peerSentUs;
+    };
+
+    struct Peer {
+        const char* name;
+        uint8_t mac[6];
+        bool answersPings;
+        uint32_t sequence;
+        volatile int64_t sendStartUs;
+        LinkStats stats;
+    };
+
+    static constexpr int maxPeers = 4;
+
+    static Peer peers[maxPeers];
+    static int numPeers;
+    static int nextPeer;
+    static volatile bool paused;
+
+    static Peer* findPeer(const uint8_t* mac);
+    static void onPing(const uint8_t* mac, const uint8_t* payload, size_t length);
+    static void onPong(const uint8_t* mac, const uint8_t* payload, size_t length);
+    static void onSendStatus(const uint8_t* mac, bool delivered);
+    static void printHistogram(const char* label, const LatencyHistogram& histogram);
+};
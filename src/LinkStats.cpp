@@ -0,0 +1,183 @@
+#include "LinkStats.h"
+
+#include "hardware_config.h"
+
+void LatencyHistogram::add(uint32_t latencyUs) {
+  int index = 0;
+  while (index < bucketCount - 1 && latencyUs >= getBucketLimitUs(index)) {
+    index++;
+  }
+  buckets[index]++;
+
+  count++;
+  totalUs += latencyUs;
+  if (latencyUs < minUs) {
+    minUs = latencyUs;
+  }
+  if (latencyUs > maxUs) {
+    maxUs = latencyUs;
+  }
+}
+
+uint32_t LatencyHistogram::getCount() const {
+  return count;
+}
+
+uint32_t LatencyHistogram::getBucket(int index) const {
+  return buckets[index];
+}
+
+uint32_t LatencyHistogram::getBucketLimitUs(int index) const {
+  return index < bucketCount - 1 ? firstLimitUs << index : 0;
+}
+
+uint32_t LatencyHistogram::getMinUs() const {
+  return count > 0 ? minUs : 0;
+}
+
+uint32_t LatencyHistogram::getMaxUs() const {
+  return maxUs;
+}
+
+uint32_t LatencyHistogram::getMeanUs() const {
+  return count > 0 ? (uint32_t)(totalUs / count) : 0;
+}
+
+void LinkStats::recordPingSent() {
+  pingsSent++;
+}
+
+void LinkStats::recordExchange(int64_t sentUs, int64_t peerReceivedUs, int64_t peerSentUs,
+                               int64_t receivedUs) {
+  int64_t roundTripUs = (receivedUs - sentUs) - (peerSentUs - peerReceivedUs);
+  if (roundTripUs < 0) {
+    return;
+  }
+  pongsReceived++;
+  roundTrip.add((uint32_t)roundTripUs);
+
+  int64_t atUs = sentUs + (receivedUs - sentUs) / 2;
+  addOffset({atUs, roundTripUs, ((peerReceivedUs - sentUs) + (peerSentUs - receivedUs)) / 2});
+  int64_t clockOffsetUs = getClockOffsetUs(atUs);
+
+  int64_t forwardUs = (peerReceivedUs - sentUs) - clockOffsetUs;
+  int64_t reverseUs = (receivedUs - peerSentUs) + clockOffsetUs;
+  forward.add(forwardUs > 0 ? (uint32_t)forwardUs : 0);
+  reverse.add(reverseUs > 0 ? (uint32_t)reverseUs : 0);
+
+  float oneWayUs = forwardUs > 0 ? (float)forwardUs : 0.0f;
+  oneWayEstimateUs = pongsReceived == 1
+                         ? oneWayUs
+                         : oneWayEstimateUs + (oneWayUs - oneWayEstimateUs) * LINK_PROBE_GAIN;
+}
+
+// The drift is measured between the offsets chosen at least LINK_PROBE_DRIFT_SPAN_MS apart, so
+// the jitter of any one exchange is small against what the clocks drift over the span. However
+// late one direction is, an exchange is off the true offset by at most half its round trip; a
+// sample further off than that is a new clock.
+void LinkStats::addOffset(const OffsetSample& sample) {
+  int64_t expectedUs = getClockOffsetUs(sample.atUs);
+  int64_t jumpUs = sample.offsetUs > expectedUs ? sample.offsetUs - expectedUs
+                                                : expectedUs - sample.offsetUs;
+  if (offsetCount > 0 && jumpUs > sample.roundTripUs / 2 + LINK_PROBE_OFFSET_JUMP_US) {
+    offsetCount = 0;  // the peer restarted, and its clock with it
+    nextOffset = 0;
+    driftSpans = 0;
+    drift = 0.0f;
+  }
+
+  offsets[nextOffset] = sample;
+  nextOffset = (nextOffset + 1) % offsetWindow;
+  if (offsetCount < offsetWindow) {
+    offsetCount++;
+  }
+
+  const OffsetSample* fastest = &offsets[0];
+  for (int i = 1; i < offsetCount; i++) {
+    const OffsetSample& candidate = offsets[i];
+    if (candidate.roundTripUs < fastest->roundTripUs ||
+        (candidate.roundTripUs == fastest->roundTripUs && candidate.atUs > fastest->atUs)) {
+      fastest = &candidate;
+    }
+  }
+  chosen = *fastest;
+
+  if (offsetCount < offsetWindow) {
+    driftFrom = chosen;
+    return;
+  }
+  int64_t spanUs = chosen.atUs - driftFrom.atUs;
+  if (spanUs < LINK_PROBE_DRIFT_SPAN_MS * 1000LL) {
+    return;
+  }
+  float limit = LINK_PROBE_MAX_DRIFT_PPM * 1e-6f;
+  float measured = (float)(chosen.offsetUs - driftFrom.offsetUs) / (float)spanUs;
+  measured = measured > limit ? limit : (measured < -limit ? -limit : measured);
+  // A plain mean until the gain is the smaller weight, so no one early span dominates
+  driftSpans++;
+  float weight = 1.0f / driftSpans > LINK_PROBE_GAIN ? 1.0f / driftSpans : LINK_PROBE_GAIN;
+  drift += (measured - drift) * weight;
+  driftFrom = chosen;
+}
+
+void LinkStats::recordAck(uint32_t latencyUs, bool delivered) {
+  if (delivered) {
+    acksDelivered++;
+    ack.add(latencyUs);
+  } else {
+    acksFailed++;
+  }
+}
+
+uint32_t LinkStats::getPingsSent() const {
+  return pingsSent;
+}
+
+uint32_t LinkStats::getPongsReceived() const {
+  return pongsReceived;
+}
+
+float LinkStats::getLossRate() const {
+  if (pingsSent == 0) {
+    return 0.0f;
+  }
+  uint32_t answered = pongsReceived < pingsSent ? pongsReceived : pingsSent;
+  return 1.0f - (float)answered / pingsSent;
+}
+
+float LinkStats::getAckFailureRate() const {
+  uint32_t total = acksDelivered + acksFailed;
+  return total > 0 ? (float)acksFailed / total : 0.0f;
+}
+
+bool LinkStats::hasOneWayEstimate() const {
+  return pongsReceived > 0;
+}
+
+uint32_t LinkStats::getOneWayEstimateUs() const {
+  return (uint32_t)oneWayEstimateUs;
+}
+
+int64_t LinkStats::getClockOffsetUs(int64_t atUs) const {
+  return chosen.offsetUs + (int64_t)(drift * (float)(atUs - chosen.atUs));
+}
+
+float LinkStats::getDriftPpm() const {
+  return drift * 1e6f;
+}
+
+const LatencyHistogram& LinkStats::getRoundTrip() const {
+  return roundTrip;
+}
+
+const LatencyHistogram& LinkStats::getForward() const {
+  return forward;
+}
+
+const LatencyHistogram& LinkStats::getReverse() const {
+  return reverse;
+}
+
+const LatencyHistogram& LinkStats::getAck() const {
+  return ack;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "hardware_config.h"
+
+// Counts latencies into fixed power-of-two buckets: under 250 us, under 500 us, ... , and one
+// open-ended bucket past the last edge. The first edge can be moved for shorter spans.
+class LatencyHistogram {
+  public:
+    static constexpr int bucketCount = 10;
+
+    explicit LatencyHistogram(uint32_t firstLimitUs = 250) : firstLimitUs(firstLimitUs) {
+    }
+
+    void add(uint32_t latencyUs);
+    uint32_t getCount() const;
+    uint32_t getBucket(int index) const;
+    uint32_t getBucketLimitUs(int index) const;  // exclusive upper edge; 0 for the last bucket
+    uint32_t getMinUs() const;
+    uint32_t getMaxUs() const;
+    uint32_t getMeanUs() const;
+
+  private:
+    uint32_t firstLimitUs;
+    uint32_t buckets[bucketCount] = {};
+    uint32_t count = 0;
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+};
+
+// Round-trip, one-way and delivery statistics for one peer. Only plain arithmetic, so it runs the
+// same against a simulated link.
+//
+// The peers' clocks are not synchronised. The clock offset is taken from the fastest of the last
+// LINK_PROBE_OFFSET_WINDOW exchanges, where the two directions are assumed equal, and carried
+// forward at the drift measured between such offsets; each exchange is split into forward and
+// reverse delays against it, which shows asymmetric jitter. A fast exchange ages out of the
+// window rather than pinning an offset the crystals have since drifted away from.
+class LinkStats {
+  public:
+    void recordPingSent();
+    void recordExchange(int64_t sentUs, int64_t peerReceivedUs, int64_t peerSentUs,
+                        int64_t receivedUs);
+    void recordAck(uint32_t latencyUs, bool delivered);
+
+    uint32_t getPingsSent() const;
+    uint32_t getPongsReceived() const;
+    float getLossRate() const;
+    float getAckFailureRate() const;
+    bool hasOneWayEstimate() const;
+    uint32_t getOneWayEstimateUs() const;
+    int64_t getClockOffsetUs(int64_t atUs) const;  // peer clock minus ours, at our time atUs
+    float getDriftPpm() const;                      // how much faster the peer's clock runs
+
+    const LatencyHistogram& getRoundTrip() const;
+    const LatencyHistogram& getForward() const;
+    const LatencyHistogram& getReverse() const;
+    const LatencyHistogram& getAck() const;
+
+  private:
+    uint32_t pingsSent = 0;
+    uint32_t pongsReceived = 0;
+    uint32_t acksDelivered = 0;
+    uint32_t acksFailed = 0;
+
+    struct OffsetSample {
+        int64_t atUs;  // our clock, halfway through the exchange
+        int64_t roundTripUs;
+        int64_t offsetUs;
+    };
+
+    static constexpr int offsetWindow = LINK_PROBE_OFFSET_WINDOW;
+
+    OffsetSample offsets[offsetWindow] = {};
+    int offsetCount = 0;
+    int nextOffset = 0;
+    OffsetSample chosen = {};  // the window's fastest exchange
+    OffsetSample driftFrom = {};
+    uint32_t driftSpans = 0;
+    float drift = 0.0f;  // us per us
+    float oneWayEstimateUs = 0.0f;
+
+    LatencyHistogram roundTrip;
+    LatencyHistogram forward;
+    LatencyHistogram reverse;
+    LatencyHistogram ack;
+
+    void addOffset(const OffsetSample& sample);
+};
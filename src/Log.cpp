@@ -0,0 +1,167 @@
+#include "Log.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "DeadlineMonitor.h"
+
+Log::Slot Log::slots[capacity];
+std::atomic<uint32_t> Log::enqueuePosition(0);
+uint32_t Log::dequeuePosition = 0;
+std::atomic<uint32_t> Log::dropped(0);
+bool Log::started = false;
+StackType_t Log::drainStack[drainStackSize];
+StaticTask_t Log::drainTaskControl;
+
+void Log::begin() {
+  static_assert((capacity & (capacity - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+  for (uint32_t i = 0; i < capacity; i++) {
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  started = true;
+  xTaskCreateStaticPinnedToCore(&drainTask, "log", drainStackSize, nullptr, 0, drainStack,
+                                &drainTaskControl, 0);
+}
+
+Log::Slot* Log::claim(uint32_t& position) {
+  position = enqueuePosition.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot& slot = slots[position & (capacity - 1)];
+    int32_t lag = (int32_t)(slot.sequence.load(std::memory_order_acquire) - position);
+    if (lag == 0) {
+      if (enqueuePosition.compare_exchange_weak(position, position + 1,
+                                                std::memory_order_relaxed)) {
+        return &slot;
+      }
+    } else if (lag < 0) {
+      return nullptr;  // full; the oldest entry has not been drained yet
+    } else {
+      position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Runs at idle priority; it only gets the CPU when everything else is waiting
+void Log::drainTask(void* arg) {
+  int deadline = DeadlineMonitor::add("log", DEADLINE_LOG_MS);
+  for (;;) {
+    DeadlineMonitor::checkIn(deadline);
+    Slot& slot = slots[dequeuePosition & (capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+      uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+      if (lost > 0) {
+        Serial.printf("[log] %u messages dropped\n", lost);
+      }
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+      continue;
+    }
+
+#ifdef LOG_BINARY_OUTPUT
+    emitBinary(slot.entry);
+#else
+    emitText(slot.entry);
+#endif
+
+    slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+    dequeuePosition++;
+  }
+}
+
+// Walks the format and hands each conversion to snprintf with the argument's stored type
+void Log::emitText(const Entry& entry) {
+  char line[LOG_LINE_LENGTH];
+  size_t length = 0;
+  int arg = 0;
+
+  for (const char* p = entry.format; *p != '\0' && length < sizeof(line) - 2;) {
+    if (*p != '%') {
+      line[length++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      line[length++] = '%';
+      p += 2;
+      continue;
+    }
+
+    char spec[16];
+    size_t specLength = 0;
+    do {
+      spec[specLength++] = *p++;
+    } while (*p != '\0' && strchr("diouxXeEfFgGcsp", *p) == nullptr &&
+             specLength < sizeof(spec) - 2);
+    if (*p != '\0') {
+      spec[specLength++] = *p++;
+    }
+    spec[specLength] = '\0';
+
+    if (arg >= entry.count) {
+      break;
+    }
+
+    size_t room = sizeof(line) - 1 - length;
+    int written = 0;
+    switch (entry.types[arg]) {
+      case ARG_INT:
+        written = snprintf(line + length, room, spec, (int)entry.args[arg].i);
+        break;
+      case ARG_UINT:
+        written = snprintf(line + length, room, spec, (unsigned int)entry.args[arg].u);
+        break;
+      case ARG_INT64:
+        written = snprintf(line + length, room, spec, (long long)entry.args[arg].i);
+        break;
+      case ARG_UINT64:
+        written = snprintf(line + length, room, spec, (unsigned long long)entry.args[arg].u);
+        break;
+      case ARG_DOUBLE:
+        written = snprintf(line + length, room, spec, entry.args[arg].d);
+        break;
+      case ARG_STRING:
+        written = snprintf(line + length, room, spec, entry.args[arg].s);
+        break;
+    }
+    arg++;
+    if (written > 0) {
+      length += (size_t)written < room ? (size_t)written : room - 1;
+    }
+  }
+
+  line[length++] = '\n';
+  Serial.write((const uint8_t*)line, length);
+}
+
+// Frame: 0xA5 0x5A, level, category, count, format address, 32-bit timestamp, then per argument
+// its type byte and either 8 raw bytes or, for strings, a length byte and the characters
+void Log::emitBinary(const Entry& entry) {
+  uint8_t frame[16 + maxArgs * (2 + 255)];
+  size_t length = 0;
+
+  frame[length++] = 0xA5;
+  frame[length++] = 0x5A;
+  frame[length++] = entry.level;
+  frame[length++] = entry.category;
+  frame[length++] = entry.count;
+  uint32_t address = (uint32_t)(uintptr_t)entry.format;
+  memcpy(frame + length, &address, sizeof(address));
+  length += sizeof(address);
+  memcpy(frame + length, &entry.timestampUs, sizeof(entry.timestampUs));
+  length += sizeof(entry.timestampUs);
+
+  for (int i = 0; i < entry.count; i++) {
+    frame[length++] = entry.types[i];
+    if (entry.types[i] == ARG_STRING) {
+      const char* text = entry.args[i].s != nullptr ? entry.args[i].s : "";
+      size_t size = strnlen(text, 255);
+      frame[length++] = (uint8_t)size;
+      memcpy(frame + length, text, size);
+      length += size;
+    } else {
+      memcpy(frame + length, &entry.args[i], 8);
+      length += 8;
+    }
+  }
+
+  Serial.write(frame, length);
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#include <atomic>
+
+#include "hardware_config.h"
+
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#define LOG_CAT_STATE 0x01
+#define LOG_CAT_INPUT 0x02
+#define LOG_CAT_RADIO 0x04
+#define LOG_CAT_SENSOR 0x08
+#define LOG_CAT_POWER 0x10
+#define LOG_CAT_MEMORY 0x20
+#define LOG_CAT_ALL 0xFF
+
+// Calls below LOG_LEVEL or outside LOG_CATEGORIES compile to nothing, format string included.
+// The sizeof(printf(...)) is never evaluated; it only keeps the compiler's format checking.
+#define LOG_AT(level, category, format, ...)                                  \
+  do {                                                                        \
+    if ((level) <= LOG_LEVEL && ((category) & LOG_CATEGORIES) != 0) {         \
+      (void)sizeof(printf(format, ##__VA_ARGS__));                            \
+      Log::write((level), (category), format, ##__VA_ARGS__);                 \
+    }                                                                         \
+  } while (0)
+
+#define LOG_ERROR(category, format, ...) LOG_AT(LOG_LEVEL_ERROR, category, format, ##__VA_ARGS__)
+#define LOG_WARN(category, format, ...) LOG_AT(LOG_LEVEL_WARN, category, format, ##__VA_ARGS__)
+#define LOG_INFO(category, format, ...) LOG_AT(LOG_LEVEL_INFO, category, format, ##__VA_ARGS__)
+#define LOG_DEBUG(category, format, ...) LOG_AT(LOG_LEVEL_DEBUG, category, format, ##__VA_ARGS__)
+
+// Deferred logging. A call site stores the format string's address and its raw arguments in a
+// lock-free ring; a low-priority task formats and prints them, so neither loop() nor the radio
+// callbacks wait on the UART. Each call is one line. String arguments are stored as pointers and
+// must outlive the call (literals and other static strings).
+//
+// With LOG_BINARY_OUTPUT the task sends frames instead of text, decoded on the host by
+// tools/log_decode.py against the firmware ELF.
+class Log {
+  public:
+    static void begin();
+
+    template <typename... Args>
+    static void write(uint8_t level, uint8_t category, const char* format, Args... args) {
+      static_assert(sizeof...(Args) <= maxArgs, "too many log arguments");
+      if (!started) {
+        return;
+      }
+
+      uint32_t position;
+      Slot* slot = claim(position);
+      if (slot == nullptr) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      Entry& entry = slot->entry;
+      entry.format = format;
+      entry.timestampUs = (uint32_t)esp_timer_get_time();
+      entry.level = level;
+      entry.category = category;
+      entry.count = sizeof...(Args);
+      pack(entry, 0, args...);
+
+      slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+  private:
+    enum ArgType : uint8_t {
+      ARG_INT,
+      ARG_UINT,
+      ARG_INT64,
+      ARG_UINT64,
+      ARG_DOUBLE,
+      ARG_STRING,
+    };
+
+    static constexpr int maxArgs = 6;
+    static constexpr uint32_t capacity = LOG_RING_SIZE;  // a power of two
+
+    struct Entry {
+        const char* format;
+        uint32_t timestampUs;
+        uint8_t level;
+        uint8_t category;
+        uint8_t count;
+        ArgType types[maxArgs];
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+            const char* s;
+        } args[maxArgs];
+    };
+
+    // Bounded multi-producer queue: a slot is free for the producer whose claimed position
+    // matches its sequence, and readable once the sequence moves one past it
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        Entry entry;
+    };
+
+    static Slot slots[capacity];
+    static std::atomic<uint32_t> enqueuePosition;
+    static uint32_t dequeuePosition;
+    static std::atomic<uint32_t> dropped;
+    static bool started;
+
+    static constexpr uint32_t drainStackSize = 4096;
+    static StackType_t drainStack[drainStackSize];
+    static StaticTask_t drainTaskControl;
+
+    static Slot* claim(uint32_t& position);
+    static void drainTask(void* arg);
+    static void emitText(const Entry& entry);
+    static void emitBinary(const Entry& entry);
+
+    static void pack(Entry&, int) {
+    }
+
+    template <typename T, typename... Rest>
+    static void pack(Entry& entry, int index, T value, Rest... rest) {
+      set(entry, index, value);
+      pack(entry, index + 1, rest...);
+    }
+
+    static void set(Entry& e, int i, int v) {
+      e.types[i] = ARG_INT;
+      e.args[i].i = v;
+    }
+    static void set(Entry& e, int i, long v) {
+      e.types[i] = ARG_INT;
+      e.args[i].i = v;
+    }
+    static void set(Entry& e, int i, unsigned int v) {
+      e.types[i] = ARG_UINT;
+      e.args[i].u = v;
+    }
+    static void set(Entry& e, int i, unsigned long v) {
+      e.types[i] = ARG_UINT;
+      e.args[i].u = v;
+    }
+    static void set(Entry& e, int i, long long v) {
+      e.types[i] = ARG_INT64;
+      e.args[i].i = v;
+    }
+    static void set(Entry& e, int i, unsigned long long v) {
+      e.types[i] = ARG_UINT64;
+      e.args[i].u = v;
+    }
+    static void set(Entry& e, int i, double v) {
+      e.types[i] = ARG_DOUBLE;
+      e.args[i].d = v;
+    }
+    static void set(Entry& e, int i, const char* v) {
+      e.types[i] = ARG_STRING;
+      e.args[i].s = v;
+    }
+};
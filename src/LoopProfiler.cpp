@@ -0,0 +1,86 @@
+#include "LoopProfiler.h"
+
+#include "hardware_config.h"
+
+#if __has_include(<xtensa_perfmon_access.h>)
+#include <xtensa_perfmon_access.h>
+#include <xtensa_perfmon_masks.h>
+#define LOOP_PROFILER_PERFMON
+#endif
+
+static constexpr int missCounter = 0;
+
+LatencyHistogram LoopProfiler::passes(50);
+uint64_t LoopProfiler::totalCycles = 0;
+uint32_t LoopProfiler::maxCycles = 0;
+uint64_t LoopProfiler::totalMisses = 0;
+bool LoopProfiler::countingMisses = false;
+
+// Call from the loop task so the counter is set up on the core it runs on
+void LoopProfiler::begin() {
+#ifdef LOOP_PROFILER_PERFMON
+  countingMisses = xtensa_perfmon_init(missCounter, XTPERF_CNT_I_MEM,
+                                       XTPERF_MASK_I_MEM_CACHE_MISS, 0, -1) == ESP_OK;
+  if (countingMisses) {
+    xtensa_perfmon_reset(missCounter);
+    xtensa_perfmon_start();
+  }
+#endif
+}
+
+LoopProfiler::Scope::Scope() : startCycles(ESP.getCycleCount()), startMisses(readMisses()) {
+}
+
+LoopProfiler::Scope::~Scope() {
+  record(ESP.getCycleCount() - startCycles, readMisses() - startMisses);
+}
+
+uint32_t LoopProfiler::readMisses() {
+#ifdef LOOP_PROFILER_PERFMON
+  return countingMisses ? xtensa_perfmon_value(missCounter) : 0;
+#else
+  return 0;
+#endif
+}
+
+// Cycles are converted at the current clock, which the power manager changes between states
+void LoopProfiler::record(uint32_t cycles, uint32_t misses) {
+  passes.add(cycles / getCpuFrequencyMhz());
+  totalCycles += cycles;
+  if (cycles > maxCycles) {
+    maxCycles = cycles;
+  }
+  totalMisses += misses;
+}
+
+void LoopProfiler::printReport() {
+  uint32_t count = passes.getCount();
+#ifdef HOT_PATH_IN_IRAM
+  Serial.printf("Loop profile, hot path in IRAM: %u passes\n", count);
+#else
+  Serial.printf("Loop profile, hot path in flash: %u passes\n", count);
+#endif
+  if (count == 0) {
+    return;
+  }
+
+  Serial.printf("  min=%u mean=%u max=%u us, mean %u cycles, max %u cycles\n", passes.getMinUs(),
+                passes.getMeanUs(), passes.getMaxUs(), (uint32_t)(totalCycles / count),
+                maxCycles);
+  for (int i = 0; i < LatencyHistogram::bucketCount; i++) {
+    uint32_t limitUs = passes.getBucketLimitUs(i);
+    if (limitUs > 0) {
+      Serial.printf("  < %5u us  %u\n", limitUs, passes.getBucket(i));
+    } else {
+      Serial.printf("  rest        %u\n", passes.getBucket(i));
+    }
+  }
+  if (countingMisses) {
+    Serial.printf("  I-cache misses: %.1f per pass\n", (double)totalMisses / count);
+  }
+
+  passes = LatencyHistogram(50);
+  totalCycles = 0;
+  maxCycles = 0;
+  totalMisses = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "LinkStats.h"
+
+// Times each loop() pass with the CPU cycle counter, leaving out the idle wait, and where the
+// SDK provides the Xtensa performance monitor, counts instruction cache misses over the same
+// span. printReport() gives the distribution and labels it with the hot path placement, so
+// builds with HOT_PATH_IN_IRAM on and off can be compared directly. Only the loop task's core is
+// counted.
+class LoopProfiler {
+  public:
+    // Marks one pass from construction to the end of the enclosing scope
+    class Scope {
+      public:
+        Scope();
+        ~Scope();
+
+      private:
+        uint32_t startCycles;
+        uint32_t startMisses;
+    };
+
+    static void begin();
+    static void printReport();
+
+  private:
+    static LatencyHistogram passes;
+    static uint64_t totalCycles;
+    static uint32_t maxCycles;
+    static uint64_t totalMisses;
+    static bool countingMisses;
+
+    static uint32_t readMisses();
+    static void record(uint32_t cycles, uint32_t misses);
+};
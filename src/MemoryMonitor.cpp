@@ -0,0 +1,77 @@
+#include "MemoryMonitor.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+
+#include "Log.h"
+
+std::atomic<bool> MemoryMonitor::sealed(false);
+std::atomic<uint32_t> MemoryMonitor::bootAllocations(0);
+std::atomic<uint32_t> MemoryMonitor::bootBytes(0);
+std::atomic<uint32_t> MemoryMonitor::steadyAllocations(0);
+std::atomic<uint32_t> MemoryMonitor::lastSize(0);
+std::atomic<uintptr_t> MemoryMonitor::lastCaller(0);
+uint32_t MemoryMonitor::reportedAllocations = 0;
+
+void MemoryMonitor::seal() {
+  sealed.store(true, std::memory_order_release);
+
+  LOG_INFO(LOG_CAT_MEMORY, "Heap after boot: %u free, %u largest block, %u lowest free",
+           (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+           (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+           (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+  LOG_INFO(LOG_CAT_MEMORY, "IRAM left after code: %u bytes",
+           (unsigned)heap_caps_get_free_size(MALLOC_CAP_EXEC));
+#ifdef STATIC_MEMORY_MODE
+  LOG_INFO(LOG_CAT_MEMORY, "Boot allocations: %u (%u bytes); steady state must add none",
+           (unsigned)bootAllocations.load(), (unsigned)bootBytes.load());
+#endif
+}
+
+// Reports once per batch of new allocations, from the main loop where logging is safe
+void MemoryMonitor::poll() {
+  uint32_t allocations = steadyAllocations.load(std::memory_order_relaxed);
+  if (allocations == reportedAllocations) {
+    return;
+  }
+  reportedAllocations = allocations;
+  LOG_WARN(LOG_CAT_MEMORY, "✗ %u heap allocations after boot, last %u bytes from 0x%08x",
+           (unsigned)allocations, (unsigned)lastSize.load(), (unsigned)lastCaller.load());
+}
+
+// Runs inside malloc, possibly from an ISR: atomics only, no logging
+void MemoryMonitor::noteAllocation(size_t size, void* caller) {
+  if (!sealed.load(std::memory_order_acquire)) {
+    bootAllocations.fetch_add(1, std::memory_order_relaxed);
+    bootBytes.fetch_add(size, std::memory_order_relaxed);
+    return;
+  }
+  lastSize.store(size, std::memory_order_relaxed);
+  lastCaller.store((uintptr_t)caller, std::memory_order_relaxed);
+  steadyAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef STATIC_MEMORY_MODE
+// Linked with -Wl,--wrap for each, so every reference to malloc in the image, including those in
+// libraries and operator new, lands here first
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  MemoryMonitor::noteAllocation(size, __builtin_return_address(0));
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  MemoryMonitor::noteAllocation(count * size, __builtin_return_address(0));
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+  MemoryMonitor::noteAllocation(size, __builtin_return_address(0));
+  return __real_realloc(pointer, size);
+}
+}
+#endif
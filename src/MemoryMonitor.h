@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+// Heap accounting for the static-memory build. seal() marks the end of boot: it reports the
+// heap left after boot reservations, and from then on every malloc, calloc or realloc is counted
+// and flagged by poll() with its caller's address (decode with addr2line). The counting hook is
+// only linked in STATIC_MEMORY_MODE (see the static env in platformio.ini); without it seal()
+// still reports the heap.
+class MemoryMonitor {
+  public:
+    static void seal();
+    static void poll();
+
+    static void noteAllocation(size_t size, void* caller);
+
+  private:
+    static std::atomic<bool> sealed;
+    static std::atomic<uint32_t> bootAllocations;
+    static std::atomic<uint32_t> bootBytes;
+    static std::atomic<uint32_t> steadyAllocations;
+    static std::atomic<uint32_t> lastSize;
+    static std::atomic<uintptr_t> lastCaller;
+    static uint32_t reportedAllocations;
+};
@@ -1,5 +1,6 @@
 #include "OLEDController.h"
 
+#include "HotPath.h"
 #include "hardware_config.h"
 
 static const unsigned char PROGMEM image_arrow_left_bits[] = {0x20, 0x40, 0xfe, 0x40, 0x20};
@@ -69,7 +70,7 @@ static const unsigned char PROGMEM image_flag_stick_bits[] = {
     0x00, 0x80, 0x50, 0x00, 0x80, 0x50, 0x00, 0x80, 0x50, 0x00, 0x80, 0x50, 0x00, 0x80, 0x50, 0x00,
     0x80, 0x50, 0xe0, 0x80, 0x61, 0x11, 0x00, 0x66, 0x0e, 0x00, 0x58, 0x00, 0x00, 0x40, 0x00, 0x00};
 
-void OLEDController::renderBootScreen(Adafruit_SSD1306& oled, int countdownSeconds) {
+void OLEDController::renderBootScreen(Adafruit_SSD1306& oled) {
   oled.clearDisplay();
   oled.setTextSize(1);
   oled.setTextColor(WHITE);
@@ -94,10 +95,6 @@ void OLEDController::renderBootScreen(Adafruit_SSD1306& oled, int countdownSecon
   oled.print("SLAVE UNIT 2 v8.58");
 #endif
   oled.display();
-
-  for (int countdown = countdownSeconds; countdown > 0; --countdown) {
-    delay(1000);
-  }
 }
 
 void OLEDController::renderOrientationChrome(Adafruit_SSD1306& oled) {
@@ -128,25 +125,28 @@ void OLEDController::renderOrientationLayout(Adafruit_SSD1306& oled) {
   oled.display();
 }
 
-void OLEDController::renderOrientationValues(Adafruit_SSD1306& oled, int x, int y, int z,
-                                             bool doDisplay) {
+void HOT_CODE OLEDController::renderOrientationValues(Adafruit_SSD1306& oled, int x, int y,
+                                                      int z, bool doDisplay) {
   oled.setTextSize(2);
 
   oled.fillRect(63, 6, 35, 15, SSD1306_BLACK);
   oled.fillRect(63, 23, 35, 15, SSD1306_BLACK);
   oled.fillRect(64, 39, 35, 15, SSD1306_BLACK);
 
-  int rollWidth = String(x).length() * 12;
+  // Formatted on the stack; String temporaries here would hit the heap on every refresh
+  char text[12];
+
+  int rollWidth = snprintf(text, sizeof(text), "%d", x) * 12;
   oled.setCursor(100 - rollWidth, 6);
-  oled.print(String(x));
+  oled.print(text);
 
-  int pitchWidth = String(y).length() * 12;
+  int pitchWidth = snprintf(text, sizeof(text), "%d", y) * 12;
   oled.setCursor(100 - pitchWidth, 23);
-  oled.print(String(y));
+  oled.print(text);
 
-  int yawWidth = String(z).length() * 12;
+  int yawWidth = snprintf(text, sizeof(text), "%d", z) * 12;
   oled.setCursor(100 - yawWidth, 40);
-  oled.print(String(z));
+  oled.print(text);
 
   if (doDisplay) {
     oled.display();
@@ -235,10 +235,15 @@ void OLEDController::renderPhaseProgressIndicators(Adafruit_SSD1306& oled, int c
 }
 
 void OLEDController::renderPhaseLoading(Adafruit_SSD1306& oled, int currentPhase,
-                                        int countdownSeconds) {
+                                        int secondsLeft) {
   int phaseNumber = currentPhase + 1;
 
   oled.clearDisplay();
+  if (secondsLeft <= 0) {
+    oled.display();
+    return;
+  }
+
   oled.setTextSize(1);
 
   oled.setCursor(5, 6);
@@ -247,18 +252,9 @@ void OLEDController::renderPhaseLoading(Adafruit_SSD1306& oled, int currentPhase
   oled.setCursor(44, 18);
   oled.printf("PHASE %d", phaseNumber);
 
-  for (int countdown = countdownSeconds; countdown > 0; --countdown) {
-    oled.setTextSize(4);
-    oled.setCursor(54, 30);
-    oled.printf("%d", countdown);
-    oled.display();
-
-    delay(1000);
-
-    oled.fillRect(54, 30, 20, 32, BLACK);
-  }
-
-  oled.clearDisplay();
+  oled.setTextSize(4);
+  oled.setCursor(54, 30);
+  oled.printf("%d", secondsLeft);
   oled.display();
 }
 
@@ -275,6 +271,35 @@ void OLEDController::renderMasterWaitScreen(Adafruit_SSD1306& oled) {
   oled.display();
 }
 
+void OLEDController::renderPlayerStatus(Adafruit_SSD1306& oled, const PlayerStatus* players,
+                                        int count) {
+  oled.clearDisplay();
+  oled.setTextSize(1);
+
+  oled.setCursor(20, 6);
+  oled.print("AWAITING PLAYERS");
+
+  for (int i = 0; i < count; i++) {
+    const PlayerStatus& status = players[i];
+    int rowY = 22 + i * 12;
+
+    oled.setCursor(16, rowY);
+    oled.printf("PLAYER %d", status.player);
+
+    oled.setCursor(76, rowY);
+    if (status.submitted) {
+      oled.print("READY");
+    } else if (status.live) {
+      oled.printf("%5.1f", status.distance);
+      oled.drawCircle(110, rowY + 1, 1, SSD1306_WHITE);  // degree mark
+    } else {
+      oled.print("  ---");
+    }
+  }
+
+  oled.display();
+}
+
 void OLEDController::renderSlaveWaitScreen(Adafruit_SSD1306& oled) {
   oled.clearDisplay();
   oled.setTextSize(1);
@@ -288,7 +313,7 @@ void OLEDController::renderSlaveWaitScreen(Adafruit_SSD1306& oled) {
   oled.display();
 }
 
-void OLEDController::renderInvalidSubmissionScreen(Adafruit_SSD1306& oled, int countdownSeconds) {
+void OLEDController::renderInvalidSubmissionScreen(Adafruit_SSD1306& oled) {
   oled.clearDisplay();
   oled.setTextSize(1);
 
@@ -300,13 +325,9 @@ void OLEDController::renderInvalidSubmissionScreen(Adafruit_SSD1306& oled, int c
   oled.drawBitmap(59, 24, image_cross_contour_bits, 11, 16, SSD1306_WHITE);
 
   oled.display();
-
-  for (int countdown = countdownSeconds; countdown > 0; --countdown) {
-    delay(1000);
-  }
 }
 
-void OLEDController::renderTimeoutSubmissionScreen(Adafruit_SSD1306& oled, int countdownSeconds) {
+void OLEDController::renderTimeoutSubmissionScreen(Adafruit_SSD1306& oled) {
   oled.clearDisplay();
   oled.setTextSize(1);
 
@@ -317,8 +338,4 @@ void OLEDController::renderTimeoutSubmissionScreen(Adafruit_SSD1306& oled, int c
 
   oled.drawBitmap(57, 24, image_clock_alarm_bits, 15, 16, SSD1306_WHITE);
   oled.display();
-
-  for (int countdown = countdownSeconds; countdown > 0; --countdown) {
-    delay(1000);
-  }
 }
\ No newline at end of file
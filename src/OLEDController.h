@@ -2,9 +2,17 @@
 
 #include <Adafruit_SSD1306.h>
 
+// One row of the master's player status view
+struct PlayerStatus {
+    int player;      // 1-based, as printed
+    bool submitted;
+    bool live;       // streaming; distance is only meaningful when set
+    float distance;  // degrees from the phase target
+};
+
 class OLEDController {
   public:
-    static void renderBootScreen(Adafruit_SSD1306& oled, int countdownSeconds);
+    static void renderBootScreen(Adafruit_SSD1306& oled);
 
     static void renderOrientationLayout(Adafruit_SSD1306& oled);
     static void renderOrientationValues(Adafruit_SSD1306& oled, int x, int y, int z,
@@ -16,13 +24,15 @@ class OLEDController {
     static void renderTransmitComplete(Adafruit_SSD1306& oled);
 
     static void renderPhaseStaged(Adafruit_SSD1306& oled, int currentPhase, int totalPhases);
-    static void renderPhaseLoading(Adafruit_SSD1306& oled, int currentPhase, int countdownSeconds);
+    // One frame of the start countdown; zero seconds left blanks the display
+    static void renderPhaseLoading(Adafruit_SSD1306& oled, int currentPhase, int secondsLeft);
 
     static void renderMasterWaitScreen(Adafruit_SSD1306& oled);
+    static void renderPlayerStatus(Adafruit_SSD1306& oled, const PlayerStatus* players, int count);
     static void renderSlaveWaitScreen(Adafruit_SSD1306& oled);
 
-    static void renderInvalidSubmissionScreen(Adafruit_SSD1306& oled, int countdownSeconds);
-    static void renderTimeoutSubmissionScreen(Adafruit_SSD1306& oled, int countdownSeconds);
+    static void renderInvalidSubmissionScreen(Adafruit_SSD1306& oled);
+    static void renderTimeoutSubmissionScreen(Adafruit_SSD1306& oled);
 
   private:
     static void renderOrientationChrome(Adafruit_SSD1306& oled);
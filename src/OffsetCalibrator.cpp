@@ -0,0 +1,64 @@
+#include "OffsetCalibrator.h"
+
+void OffsetCalibrator::start(int64_t nowUs) {
+  running = true;
+  startUs = nowUs;
+  restartAccumulation();
+}
+
+bool OffsetCalibrator::isRunning() const {
+  return running;
+}
+
+void OffsetCalibrator::restartAccumulation() {
+  samples = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    gyroSum[axis] = 0.0f;
+    accSum[axis] = 0.0f;
+  }
+}
+
+RecalibrationResult OffsetCalibrator::addSample(const float rawGyro[3], const float rawAcc[3],
+                                                int64_t nowUs) {
+  if (!running) {
+    return RECALIBRATION_IDLE;
+  }
+
+  if (nowUs - startUs > (int64_t)RECALIBRATION_TIMEOUT_MS * 1000) {
+    running = false;
+    return RECALIBRATION_TIMED_OUT;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (samples > 0 &&
+        fabsf(rawGyro[axis] - gyroSum[axis] / samples) > RECALIBRATION_MAX_GYRO_DEVIATION_DPS) {
+      restartAccumulation();  // the device moved; offsets taken now would be wrong
+      break;
+    }
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    gyroSum[axis] += rawGyro[axis];
+    accSum[axis] += rawAcc[axis];
+  }
+  samples++;
+
+  if (samples < RECALIBRATION_SAMPLES) {
+    return RECALIBRATION_RUNNING;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    gyroOffsets[axis] = gyroSum[axis] / samples;
+    accOffsets[axis] = accSum[axis] / samples;
+  }
+  accOffsets[2] -= 1.0f;  // the Z axis reads gravity at rest
+  running = false;
+  return RECALIBRATION_DONE;
+}
+
+void OffsetCalibrator::getOffsets(float gyroOffsets[3], float accOffsets[3]) const {
+  for (int axis = 0; axis < 3; axis++) {
+    gyroOffsets[axis] = this->gyroOffsets[axis];
+    accOffsets[axis] = this->accOffsets[axis];
+  }
+}
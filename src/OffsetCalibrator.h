@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "hardware_config.h"
+
+enum RecalibrationResult : uint8_t {
+  RECALIBRATION_IDLE,
+  RECALIBRATION_RUNNING,
+  RECALIBRATION_DONE,
+  RECALIBRATION_TIMED_OUT,
+};
+
+// Gathers MPU6050 offsets one live sample at a time, the same way MPU6050::calcOffsets does in
+// one blocking burst. Movement restarts the accumulation; running past the timeout abandons it.
+class OffsetCalibrator {
+  public:
+    void start(int64_t nowUs);
+    bool isRunning() const;
+
+    // Raw readings are the library's values with the current offsets added back
+    RecalibrationResult addSample(const float rawGyro[3], const float rawAcc[3], int64_t nowUs);
+    void getOffsets(float gyroOffsets[3], float accOffsets[3]) const;
+
+  private:
+    bool running = false;
+    int64_t startUs = 0;
+    int samples = 0;
+    float gyroSum[3] = {};
+    float accSum[3] = {};
+    float gyroOffsets[3] = {};
+    float accOffsets[3] = {};
+
+    void restartAccumulation();
+};
@@ -0,0 +1,61 @@
+#include "OrientationHistory.h"
+
+#include "HotPath.h"
+
+void HOT_CODE OrientationHistory::push(const OrientationSample& sample) {
+  samples[head] = sample;
+  head = (head + 1) % capacity;
+  if (count < capacity) {
+    count++;
+  }
+}
+
+const OrientationSample& OrientationHistory::fromNewest(int age) const {
+  return samples[(head - 1 - age + capacity) % capacity];
+}
+
+const OrientationSample& HOT_CODE OrientationHistory::newest() const {
+  return fromNewest(0);
+}
+
+// Interpolates between the two samples bracketing the timestamp. Requests outside the recorded
+// span are clamped to the oldest or newest sample.
+bool HOT_CODE OrientationHistory::sampleAt(int64_t timestampUs, OrientationSample& out) const {
+  if (count == 0) {
+    return false;
+  }
+
+  const OrientationSample& newest = fromNewest(0);
+  if (timestampUs >= newest.timestampUs) {
+    out = newest;
+    return true;
+  }
+
+  for (int age = 1; age < count; age++) {
+    const OrientationSample& before = fromNewest(age);
+    if (before.timestampUs <= timestampUs) {
+      const OrientationSample& after = fromNewest(age - 1);
+      float t = (float)(timestampUs - before.timestampUs) /
+                (float)(after.timestampUs - before.timestampUs);
+      out.timestampUs = timestampUs;
+      out.x = lerpAngle(before.x, after.x, t);
+      out.y = lerpAngle(before.y, after.y, t);
+      out.z = lerpAngle(before.z, after.z, t);
+      return true;
+    }
+  }
+
+  out = fromNewest(count - 1);
+  return true;
+}
+
+// Interpolates along the shorter arc so samples either side of the +/-180 wrap stay close
+float HOT_CODE OrientationHistory::lerpAngle(float a, float b, float t) {
+  float delta = b - a;
+  if (delta > 180.0f) {
+    delta -= 360.0f;
+  } else if (delta < -180.0f) {
+    delta += 360.0f;
+  }
+  return a + delta * t;
+}
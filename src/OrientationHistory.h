@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "hardware_config.h"
+
+struct OrientationSample {
+    int64_t timestampUs;
+    float x;
+    float y;
+    float z;
+};
+
+// Fixed-size ring of recent orientation samples, indexed by time
+class OrientationHistory {
+  public:
+    void push(const OrientationSample& sample);
+    bool sampleAt(int64_t timestampUs, OrientationSample& out) const;
+    const OrientationSample& newest() const;
+
+  private:
+    static constexpr int capacity = ORIENTATION_HISTORY_SIZE;
+
+    OrientationSample samples[capacity] = {};
+    int head = 0;  // index of the next slot to write
+    int count = 0;
+
+    const OrientationSample& fromNewest(int age) const;
+    static float lerpAngle(float a, float b, float t);
+};
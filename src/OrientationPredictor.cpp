@@ -0,0 +1,106 @@
+#include "OrientationPredictor.h"
+
+#include "HotPath.h"
+#include "Log.h"
+
+OrientationPredictor::OrientationPredictor() {
+  latencyUs[LATENCY_PATH_DISPLAY] = PREDICTION_DISPLAY_LATENCY_PRIOR_US;
+  latencyUs[LATENCY_PATH_RADIO] = PREDICTION_RADIO_LATENCY_PRIOR_US;
+}
+
+void HOT_CODE OrientationPredictor::update(const OrientationSample& sample, float rateX,
+                                           float rateY, float rateZ) {
+  previous = hasSample ? newest : sample;
+  newest = sample;
+  rates[0] = rateX;
+  rates[1] = rateY;
+  rates[2] = rateZ;
+  hasSample = true;
+
+  if (scoring && newest.timestampUs >= scoredPrediction.timestampUs) {
+    scorePrediction();
+  }
+}
+
+// The horizon is capped: past a few tens of milliseconds the player's next move matters more
+// than the current rate
+OrientationSample HOT_CODE OrientationPredictor::predict(int64_t timestampUs) const {
+  int64_t horizonUs = timestampUs - newest.timestampUs;
+  if (horizonUs < 0) {
+    horizonUs = 0;
+  } else if (horizonUs > PREDICTION_MAX_HORIZON_US) {
+    horizonUs = PREDICTION_MAX_HORIZON_US;
+  }
+
+  float seconds = horizonUs / 1000000.0f;
+  return {timestampUs, newest.x + rates[0] * seconds, newest.y + rates[1] * seconds,
+          newest.z + rates[2] * seconds};
+}
+
+OrientationSample HOT_CODE OrientationPredictor::predictAhead(LatencyPath path) {
+  OrientationSample predicted = predict(newest.timestampUs + (int64_t)latencyUs[path]);
+
+  if (path == LATENCY_PATH_DISPLAY && hasSample && !scoring) {
+    scoredPrediction = predicted;
+    scoredBaseline = newest;
+    scoring = true;
+  }
+  return predicted;
+}
+
+void HOT_CODE OrientationPredictor::observeLatency(LatencyPath path, uint32_t measuredUs) {
+  latencyUs[path] += (measuredUs - latencyUs[path]) * PREDICTION_LATENCY_GAIN;
+}
+
+uint32_t OrientationPredictor::getLatency(LatencyPath path) const {
+  return (uint32_t)latencyUs[path];
+}
+
+void OrientationPredictor::resetError() {
+  scoring = false;
+  errorCount = 0;
+  errorSum = 0.0f;
+  errorMax = 0.0f;
+  baselineErrorSum = 0.0f;
+}
+
+void OrientationPredictor::printError() const {
+  if (errorCount == 0) {
+    return;
+  }
+  LOG_INFO(LOG_CAT_SENSOR,
+           "Prediction error: avg %.2f deg, max %.2f deg (unpredicted %.2f deg) over %u frames, "
+           "display latency %u us, radio latency %u us",
+           errorSum / errorCount, errorMax, baselineErrorSum / errorCount, errorCount,
+           getLatency(LATENCY_PATH_DISPLAY), getLatency(LATENCY_PATH_RADIO));
+}
+
+// The actual orientation at the predicted time is interpolated from the samples either side of
+// it. The sample the prediction started from is scored the same way, as the no-prediction case.
+void HOT_CODE OrientationPredictor::scorePrediction() {
+  scoring = false;
+
+  int64_t spanUs = newest.timestampUs - previous.timestampUs;
+  float t = spanUs > 0 ? (float)(scoredPrediction.timestampUs - previous.timestampUs) / spanUs
+                       : 1.0f;
+  OrientationSample actual = {scoredPrediction.timestampUs,
+                              previous.x + (newest.x - previous.x) * t,
+                              previous.y + (newest.y - previous.y) * t,
+                              previous.z + (newest.z - previous.z) * t};
+
+  float error = angleError(scoredPrediction, actual);
+  errorSum += error;
+  baselineErrorSum += angleError(scoredBaseline, actual);
+  if (error > errorMax) {
+    errorMax = error;
+  }
+  errorCount++;
+}
+
+float HOT_CODE OrientationPredictor::angleError(const OrientationSample& a,
+                                                const OrientationSample& b) {
+  float dx = a.x - b.x;
+  float dy = a.y - b.y;
+  float dz = a.z - b.z;
+  return sqrtf(dx * dx + dy * dy + dz * dz);
+}
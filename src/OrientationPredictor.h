@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "OrientationHistory.h"
+#include "hardware_config.h"
+
+enum LatencyPath : uint8_t {
+  LATENCY_PATH_DISPLAY,  // sample to the end of the OLED flush
+  LATENCY_PATH_RADIO,    // sample to arrival at the peer
+  LATENCY_PATH_COUNT,
+};
+
+// Extrapolates the newest sample along the current gyro rates to the time a reading is expected
+// to reach the player. Each output path keeps its own latency estimate, refined from
+// measurements. Every display prediction is scored against the sample that later arrives for
+// the same time.
+class OrientationPredictor {
+  public:
+    OrientationPredictor();
+
+    void update(const OrientationSample& sample, float rateX, float rateY, float rateZ);
+    OrientationSample predict(int64_t timestampUs) const;
+    OrientationSample predictAhead(LatencyPath path);
+
+    void observeLatency(LatencyPath path, uint32_t latencyUs);
+    uint32_t getLatency(LatencyPath path) const;
+
+    void resetError();
+    void printError() const;
+
+  private:
+    OrientationSample newest = {};
+    OrientationSample previous = {};
+    float rates[3] = {};
+    bool hasSample = false;
+
+    float latencyUs[LATENCY_PATH_COUNT];
+
+    bool scoring = false;
+    OrientationSample scoredPrediction = {};
+    OrientationSample scoredBaseline = {};
+    uint32_t errorCount = 0;
+    float errorSum = 0.0f;
+    float errorMax = 0.0f;
+    float baselineErrorSum = 0.0f;
+
+    void scorePrediction();
+    static float angleError(const OrientationSample& a, const OrientationSample& b);
+};
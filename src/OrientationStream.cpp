@@ -0,0 +1,133 @@
+#include "OrientationStream.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr uint8_t keyframeFlag = 0x80;
+
+// 802.11b at the default ESP-NOW rate of 1 Mbps: long preamble, MAC header and vendor element
+// around the payload, then SIFS, the ack and DIFS
+static constexpr uint32_t preambleUs = 192;
+static constexpr uint32_t overheadBytes = 43;
+static constexpr uint32_t linkHeaderBytes = 2;
+static constexpr uint32_t usPerByte = 8;
+static constexpr uint32_t ackUs = 10 + 304 + 50;
+
+// Every player but the master streams, and they split one budget between them
+static constexpr uint32_t streamingPlayers = NUM_PLAYERS > 1 ? NUM_PLAYERS - 1 : 1;
+static constexpr uint32_t shareUs = ORIENTATION_STREAM_AIRTIME_US / streamingPlayers;
+static constexpr uint32_t burstUs = shareUs / 4;
+
+uint32_t AirtimeBudget::frameAirtimeUs(size_t payloadBytes) {
+  return preambleUs + (overheadBytes + linkHeaderBytes + payloadBytes) * usPerByte + ackUs;
+}
+
+bool AirtimeBudget::spend(int64_t nowUs, uint32_t costUs) {
+  if (lastUs < 0) {
+    tokensUs = burstUs;
+  } else {
+    uint64_t earnedUs = (uint64_t)(nowUs - lastUs) * shareUs / 1000000;
+    tokensUs = earnedUs >= burstUs - tokensUs ? burstUs : tokensUs + (uint32_t)earnedUs;
+  }
+  lastUs = nowUs;
+
+  if (tokensUs < costUs) {
+    return false;
+  }
+  tokensUs -= costUs;
+  return true;
+}
+
+static int16_t quantize(float degrees) {
+  float quanta = roundf(degrees / ORIENTATION_STREAM_QUANTUM_DEG);
+  return quanta > INT16_MAX ? INT16_MAX : (quanta < INT16_MIN ? INT16_MIN : (int16_t)quanta);
+}
+
+size_t OrientationStreamEncoder::encode(const OrientationSample& sample, uint8_t* out) {
+  const int16_t quantized[3] = {quantize(sample.x), quantize(sample.y), quantize(sample.z)};
+
+  bool keyframe = !hasKey || sample.timestampUs - keyUs >= ORIENTATION_STREAM_KEYFRAME_MS * 1000LL;
+  bool changed = false;
+  for (int i = 0; i < 3; i++) {
+    keyframe = keyframe || abs(quantized[i] - key[i]) > INT8_MAX;
+    changed = changed || abs(quantized[i] - sent[i]) * ORIENTATION_STREAM_QUANTUM_DEG >=
+                             ORIENTATION_STREAM_THRESHOLD_DEG;
+  }
+  if (!keyframe && !changed) {
+    return 0;
+  }
+
+  size_t length = keyframe ? 1 + 3 * sizeof(int16_t) : 1 + 3;
+  uint32_t costUs = AirtimeBudget::frameAirtimeUs(length);
+  if (!budget.spend(sample.timestampUs, costUs)) {
+    return 0;  // the change is still pending and goes out once the budget allows
+  }
+
+  if (keyframe) {
+    keySequence = (keySequence + 1) & ~keyframeFlag;
+    keyUs = sample.timestampUs;
+    hasKey = true;
+    memcpy(key, quantized, sizeof(key));
+    out[0] = keySequence | keyframeFlag;
+    memcpy(out + 1, quantized, 3 * sizeof(int16_t));
+  } else {
+    out[0] = keySequence;
+    for (int i = 0; i < 3; i++) {
+      out[1 + i] = (uint8_t)(int8_t)(quantized[i] - key[i]);
+    }
+  }
+  memcpy(sent, quantized, sizeof(sent));
+
+  framesSent++;
+  bytesSent += length;
+  airtimeUs += costUs;
+  return length;
+}
+
+void OrientationStreamEncoder::reset() {
+  *this = OrientationStreamEncoder();
+}
+
+uint32_t OrientationStreamEncoder::getFramesSent() const {
+  return framesSent;
+}
+
+uint32_t OrientationStreamEncoder::getBytesSent() const {
+  return bytesSent;
+}
+
+uint32_t OrientationStreamEncoder::getAirtimeUs() const {
+  return airtimeUs;
+}
+
+bool StreamedOrientation::apply(const uint8_t* frame, size_t length, int64_t nowUs) {
+  if (length == 1 + 3 * sizeof(int16_t) && (frame[0] & keyframeFlag) != 0) {
+    keySequence = frame[0] & ~keyframeFlag;
+    hasKey = true;
+    memcpy(key, frame + 1, sizeof(key));
+    memcpy(value, key, sizeof(value));
+  } else if (length == 1 + 3 && (frame[0] & keyframeFlag) == 0) {
+    if (!hasKey || frame[0] != keySequence) {
+      return false;
+    }
+    for (int i = 0; i < 3; i++) {
+      value[i] = key[i] + (int8_t)frame[1 + i];
+    }
+  } else {
+    return false;
+  }
+
+  receivedUs = nowUs;
+  return true;
+}
+
+bool StreamedOrientation::isLive(int64_t nowUs) const {
+  return hasKey && nowUs - receivedUs < 2 * ORIENTATION_STREAM_KEYFRAME_MS * 1000LL;
+}
+
+void StreamedOrientation::get(float& x, float& y, float& z) const {
+  x = value[0] * ORIENTATION_STREAM_QUANTUM_DEG;
+  y = value[1] * ORIENTATION_STREAM_QUANTUM_DEG;
+  z = value[2] * ORIENTATION_STREAM_QUANTUM_DEG;
+}
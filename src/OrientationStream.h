@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "OrientationHistory.h"
+#include "hardware_config.h"
+
+// Live orientation from a player's module to the master, as small frames on the link. Angles are
+// quantized to ORIENTATION_STREAM_QUANTUM_DEG. A keyframe carries absolute values. A delta carries
+// one signed byte per axis relative to the last keyframe, so losing a delta costs nothing and
+// losing a keyframe only drops the deltas that follow it. The first byte of both is the keyframe
+// sequence, with the top bit set on keyframes.
+//
+// Frames are only sent when an axis has moved by ORIENTATION_STREAM_THRESHOLD_DEG, plus a
+// keyframe every ORIENTATION_STREAM_KEYFRAME_MS as a heartbeat. The streaming players share
+// ORIENTATION_STREAM_AIRTIME_US and each keeps to its share, so adding players does not add load
+// to the channel; each one's stream just gets coarser.
+// No radio dependencies; both ends run the same on a host.
+
+// Token bucket over estimated on-air time, refilled at this player's share of the stream budget
+class AirtimeBudget {
+  public:
+    bool spend(int64_t nowUs, uint32_t airtimeUs);
+
+    // On-air time of one link frame with the given payload, including the ack
+    static uint32_t frameAirtimeUs(size_t payloadBytes);
+
+  private:
+    int64_t lastUs = -1;
+    uint32_t tokensUs = 0;
+};
+
+class OrientationStreamEncoder {
+  public:
+    static constexpr size_t maxFrameSize = 7;
+
+    // Returns the frame length written to out, or 0 when nothing is due
+    size_t encode(const OrientationSample& sample, uint8_t* out);
+    void reset();
+
+    uint32_t getFramesSent() const;
+    uint32_t getBytesSent() const;
+    uint32_t getAirtimeUs() const;
+
+  private:
+    AirtimeBudget budget;
+    bool hasKey = false;
+    uint8_t keySequence = 0;
+    int64_t keyUs = 0;
+    int16_t key[3] = {};
+    int16_t sent[3] = {};
+
+    uint32_t framesSent = 0;
+    uint32_t bytesSent = 0;
+    uint32_t airtimeUs = 0;
+};
+
+// The master's view of one player's stream
+class StreamedOrientation {
+  public:
+    // False if the frame was malformed or its keyframe was missed
+    bool apply(const uint8_t* frame, size_t length, int64_t receivedUs);
+    bool isLive(int64_t nowUs) const;  // heard from within two keyframe intervals
+    void get(float& x, float& y, float& z) const;
+
+  private:
+    bool hasKey = false;
+    uint8_t keySequence = 0;
+    int16_t key[3] = {};
+    int16_t value[3] = {};
+    int64_t receivedUs = 0;
+};
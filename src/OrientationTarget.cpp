@@ -0,0 +1,99 @@
+#include "OrientationTarget.h"
+
+#include <math.h>
+
+#include "HotPath.h"
+
+// Sine in 1 degree steps over a quarter wave, filled once before setup() runs, so a pose costs a
+// few multiply-adds instead of six trig calls
+static const int SINE_TABLE_STEPS = 90;
+static float HOT_DATA sineTable[SINE_TABLE_STEPS + 1];
+
+static bool fillSineTable() {
+  for (int i = 0; i <= SINE_TABLE_STEPS; i++) {
+    sineTable[i] = sinf(ctmath::radians(i));
+  }
+  return true;
+}
+
+static bool sineTableFilled = fillSineTable();
+
+static float HOT_CODE wrapDegrees(float degrees) {
+  return degrees - 360.0f * floorf((degrees + 180.0f) / 360.0f);
+}
+
+// Sine and cosine of half of an angle in degrees. The whole degrees come from the table and the
+// rest is added by the angle-sum identities, with short series that are exact to float precision
+// for under a degree. Interpolating instead would shrink the quaternion and with it the cones.
+static void HOT_CODE halfSinCos(float degrees, float& s, float& c) {
+  float half = wrapDegrees(degrees) / 2;  // within 90 degrees
+  float magnitude = fabsf(half);
+  int step = (int)magnitude;
+  float d = ctmath::radians(magnitude - step);
+  float sd = d - d * d * d / 6.0f;
+  float cd = 1.0f - d * d / 2.0f;
+  float si = sineTable[step];
+  float ci = sineTable[SINE_TABLE_STEPS - step];
+  s = copysignf(si * cd + ci * sd, half);
+  c = ci * cd - si * sd;
+}
+
+OrientationPose HOT_CODE OrientationPose::fromEuler(float roll, float pitch, float yaw) {
+  float sr, cr, sp, cp, sy, cy;
+  halfSinCos(roll, sr, cr);
+  halfSinCos(pitch, sp, cp);
+  halfSinCos(yaw, sy, cy);
+  return {roll, pitch, yaw, ctmath::fromHalfAngles(sr, cr, sp, cp, sy, cy)};
+}
+
+// World "down" seen from the body frame. Yaw is the outermost rotation, so this is independent
+// of heading, which is what makes it a tilt-only comparison.
+static void HOT_CODE gravityInBody(const Quaternion& q, float& gx, float& gy, float& gz) {
+  gx = 2.0f * (q.x * q.z - q.w * q.y);
+  gy = 2.0f * (q.y * q.z + q.w * q.x);
+  gz = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+}
+
+bool HOT_CODE OrientationTarget::matches(const OrientationPose& pose) const {
+  switch (shape) {
+    case TOLERANCE_CONE: {
+      // q and -q are the same rotation, so compare |dot| against cos(tolerance / 2)
+      float dot = q.w * pose.q.w + q.x * pose.q.x + q.y * pose.q.y + q.z * pose.q.z;
+      return fabsf(dot) >= threshold;
+    }
+    case TOLERANCE_YAW_FREE: {
+      float tx, ty, tz, px, py, pz;
+      gravityInBody(q, tx, ty, tz);
+      gravityInBody(pose.q, px, py, pz);
+      return tx * px + ty * py + tz * pz >= threshold;
+    }
+    case TOLERANCE_BOX:
+      return fabsf(wrapDegrees(pose.roll - roll)) <= tolerance &&
+             fabsf(wrapDegrees(pose.pitch - pitch)) <= tolerance &&
+             fabsf(wrapDegrees(pose.yaw - yaw)) <= tolerance;
+  }
+  return false;
+}
+
+float OrientationTarget::distance(const OrientationPose& pose) const {
+  switch (shape) {
+    case TOLERANCE_CONE: {
+      float dot = fabsf(q.w * pose.q.w + q.x * pose.q.x + q.y * pose.q.y + q.z * pose.q.z);
+      return 2.0f * acosf(dot > 1.0f ? 1.0f : dot) * 180.0f / ctmath::pi;
+    }
+    case TOLERANCE_YAW_FREE: {
+      float tx, ty, tz, px, py, pz;
+      gravityInBody(q, tx, ty, tz);
+      gravityInBody(pose.q, px, py, pz);
+      float dot = tx * px + ty * py + tz * pz;
+      return acosf(dot > 1.0f ? 1.0f : (dot < -1.0f ? -1.0f : dot)) * 180.0f / ctmath::pi;
+    }
+    case TOLERANCE_BOX: {
+      float rollError = fabsf(wrapDegrees(pose.roll - roll));
+      float pitchError = fabsf(wrapDegrees(pose.pitch - pitch));
+      float yawError = fabsf(wrapDegrees(pose.yaw - yaw));
+      return fmaxf(rollError, fmaxf(pitchError, yawError));
+    }
+  }
+  return 0.0f;
+}
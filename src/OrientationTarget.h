@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+
+struct Quaternion {
+    float w;
+    float x;
+    float y;
+    float z;
+};
+
+enum ToleranceShape : uint8_t {
+  TOLERANCE_CONE,      // total angular distance from the target orientation
+  TOLERANCE_BOX,       // independent roll, pitch and yaw limits, wrap-aware
+  TOLERANCE_YAW_FREE,  // tilt only; heading is ignored
+};
+
+// Compile-time trig for building targets. Taylor series are accurate to float precision over
+// the half-angle range used here (|x| <= pi / 2).
+namespace ctmath {
+constexpr float pi = 3.14159265358979f;
+
+constexpr float radians(float degrees) {
+  return degrees * pi / 180.0f;
+}
+
+constexpr float wrap180(float degrees) {
+  return degrees > 180.0f ? wrap180(degrees - 360.0f)
+                          : (degrees < -180.0f ? wrap180(degrees + 360.0f) : degrees);
+}
+
+constexpr float sinSeries(float x, float term, float sum, int k) {
+  return k > 10 ? sum
+                : sinSeries(x, -term * x * x / ((2 * k + 2) * (2 * k + 3)), sum + term, k + 1);
+}
+
+constexpr float cosSeries(float x, float term, float sum, int k) {
+  return k > 10 ? sum
+                : cosSeries(x, -term * x * x / ((2 * k + 1) * (2 * k + 2)), sum + term, k + 1);
+}
+
+constexpr float sin(float x) {
+  return sinSeries(x, x, 0.0f, 0);
+}
+
+constexpr float cos(float x) {
+  return cosSeries(x, 1.0f, 0.0f, 0);
+}
+
+// Roll about X, pitch about Y, yaw about Z, applied in Z-Y-X order
+constexpr Quaternion fromHalfAngles(float sr, float cr, float sp, float cp, float sy, float cy) {
+  return {cr * cp * cy + sr * sp * sy, sr * cp * cy - cr * sp * sy, cr * sp * cy + sr * cp * sy,
+          cr * cp * sy - sr * sp * cy};
+}
+
+constexpr Quaternion fromEuler(float roll, float pitch, float yaw) {
+  return fromHalfAngles(sin(radians(wrap180(roll)) / 2), cos(radians(wrap180(roll)) / 2),
+                        sin(radians(wrap180(pitch)) / 2), cos(radians(wrap180(pitch)) / 2),
+                        sin(radians(wrap180(yaw)) / 2), cos(radians(wrap180(yaw)) / 2));
+}
+}  // namespace ctmath
+
+// Sensor orientation in both forms the matchers need, built once per sample
+struct OrientationPose {
+    float roll;
+    float pitch;
+    float yaw;
+    Quaternion q;
+
+    static OrientationPose fromEuler(float roll, float pitch, float yaw);
+};
+
+// A phase target with its tolerance region. Everything that needs trig is folded into constants
+// at compile time, so a runtime check is a handful of multiply-adds and one compare.
+struct OrientationTarget {
+    ToleranceShape shape;
+    float roll;
+    float pitch;
+    float yaw;
+    float tolerance;  // degrees
+    Quaternion q;
+    float threshold;  // cosine bound for CONE and YAW_FREE
+
+    static constexpr OrientationTarget cone(float roll, float pitch, float yaw, float tolerance) {
+      return {TOLERANCE_CONE,
+              roll,
+              pitch,
+              yaw,
+              tolerance,
+              ctmath::fromEuler(roll, pitch, yaw),
+              ctmath::cos(ctmath::radians(tolerance) / 2)};
+    }
+
+    static constexpr OrientationTarget box(float roll, float pitch, float yaw, float tolerance) {
+      return {TOLERANCE_BOX,
+              roll,
+              pitch,
+              yaw,
+              tolerance,
+              ctmath::fromEuler(roll, pitch, yaw),
+              0.0f};
+    }
+
+    static constexpr OrientationTarget yawFree(float roll, float pitch, float tolerance) {
+      return {TOLERANCE_YAW_FREE,
+              roll,
+              pitch,
+              0.0f,
+              tolerance,
+              ctmath::fromEuler(roll, pitch, 0.0f),
+              ctmath::cos(ctmath::radians(tolerance))};
+    }
+
+    bool matches(const OrientationPose& pose) const;
+    float distance(const OrientationPose& pose) const;  // degrees, measured as matches() does
+};
@@ -0,0 +1,194 @@
+#include "PhaseScript.h"
+
+#include <stddef.h>
+
+#include "Crc.h"
+#include "HotPath.h"
+#include "Log.h"
+
+static_assert(offsetof(OrientationTarget, roll) == 4 && sizeof(OrientationTarget) == 40,
+              "OrientationTarget layout is part of the phase script format");
+static_assert(sizeof(PhaseRecord) == 44 && sizeof(PhaseScriptHeader) == 16,
+              "phase script layout changed; bump PhaseScript::version and tools/phase_script.py");
+
+static constexpr uint32_t sectorSize = 4096;
+
+// Used until a valid script is found
+HOT_DATA static constexpr PhaseRecord builtInPhases[] = {
+    {OrientationTarget::cone(0, 0, 10, ORIENTATION_TOLERANCE), 0},   // Phase 1 - untimed
+    {OrientationTarget::cone(0, 0, 15, ORIENTATION_TOLERANCE), 20},  // Phase 2 - 20 seconds
+    {OrientationTarget::cone(0, 0, 10, ORIENTATION_TOLERANCE), 30},  // Phase 3 - 30 seconds
+};
+
+const esp_partition_t* PhaseScript::partition = nullptr;
+const PhaseScriptHeader* PhaseScript::header = nullptr;
+const PhaseRecord* PhaseScript::records = builtInPhases;
+esp_partition_mmap_handle_t PhaseScript::mapHandle = 0;
+int PhaseScript::activeSlot = -1;
+
+int PhaseScript::installSlot = -1;
+uint32_t PhaseScript::installId = 0;
+uint32_t PhaseScript::installSize = 0;
+PhaseScriptHeader PhaseScript::installHeader = {};
+uint32_t PhaseScript::installedId = 0;
+
+void PhaseScript::begin() {
+  partition = esp_partition_find_first((esp_partition_type_t)PHASE_SCRIPT_PARTITION_TYPE,
+                                       ESP_PARTITION_SUBTYPE_ANY, PHASE_SCRIPT_PARTITION_LABEL);
+  if (partition == nullptr) {
+    Serial.println("  ✗ No phases partition, using built-in phases");
+    return;
+  }
+
+  // Headers only to rank the slots; the full check happens on the mapped script
+  PhaseScriptHeader slots[2];
+  for (int slot = 0; slot < 2; slot++) {
+    if (esp_partition_read(partition, slot * slotSize, &slots[slot], sizeof(slots[slot])) !=
+            ESP_OK ||
+        slots[slot].magic != magic) {
+      slots[slot].scriptId = 0;
+    }
+  }
+  int newest = slots[1].scriptId > slots[0].scriptId ? 1 : 0;
+  if ((slots[newest].scriptId != 0 && mapSlot(newest)) ||
+      (slots[1 - newest].scriptId != 0 && mapSlot(1 - newest))) {
+    Serial.printf("  ✓ Phase script %u: %d phases\n", getScriptId(), getPhaseCount());
+  } else {
+    Serial.println("  ✓ No phase script, using built-in phases");
+  }
+}
+
+int HOT_CODE PhaseScript::getPhaseCount() {
+  return header != nullptr ? header->phaseCount
+                           : (int)(sizeof(builtInPhases) / sizeof(builtInPhases[0]));
+}
+
+const OrientationTarget& HOT_CODE PhaseScript::getTarget(int phase) {
+  return records[phase].target;
+}
+
+uint32_t PhaseScript::getTimeLimitSeconds(int phase) {
+  return records[phase].timeLimitSeconds;
+}
+
+uint32_t PhaseScript::getScriptId() {
+  return header != nullptr ? header->scriptId : 0;
+}
+
+uint32_t PhaseScript::getSize() {
+  return sizeof(PhaseScriptHeader) + getPhaseCount() * sizeof(PhaseRecord);
+}
+
+const uint8_t* PhaseScript::getBlob() {
+  return reinterpret_cast<const uint8_t*>(header);
+}
+
+bool PhaseScript::validate(const uint8_t* blob, uint32_t length) {
+  if (length < sizeof(PhaseScriptHeader)) {
+    return false;
+  }
+  const PhaseScriptHeader* candidate = reinterpret_cast<const PhaseScriptHeader*>(blob);
+  if (candidate->magic != magic || candidate->version != version ||
+      candidate->phaseCount == 0 || candidate->phaseCount > MAX_PHASES ||
+      length < sizeof(PhaseScriptHeader) + candidate->phaseCount * sizeof(PhaseRecord)) {
+    return false;
+  }
+
+  const PhaseRecord* phases = reinterpret_cast<const PhaseRecord*>(candidate + 1);
+  for (int i = 0; i < candidate->phaseCount; i++) {
+    if (phases[i].target.shape > TOLERANCE_YAW_FREE) {
+      return false;
+    }
+  }
+  return candidate->crc == Crc::crc32(phases, candidate->phaseCount * sizeof(PhaseRecord));
+}
+
+// The new mapping replaces the old one only once it has validated
+bool PhaseScript::mapSlot(int slot) {
+  const void* mapped = nullptr;
+  esp_partition_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, slot * slotSize, slotSize, ESP_PARTITION_MMAP_DATA, &mapped,
+                         &handle) != ESP_OK) {
+    return false;
+  }
+  if (!validate(static_cast<const uint8_t*>(mapped), maxSize)) {
+    esp_partition_munmap(handle);
+    return false;
+  }
+
+  if (activeSlot >= 0) {
+    esp_partition_munmap(mapHandle);
+  }
+  mapHandle = handle;
+  activeSlot = slot;
+  header = static_cast<const PhaseScriptHeader*>(mapped);
+  records = reinterpret_cast<const PhaseRecord*>(header + 1);
+  return true;
+}
+
+bool PhaseScript::beginInstall(uint32_t scriptId, uint32_t size) {
+  if (partition == nullptr || size < sizeof(PhaseScriptHeader) || size > maxSize) {
+    return false;
+  }
+
+  installSlot = activeSlot == 0 ? 1 : 0;
+  installId = scriptId;
+  installSize = size;
+  installedId = 0;  // an installed script not yet adopted sits in this slot
+  memset(&installHeader, 0xFF, sizeof(installHeader));
+
+  uint32_t eraseSize = (size + sectorSize - 1) / sectorSize * sectorSize;
+  return esp_partition_erase_range(partition, installSlot * slotSize, eraseSize) == ESP_OK;
+}
+
+bool PhaseScript::writeInstall(uint32_t offset, const uint8_t* data, size_t length) {
+  if (installSlot < 0 || offset + length > installSize) {
+    return false;
+  }
+
+  // The header is held back until the rest has been written and checked
+  if (offset < sizeof(PhaseScriptHeader)) {
+    size_t headerBytes = sizeof(PhaseScriptHeader) - offset;
+    headerBytes = headerBytes < length ? headerBytes : length;
+    memcpy(reinterpret_cast<uint8_t*>(&installHeader) + offset, data, headerBytes);
+    offset += headerBytes;
+    data += headerBytes;
+    length -= headerBytes;
+  }
+  return length == 0 ||
+         esp_partition_write(partition, installSlot * slotSize + offset, data, length) == ESP_OK;
+}
+
+bool PhaseScript::finishInstall(uint32_t crc) {
+  if (installSlot < 0) {
+    return false;
+  }
+
+  uint8_t blob[maxSize];
+  memcpy(blob, &installHeader, sizeof(installHeader));
+  uint32_t recordBytes = installSize - sizeof(PhaseScriptHeader);
+  bool valid = esp_partition_read(partition, installSlot * slotSize + sizeof(PhaseScriptHeader),
+                                   blob + sizeof(PhaseScriptHeader), recordBytes) == ESP_OK &&
+               Crc::crc32(blob, installSize) == crc && validate(blob, installSize) &&
+               installHeader.scriptId == installId &&
+               esp_partition_write(partition, installSlot * slotSize, &installHeader,
+                                   sizeof(installHeader)) == ESP_OK;
+  if (valid) {
+    installedId = installId;
+  }
+  return valid;
+}
+
+uint32_t PhaseScript::getInstalledScriptId() {
+  return installedId;
+}
+
+bool PhaseScript::adoptInstalled() {
+  if (installedId == 0 || !mapSlot(installSlot)) {
+    return false;
+  }
+  LOG_INFO(LOG_CAT_STATE, "Phase script %u adopted: %d phases", getScriptId(), getPhaseCount());
+  installedId = 0;
+  installSlot = -1;
+  return true;
+}
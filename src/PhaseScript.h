@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#include "OrientationTarget.h"
+#include "hardware_config.h"
+
+// One phase as stored in a script: the target exactly as the firmware uses it, so a mapped
+// script is read in place
+struct PhaseRecord {
+    OrientationTarget target;
+    uint32_t timeLimitSeconds;  // 0 for an untimed phase
+};
+
+// Blob layout: this header, then phaseCount PhaseRecords. Everything is 4-byte aligned for
+// reads straight out of mapped flash.
+struct PhaseScriptHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t phaseCount;
+    uint32_t scriptId;  // revision; the newest valid script wins
+    uint32_t crc;       // CRC-32 over the records
+};
+
+// The phases in play. Scripts live in the "phases" partition in two slots, so a new one can be
+// written while the other stays mapped; at boot the valid slot with the highest scriptId is
+// mapped and used in place, with no parse step and no copy. Without a valid script the built-in
+// phases are used. tools/phase_script.py compiles text scripts into blobs.
+class PhaseScript {
+  public:
+    static constexpr uint32_t magic = 0x50485331;  // "PHS1"
+    static constexpr uint16_t version = 1;
+    static constexpr uint32_t slotSize = 0x10000;
+    static constexpr uint32_t maxSize =
+        sizeof(PhaseScriptHeader) + MAX_PHASES * sizeof(PhaseRecord);
+
+    static void begin();
+
+    static int getPhaseCount();
+    static const OrientationTarget& getTarget(int phase);
+    static uint32_t getTimeLimitSeconds(int phase);
+    static uint32_t getScriptId();  // 0 for the built-in phases
+    static uint32_t getSize();
+    static const uint8_t* getBlob();  // nullptr for the built-in phases
+
+    // Writing a script into the unused slot. The header goes down last, so a slot that was only
+    // partly written never validates.
+    static bool beginInstall(uint32_t scriptId, uint32_t size);
+    static bool writeInstall(uint32_t offset, const uint8_t* data, size_t length);
+    static bool finishInstall(uint32_t crc);
+    static uint32_t getInstalledScriptId();  // written and verified, waiting to be adopted; or 0
+
+    // Switches to the installed script. Only between sessions, never with a phase in progress.
+    static bool adoptInstalled();
+
+    static bool validate(const uint8_t* blob, uint32_t length);
+
+  private:
+    static const esp_partition_t* partition;
+    static const PhaseScriptHeader* header;
+    static const PhaseRecord* records;
+    static esp_partition_mmap_handle_t mapHandle;
+    static int activeSlot;  // -1 for the built-in phases
+
+    static int installSlot;
+    static uint32_t installId;
+    static uint32_t installSize;
+    static PhaseScriptHeader installHeader;
+    static uint32_t installedId;
+
+    static bool mapSlot(int slot);
+};
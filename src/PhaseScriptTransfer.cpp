@@ -0,0 +1,237 @@
+#include "PhaseScriptTransfer.h"
+
+#include <esp_timer.h>
+#include <stddef.h>
+
+#include "Crc.h"
+#include "EventQueue.h"
+#include "Log.h"
+#include "PhaseScript.h"
+#include "TimerWheel.h"
+
+PhaseScriptTransfer::Peer PhaseScriptTransfer::peers[maxPeers];
+int PhaseScriptTransfer::numPeers = 0;
+volatile bool PhaseScriptTransfer::paused = false;
+
+PhaseScriptTransfer::Mailbox PhaseScriptTransfer::mailbox;
+volatile bool PhaseScriptTransfer::mailboxFull = false;
+portMUX_TYPE PhaseScriptTransfer::mailboxLock = portMUX_INITIALIZER_UNLOCKED;
+PhaseScriptTransfer::Transfer PhaseScriptTransfer::transfer = {};
+
+void PhaseScriptTransfer::beginMaster() {
+  EspNowLink::registerHandler(LINK_FRAME_SCRIPT_REQUEST, &onRequest, LINK_HANDLER_WIFI_TASK);
+  if (PhaseScript::getScriptId() != 0) {
+    TimerWheel::schedule(TIMER_SCRIPT_OFFER, PHASE_SCRIPT_OFFER_INTERVAL_MS * 1000UL);
+  }
+}
+
+void PhaseScriptTransfer::beginSlave() {
+  EspNowLink::registerHandler(LINK_FRAME_SCRIPT_OFFER, &onOffer, LINK_HANDLER_WIFI_TASK);
+  EspNowLink::registerHandler(LINK_FRAME_SCRIPT_CHUNK, &onChunk, LINK_HANDLER_WIFI_TASK);
+}
+
+bool PhaseScriptTransfer::addPeer(const uint8_t* mac) {
+  if (numPeers >= maxPeers) {
+    return false;
+  }
+
+  Peer& peer = peers[numPeers++];
+  memcpy(peer.mac, mac, sizeof(peer.mac));
+  peer.upToDate = false;
+  return true;
+}
+
+// Offers resume a full interval after a phase, the same as link probes
+void PhaseScriptTransfer::setPaused(bool pause) {
+  if (pause) {
+    TimerWheel::cancel(TIMER_SCRIPT_OFFER);
+    TimerWheel::cancel(TIMER_SCRIPT_TRANSFER);
+  } else if (paused && PhaseScript::getScriptId() != 0) {
+    TimerWheel::schedule(TIMER_SCRIPT_OFFER, PHASE_SCRIPT_OFFER_INTERVAL_MS * 1000UL);
+  }
+  paused = pause;
+}
+
+void PhaseScriptTransfer::offer() {
+  if (paused || PhaseScript::getScriptId() == 0) {
+    return;
+  }
+
+  OfferFrame frame = {PhaseScript::getScriptId(), PhaseScript::getSize(),
+                      Crc::crc32(PhaseScript::getBlob(), PhaseScript::getSize())};
+  bool pending = false;
+  for (int i = 0; i < numPeers; i++) {
+    if (!peers[i].upToDate) {
+      EspNowLink::queue(peers[i].mac, LINK_FRAME_SCRIPT_OFFER, &frame, sizeof(frame));
+      pending = true;
+    }
+  }
+  if (pending) {
+    TimerWheel::schedule(TIMER_SCRIPT_OFFER, PHASE_SCRIPT_OFFER_INTERVAL_MS * 1000UL);
+  }
+}
+
+void PhaseScriptTransfer::service() {
+  Mailbox frame;
+  portENTER_CRITICAL(&mailboxLock);
+  bool full = mailboxFull;
+  if (full) {
+    frame = mailbox;
+    mailboxFull = false;
+  }
+  portEXIT_CRITICAL(&mailboxLock);
+
+  // Dropped while paused; the master offers again after the phase
+  if (!full || paused) {
+    return;
+  }
+  if (frame.type == LINK_FRAME_SCRIPT_OFFER) {
+    handleOffer(frame.mac, frame.offer);
+  } else {
+    handleChunk(frame.chunk);
+  }
+}
+
+void PhaseScriptTransfer::retry() {
+  if (paused || transfer.scriptId == 0) {
+    return;
+  }
+  if (++transfer.retries > PHASE_SCRIPT_MAX_RETRIES) {
+    LOG_WARN(LOG_CAT_RADIO, "Phase script %u stalled at %u of %u bytes", transfer.scriptId,
+             transfer.offset, transfer.size);
+    return;
+  }
+  request(transfer.mac, transfer.scriptId, transfer.offset);
+  TimerWheel::schedule(TIMER_SCRIPT_TRANSFER, PHASE_SCRIPT_RETRY_MS * 1000UL);
+}
+
+void PhaseScriptTransfer::handleOffer(const uint8_t* mac, const OfferFrame& offer) {
+  uint32_t haveId = PhaseScript::getScriptId();
+  if (PhaseScript::getInstalledScriptId() > haveId) {
+    haveId = PhaseScript::getInstalledScriptId();
+  }
+  if (offer.scriptId <= haveId) {
+    request(mac, offer.scriptId, offer.size);  // nothing newer; the master can stop offering
+    return;
+  }
+
+  bool resuming = transfer.scriptId == offer.scriptId && transfer.size == offer.size &&
+                  transfer.crc == offer.crc;
+  if (!resuming) {
+    if (!PhaseScript::beginInstall(offer.scriptId, offer.size)) {
+      LOG_WARN(LOG_CAT_RADIO, "Phase script %u (%u bytes) cannot be installed", offer.scriptId,
+               offer.size);
+      transfer.scriptId = 0;
+      return;
+    }
+    memcpy(transfer.mac, mac, sizeof(transfer.mac));
+    transfer.scriptId = offer.scriptId;
+    transfer.size = offer.size;
+    transfer.crc = offer.crc;
+    transfer.offset = 0;
+    LOG_INFO(LOG_CAT_RADIO, "Receiving phase script %u (%u bytes)", offer.scriptId, offer.size);
+  }
+
+  transfer.retries = 0;
+  request(transfer.mac, transfer.scriptId, transfer.offset);
+  TimerWheel::schedule(TIMER_SCRIPT_TRANSFER, PHASE_SCRIPT_RETRY_MS * 1000UL);
+}
+
+// Chunks that are not the one asked for are duplicates of an earlier retry
+void PhaseScriptTransfer::handleChunk(const ChunkFrame& chunk) {
+  if (chunk.scriptId != transfer.scriptId || chunk.offset != transfer.offset) {
+    return;
+  }
+
+  if (!PhaseScript::writeInstall(chunk.offset, chunk.data, chunk.length)) {
+    LOG_WARN(LOG_CAT_RADIO, "Phase script %u write failed at %u", chunk.scriptId, chunk.offset);
+    transfer.scriptId = 0;
+    TimerWheel::cancel(TIMER_SCRIPT_TRANSFER);
+    return;
+  }
+  transfer.offset += chunk.length;
+  transfer.retries = 0;
+
+  if (transfer.offset < transfer.size) {
+    request(transfer.mac, transfer.scriptId, transfer.offset);
+    TimerWheel::schedule(TIMER_SCRIPT_TRANSFER, PHASE_SCRIPT_RETRY_MS * 1000UL);
+    return;
+  }
+
+  TimerWheel::cancel(TIMER_SCRIPT_TRANSFER);
+  if (PhaseScript::finishInstall(transfer.crc)) {
+    LOG_INFO(LOG_CAT_RADIO, "Phase script %u received", transfer.scriptId);
+    request(transfer.mac, transfer.scriptId, transfer.size);
+  } else {
+    LOG_WARN(LOG_CAT_RADIO, "Phase script %u failed verification", transfer.scriptId);
+  }
+  transfer.scriptId = 0;  // a failed script starts over on the next offer
+}
+
+void PhaseScriptTransfer::request(const uint8_t* mac, uint32_t scriptId, uint32_t offset) {
+  RequestFrame frame = {scriptId, offset};
+  EspNowLink::send(mac, LINK_FRAME_SCRIPT_REQUEST, &frame, sizeof(frame));
+}
+
+void PhaseScriptTransfer::onOffer(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  if (length != sizeof(OfferFrame)) {
+    return;
+  }
+
+  portENTER_CRITICAL(&mailboxLock);
+  mailbox.type = LINK_FRAME_SCRIPT_OFFER;
+  memcpy(mailbox.mac, mac, sizeof(mailbox.mac));
+  memcpy(&mailbox.offer, payload, sizeof(OfferFrame));
+  mailboxFull = true;
+  portEXIT_CRITICAL(&mailboxLock);
+  EventQueue::post({EVENT_SCRIPT_FRAME, esp_timer_get_time()});
+}
+
+// Served from the WiFi task, straight out of the mapped script
+void PhaseScriptTransfer::onRequest(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  if (length != sizeof(RequestFrame) || paused) {
+    return;
+  }
+
+  RequestFrame request;
+  memcpy(&request, payload, sizeof(request));
+  if (request.offset >= PhaseScript::getSize() || request.scriptId > PhaseScript::getScriptId()) {
+    for (int i = 0; i < numPeers; i++) {
+      if (memcmp(peers[i].mac, mac, sizeof(peers[i].mac)) == 0) {
+        peers[i].upToDate = true;
+      }
+    }
+    return;
+  }
+  if (request.scriptId != PhaseScript::getScriptId()) {
+    return;
+  }
+
+  ChunkFrame chunk;
+  chunk.scriptId = request.scriptId;
+  chunk.offset = request.offset;
+  uint32_t remaining = PhaseScript::getSize() - request.offset;
+  chunk.length = remaining < chunkSize ? remaining : chunkSize;
+  memcpy(chunk.data, PhaseScript::getBlob() + request.offset, chunk.length);
+  EspNowLink::send(mac, LINK_FRAME_SCRIPT_CHUNK, &chunk,
+                   offsetof(ChunkFrame, data) + chunk.length);
+}
+
+void PhaseScriptTransfer::onChunk(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  ChunkFrame chunk;
+  if (length < offsetof(ChunkFrame, data) || length > sizeof(chunk)) {
+    return;
+  }
+  memcpy(&chunk, payload, length);
+  if (chunk.length != length - offsetof(ChunkFrame, data)) {
+    return;
+  }
+
+  portENTER_CRITICAL(&mailboxLock);
+  mailbox.type = LINK_FRAME_SCRIPT_CHUNK;
+  memcpy(mailbox.mac, mac, sizeof(mailbox.mac));
+  memcpy(&mailbox.chunk, &chunk, length);
+  mailboxFull = true;
+  portEXIT_CRITICAL(&mailboxLock);
+  EventQueue::post({EVENT_SCRIPT_FRAME, esp_timer_get_time()});
+}
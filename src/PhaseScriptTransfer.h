@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#include "EspNowLink.h"
+#include "hardware_config.h"
+
+// Hands the master's phase script to the slaves over ESP-NOW. The master offers its script
+// until each slave reports it has it; a slave with an older script pulls it one chunk at a time,
+// naming the offset it wants next, so a transfer that stalls resumes where it stopped on the
+// next offer. Chunks are written into PhaseScript's spare slot from the main loop, never from
+// the WiFi task, and nothing is sent or written while a phase is being played. The received
+// script takes effect once the session is idle (see PhaseScript::adoptInstalled).
+class PhaseScriptTransfer {
+  public:
+    static void beginMaster();
+    static void beginSlave();
+    static bool addPeer(const uint8_t* mac);  // master: a slave to keep in step
+    static void setPaused(bool paused);
+
+    static void offer();    // master, on TIMER_SCRIPT_OFFER
+    static void service();  // slave, on EVENT_SCRIPT_FRAME
+    static void retry();    // slave, on TIMER_SCRIPT_TRANSFER
+
+  private:
+    static constexpr size_t chunkSize = 192;
+
+    struct __attribute__((packed)) OfferFrame {
+        uint32_t scriptId;
+        uint32_t size;
+        uint32_t crc;  // CRC-32 of the whole blob, header included
+    };
+
+    // offset at or past the end of the script means the slave has it
+    struct __attribute__((packed)) RequestFrame {
+        uint32_t scriptId;
+        uint32_t offset;
+    };
+
+    struct __attribute__((packed)) ChunkFrame {
+        uint32_t scriptId;
+        uint32_t offset;
+        uint16_t length;
+        uint8_t data[chunkSize];
+    };
+
+    struct Peer {
+        uint8_t mac[6];
+        volatile bool upToDate;
+    };
+
+    // Slave side: the newest frame from the WiFi task, waiting for the main loop
+    struct Mailbox {
+        LinkFrameType type;
+        uint8_t mac[6];
+        union {
+            OfferFrame offer;
+            ChunkFrame chunk;
+        };
+    };
+
+    // Slave side: the script being received
+    struct Transfer {
+        uint8_t mac[6];
+        uint32_t scriptId;  // 0 when idle
+        uint32_t size;
+        uint32_t crc;
+        uint32_t offset;
+        int retries;
+    };
+
+    static constexpr int maxPeers = 2;
+
+    static Peer peers[maxPeers];
+    static int numPeers;
+    static volatile bool paused;
+
+    static Mailbox mailbox;
+    static volatile bool mailboxFull;
+    static portMUX_TYPE mailboxLock;
+    static Transfer transfer;
+
+    static void handleOffer(const uint8_t* mac, const OfferFrame& offer);
+    static void handleChunk(const ChunkFrame& chunk);
+    static void request(const uint8_t* mac, uint32_t scriptId, uint32_t offset);
+
+    static void onOffer(const uint8_t* mac, const uint8_t* payload, size_t length);
+    static void onRequest(const uint8_t* mac, const uint8_t* payload, size_t length);
+    static void onChunk(const uint8_t* mac, const uint8_t* payload, size_t length);
+};
@@ -0,0 +1,105 @@
+#include "PowerManager.h"
+
+#include "hardware_config.h"
+
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+void EspPowerHal::setCpuFrequencyMhz(uint32_t mhz) {
+  ::setCpuFrequencyMhz(mhz);
+}
+
+// Automatic light sleep needs power management in the SDK build. While it is on, the radio
+// sleeps between DTIM beacons, so ESP-NOW frames can be missed; it is off unless asked for.
+void EspPowerHal::setAutoLightSleep(bool enabled) {
+#if CONFIG_PM_ENABLE
+  esp_pm_config_esp32_t config = {};
+  config.max_freq_mhz = ACTIVE_CPU_FREQ_MHZ;
+  config.min_freq_mhz = IDLE_CPU_FREQ_MHZ;
+  config.light_sleep_enable = enabled;
+  esp_pm_configure(&config);
+#else
+  (void)enabled;
+#endif
+}
+
+PowerManager::PowerManager(PowerHal& hal) : hal(hal) {
+}
+
+void PowerManager::request(PowerMode mode) {
+  requestedMode = mode;
+}
+
+bool PowerManager::apply() {
+  PowerMode mode = requestedMode;
+  if (mode == appliedMode) {
+    return false;
+  }
+  setMode(mode);
+  return true;
+}
+
+void PowerManager::boost() {
+  if (appliedMode != POWER_MODE_ACTIVE) {
+    setMode(POWER_MODE_ACTIVE);
+  }
+}
+
+void PowerManager::setMode(PowerMode mode) {
+  if (mode == POWER_MODE_IDLE) {
+    hal.setCpuFrequencyMhz(IDLE_CPU_FREQ_MHZ);
+#ifdef IDLE_AUTO_LIGHT_SLEEP
+    hal.setAutoLightSleep(true);
+#endif
+  } else {
+#ifdef IDLE_AUTO_LIGHT_SLEEP
+    hal.setAutoLightSleep(false);
+#endif
+    hal.setCpuFrequencyMhz(ACTIVE_CPU_FREQ_MHZ);
+  }
+  appliedMode = mode;
+}
+
+PowerMode PowerManager::getMode() const {
+  return appliedMode;
+}
+
+// Only the latest wake counts, so one that changed nothing does not inflate the next measurement
+void PowerManager::markWake(int64_t timestampUs) {
+  if (appliedMode == POWER_MODE_IDLE) {
+    wakeUs = timestampUs;
+  }
+}
+
+bool PowerManager::markRendered(int64_t timestampUs) {
+  int64_t startUs = wakeUs;
+  if (startUs < 0) {
+    return false;
+  }
+  wakeUs = -1;
+
+  lastLatencyUs = timestampUs - startUs;
+  totalLatencyUs += lastLatencyUs;
+  if (lastLatencyUs > maxLatencyUs) {
+    maxLatencyUs = lastLatencyUs;
+  }
+  wakeCount++;
+  return true;
+}
+
+int64_t PowerManager::getLastLatencyUs() const {
+  return lastLatencyUs;
+}
+
+int64_t PowerManager::getMaxLatencyUs() const {
+  return maxLatencyUs;
+}
+
+int64_t PowerManager::getAverageLatencyUs() const {
+  return wakeCount == 0 ? 0 : totalLatencyUs / wakeCount;
+}
+
+uint32_t PowerManager::getWakeCount() const {
+  return wakeCount;
+}
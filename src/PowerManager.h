@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+enum PowerMode : uint8_t {
+  POWER_MODE_ACTIVE,
+  POWER_MODE_IDLE,
+};
+
+// The hardware side of power management, kept behind an interface so the policy can run without
+// the chip
+class PowerHal {
+  public:
+    virtual ~PowerHal() {
+    }
+    virtual void setCpuFrequencyMhz(uint32_t mhz) = 0;
+    virtual void setAutoLightSleep(bool enabled) = 0;
+};
+
+class EspPowerHal : public PowerHal {
+  public:
+    void setCpuFrequencyMhz(uint32_t mhz) override;
+    void setAutoLightSleep(bool enabled) override;
+};
+
+// Modes are requested from any task and applied from loop(). A wake raises the clock at once with
+// boost() so the next screen is drawn at full speed; the following apply() settles on the mode
+// that was asked for. Wake-to-render latency is measured from the wake source's timestamp to the
+// end of the first screen drawn after it.
+class PowerManager {
+  public:
+    explicit PowerManager(PowerHal& hal);
+
+    void request(PowerMode mode);
+    bool apply();
+    void boost();
+    PowerMode getMode() const;
+
+    void markWake(int64_t timestampUs);
+    bool markRendered(int64_t timestampUs);  // true when it ended a measurement
+
+    int64_t getLastLatencyUs() const;
+    int64_t getMaxLatencyUs() const;
+    int64_t getAverageLatencyUs() const;
+    uint32_t getWakeCount() const;
+
+  private:
+    PowerHal& hal;
+    volatile PowerMode requestedMode = POWER_MODE_ACTIVE;
+    PowerMode appliedMode = POWER_MODE_ACTIVE;
+
+    volatile int64_t wakeUs = -1;
+    uint32_t wakeCount = 0;
+    int64_t lastLatencyUs = 0;
+    int64_t maxLatencyUs = 0;
+    int64_t totalLatencyUs = 0;
+
+    void setMode(PowerMode mode);
+};
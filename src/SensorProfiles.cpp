@@ -0,0 +1,18 @@
+#include "SensorProfiles.h"
+
+const SensorProfile SensorProfiles::profiles[SENSOR_PROFILE_COUNT] = {
+    {"active", 0, 1, 1, 0, 0},  // 1 kHz, 184 Hz DLPF (~2 ms delay), 500 deg/s, 2 g, every loop
+    {"idle", 19, 4, 0, 0, 20},  // 50 Hz, 21 Hz DLPF, 250 deg/s for finer bias resolution, 2 g
+};
+
+const SensorProfile& SensorProfiles::get(SensorProfileId id) {
+  return profiles[id];
+}
+
+bool SensorProfiles::apply(MPU6050& mpu, const SensorProfile& profile) {
+  byte status = mpu.writeData(registerSampleRateDivider, profile.sampleRateDivider);
+  status |= mpu.writeData(registerConfig, profile.dlpfConfig);
+  status |= mpu.setGyroConfig(profile.gyroConfig);
+  status |= mpu.setAccConfig(profile.accConfig);
+  return status == 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+#include <MPU6050_light.h>
+
+enum SensorProfileId : uint8_t {
+  SENSOR_PROFILE_ACTIVE,  // players are matching orientations: full rate, low filter latency
+  SENSOR_PROFILE_IDLE,    // waiting states: low rate, heavy filtering, only drift tracking runs
+  SENSOR_PROFILE_COUNT,
+};
+
+struct SensorProfile {
+    const char* name;
+    uint8_t sampleRateDivider;  // output rate = 1 kHz / (1 + divider) with the DLPF enabled
+    uint8_t dlpfConfig;         // DLPF_CFG: 1 = 184 Hz ... 6 = 5 Hz bandwidth
+    uint8_t gyroConfig;         // MPU6050_light range index: 0 = 250 ... 3 = 2000 deg/s
+    uint8_t accConfig;          // MPU6050_light range index: 0 = 2 ... 3 = 16 g
+    uint16_t pollIntervalMs;    // how often loop() reads the sensor
+};
+
+class SensorProfiles {
+  public:
+    static const SensorProfile& get(SensorProfileId id);
+
+    // Only sensor registers change. The integrated angles live in the MPU6050 object, and its
+    // update() integrates over the real elapsed time, so orientation carries across a switch.
+    static bool apply(MPU6050& mpu, const SensorProfile& profile);
+
+  private:
+    static constexpr uint8_t registerSampleRateDivider = 0x19;
+    static constexpr uint8_t registerConfig = 0x1A;
+    static const SensorProfile profiles[SENSOR_PROFILE_COUNT];
+};
@@ -0,0 +1,83 @@
+#include "SessionCheckpoint.h"
+
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <stddef.h>
+
+#include "Crc.h"
+
+static const char* NVS_NAMESPACE = "session";
+static const char* NVS_KEY = "journal";
+
+RTC_NOINIT_ATTR SessionCheckpoint::Record SessionCheckpoint::rtcRecord;
+
+void SessionCheckpoint::seal(Record& record, const SessionSnapshot& snapshot) {
+  record.magic = recordMagic;
+  record.snapshot = snapshot;
+  record.crc = Crc::crc32(&record, offsetof(Record, crc));
+}
+
+bool SessionCheckpoint::isValid(const Record& record) {
+  return record.magic == recordMagic && record.crc == Crc::crc32(&record, offsetof(Record, crc));
+}
+
+void SessionCheckpoint::save(const SessionSnapshot& snapshot) {
+  seal(rtcRecord, snapshot);
+}
+
+void SessionCheckpoint::journal() {
+  if (!isValid(rtcRecord)) {
+    return;
+  }
+  Preferences preferences;
+  if (preferences.begin(NVS_NAMESPACE, false)) {
+    preferences.putBytes(NVS_KEY, &rtcRecord, sizeof(rtcRecord));
+    preferences.end();
+  }
+}
+
+bool SessionCheckpoint::restore(SessionSnapshot& snapshot) {
+  esp_reset_reason_t reason = esp_reset_reason();
+  bool warmReset = reason == ESP_RST_SW || reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                   reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+
+  if (!warmReset && reason != ESP_RST_BROWNOUT) {
+    clear();  // a deliberate power-on starts a new session
+    return false;
+  }
+
+  if (isValid(rtcRecord)) {
+    snapshot = rtcRecord.snapshot;
+    return true;
+  }
+
+  if (reason != ESP_RST_BROWNOUT) {
+    return false;
+  }
+
+  Preferences preferences;
+  if (!preferences.begin(NVS_NAMESPACE, true)) {
+    return false;
+  }
+  Record record;
+  bool found = preferences.getBytes(NVS_KEY, &record, sizeof(record)) == sizeof(record);
+  preferences.end();
+
+  if (!found || !isValid(record)) {
+    return false;
+  }
+  snapshot = record.snapshot;
+  snapshot.state = SESSION_STATE_UNKNOWN;  // only phase progress is trusted from the journal
+  return true;
+}
+
+void SessionCheckpoint::clear() {
+  memset(&rtcRecord, 0, sizeof(rtcRecord));
+
+  Preferences preferences;
+  if (preferences.begin(NVS_NAMESPACE, false)) {
+    preferences.remove(NVS_KEY);
+    preferences.end();
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "hardware_config.h"
+
+const int32_t SESSION_STATE_UNKNOWN = -2;  // not a state; no firmware state has this value
+
+struct SessionSnapshot {
+    int32_t state;  // SESSION_STATE_UNKNOWN when only phase progress is known
+    int32_t phase;
+    bool phaseCompleted[MAX_PHASES];
+    bool submissions[NUM_PLAYERS];
+    float yaw;  // displayed yaw, so the heading carries over the reset
+};
+
+// Keeps session progress across resets. Every checkpoint goes to RTC slow memory, which survives
+// software, panic and watchdog resets for the cost of a copy. journal() copies the latest one to
+// NVS, which is only trusted after a brownout, when RTC memory may not have held. The NVS write
+// stalls the caller, so it belongs on the main loop between events.
+class SessionCheckpoint {
+  public:
+    static void save(const SessionSnapshot& snapshot);
+    static void journal();
+    static bool restore(SessionSnapshot& snapshot);
+    static void clear();
+
+  private:
+    struct Record {
+        uint32_t magic;
+        SessionSnapshot snapshot;
+        uint32_t crc;
+    };
+
+    static constexpr uint32_t recordMagic = 0x5E550002;
+    static Record rtcRecord;
+
+    static void seal(Record& record, const SessionSnapshot& snapshot);
+    static bool isValid(const Record& record);
+};
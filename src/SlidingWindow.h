@@ -0,0 +1,55 @@
+#pragma once
+
+// Mean and variance over the last N values, updated in O(1) per value. The running sums use the
+// sliding form of Welford's update so they stay accurate over long runs in single precision.
+template <int N>
+class SlidingWindow {
+  public:
+    void reset() {
+      head = 0;
+      count = 0;
+      mean = 0.0f;
+      m2 = 0.0f;
+    }
+
+    void add(float value) {
+      if (count < N) {
+        values[head] = value;
+        head = (head + 1) % N;
+        count++;
+        float delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+        return;
+      }
+
+      float oldest = values[head];
+      values[head] = value;
+      head = (head + 1) % N;
+      float oldMean = mean;
+      mean += (value - oldest) / N;
+      m2 += (value - oldest) * (value - mean + oldest - oldMean);
+      if (m2 < 0.0f) {
+        m2 = 0.0f;  // guard against rounding when the window is perfectly still
+      }
+    }
+
+    bool isFull() const {
+      return count == N;
+    }
+
+    float getMean() const {
+      return mean;
+    }
+
+    float getVariance() const {
+      return count > 0 ? m2 / count : 0.0f;
+    }
+
+  private:
+    float values[N] = {};
+    int head = 0;
+    int count = 0;
+    float mean = 0.0f;
+    float m2 = 0.0f;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+
+// Fixed storage for up to N objects of one type, constructed in place at boot and never freed.
+// Stands in for new on objects that live for the whole run.
+template <typename T, int N>
+class StaticPool {
+  public:
+    template <typename... Args>
+    T* create(Args... args) {
+      if (count >= N) {
+        return nullptr;
+      }
+      return new (&storage[count++]) T(args...);
+    }
+
+    int size() const {
+      return count;
+    }
+
+    static constexpr size_t bytes() {
+      return sizeof(Storage) * N;
+    }
+
+  private:
+    struct Storage {
+        alignas(T) uint8_t bytes[sizeof(T)];
+    };
+
+    Storage storage[N];
+    int count = 0;
+};
@@ -0,0 +1,90 @@
+#include "StillnessDetector.h"
+
+#include <math.h>
+
+static constexpr float MAX_GYRO_VARIANCE =
+    STILLNESS_MAX_GYRO_STDDEV_DPS * STILLNESS_MAX_GYRO_STDDEV_DPS;
+static constexpr float MAX_ACCEL_VARIANCE =
+    STILLNESS_MAX_ACCEL_STDDEV_G * STILLNESS_MAX_ACCEL_STDDEV_G;
+
+void StillnessDetector::reset() {
+  for (int axis = 0; axis < 3; axis++) {
+    gyro[axis].reset();
+  }
+  accMagnitude.reset();
+  still = false;
+  running = false;
+  restartRun();
+}
+
+// A run starts with the samples of the first still window and takes each sample after it
+void StillnessDetector::addSample(const float gyro[3], const float acc[3]) {
+  for (int axis = 0; axis < 3; axis++) {
+    this->gyro[axis].add(gyro[axis]);
+  }
+  accMagnitude.add(sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2]));
+
+  still = evaluate();
+  if (!still) {
+    running = false;
+    restartRun();
+  } else if (!running) {
+    running = true;
+    runSamples = STILLNESS_WINDOW_SAMPLES;
+    for (int axis = 0; axis < 3; axis++) {
+      runSum[axis] = this->gyro[axis].getMean() * STILLNESS_WINDOW_SAMPLES;
+    }
+  } else {
+    runSamples++;
+    for (int axis = 0; axis < 3; axis++) {
+      runSum[axis] += gyro[axis];
+    }
+  }
+}
+
+bool StillnessDetector::isWindowFull() const {
+  return accMagnitude.isFull();
+}
+
+bool StillnessDetector::isStill() const {
+  return still;
+}
+
+void StillnessDetector::getGyroMean(float mean[3]) const {
+  for (int axis = 0; axis < 3; axis++) {
+    mean[axis] = gyro[axis].getMean();
+  }
+}
+
+int StillnessDetector::getRunSamples() const {
+  return runSamples;
+}
+
+void StillnessDetector::getRunMean(float mean[3]) const {
+  for (int axis = 0; axis < 3; axis++) {
+    mean[axis] = runSamples > 0 ? runSum[axis] / runSamples : 0.0f;
+  }
+}
+
+void StillnessDetector::restartRun() {
+  runSamples = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    runSum[axis] = 0.0f;
+  }
+}
+
+// A slow steady turn also has low variance, so the mean rate is bounded to what a bias can be
+bool StillnessDetector::evaluate() const {
+  if (!isWindowFull() || accMagnitude.getVariance() > MAX_ACCEL_VARIANCE ||
+      fabsf(accMagnitude.getMean() - 1.0f) > STILLNESS_MAX_ACCEL_ERROR_G) {
+    return false;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (gyro[axis].getVariance() > MAX_GYRO_VARIANCE ||
+        fabsf(gyro[axis].getMean()) > STILLNESS_MAX_GYRO_MEAN_DPS) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "SlidingWindow.h"
+#include "hardware_config.h"
+
+// Decides the device is at rest from gyro and accelerometer statistics over the last
+// STILLNESS_WINDOW_SAMPLES. Fed once per sensor sample and decides on every one, in O(1), so rest
+// is seen as soon as the last moving sample leaves the window.
+//
+// The gyro is also averaged over the whole run of rest, from the first still window on, which
+// gives a steadier bias estimate than one window can.
+class StillnessDetector {
+  public:
+    void reset();
+    void addSample(const float gyro[3], const float acc[3]);
+
+    bool isWindowFull() const;
+    bool isStill() const;
+    void getGyroMean(float mean[3]) const;  // over the window
+
+    int getRunSamples() const;  // samples in the run mean; 0 while not still
+    void getRunMean(float mean[3]) const;
+    void restartRun();  // the run mean starts over from the next sample
+
+  private:
+    SlidingWindow<STILLNESS_WINDOW_SAMPLES> gyro[3];
+    SlidingWindow<STILLNESS_WINDOW_SAMPLES> accMagnitude;
+    bool still = false;
+
+    bool running = false;
+    int runSamples = 0;
+    float runSum[3] = {};
+
+    bool evaluate() const;
+};
@@ -0,0 +1,181 @@
+#include "TimerWheel.h"
+
+#include "EventQueue.h"
+
+TimerWheel::Node TimerWheel::timers[TIMER_COUNT];
+TimerWheel::Node TimerWheel::slots[TimerWheel::levels][TimerWheel::slotCount];
+uint32_t TimerWheel::currentTick = 0;
+int64_t TimerWheel::originUs = 0;
+int TimerWheel::pendingCount = 0;
+esp_timer_handle_t TimerWheel::ticker = nullptr;
+portMUX_TYPE TimerWheel::lock = portMUX_INITIALIZER_UNLOCKED;
+
+void TimerWheel::begin() {
+  for (int level = 0; level < levels; level++) {
+    for (uint32_t i = 0; i < slotCount; i++) {
+      slots[level][i].prev = &slots[level][i];
+      slots[level][i].next = &slots[level][i];
+    }
+  }
+  originUs = esp_timer_get_time();
+
+  esp_timer_create_args_t args = {};
+  args.callback = &onTicker;
+  args.name = "timer_wheel";
+  esp_timer_create(&args, &ticker);
+}
+
+// Expiry is rounded up to a whole tick, so a timer never fires early
+void TimerWheel::schedule(TimerId id, uint32_t delayUs) {
+  int64_t nowUs = esp_timer_get_time();
+  Node& node = timers[id];
+
+  portENTER_CRITICAL(&lock);
+  if (node.pending) {
+    unlink(node);
+    pendingCount--;
+  }
+  node.generation++;
+  if (pendingCount == 0) {
+    originUs = nowUs - (int64_t)currentTick * TIMER_WHEEL_TICK_US;  // nothing to catch up on
+  }
+
+  int64_t ticks = (nowUs + delayUs - originUs + TIMER_WHEEL_TICK_US - 1) / TIMER_WHEEL_TICK_US;
+  node.expiryTick = ticks > (int64_t)currentTick ? (uint32_t)ticks : currentTick;
+  node.pending = true;
+  pendingCount++;
+  add(node);
+  rearm(nowUs);
+  portEXIT_CRITICAL(&lock);
+}
+
+void TimerWheel::cancel(TimerId id) {
+  Node& node = timers[id];
+
+  portENTER_CRITICAL(&lock);
+  if (node.pending) {
+    unlink(node);
+    node.pending = false;
+    pendingCount--;
+  }
+  node.generation++;
+  portEXIT_CRITICAL(&lock);
+}
+
+bool TimerWheel::isPending(TimerId id) {
+  return timers[id].pending;
+}
+
+bool TimerWheel::claimExpiry(uint32_t eventValue, TimerId& id) {
+  id = (TimerId)(eventValue & 0xFF);
+  if (id >= TIMER_COUNT) {
+    return false;
+  }
+  const Node& node = timers[id];
+  return !node.pending && (node.generation & 0xFFFFFF) == eventValue >> 8;
+}
+
+// Runs every tick that is due. Expiries are posted once the lock is released.
+void TimerWheel::advance(int64_t nowUs) {
+  uint32_t expired[TIMER_COUNT];
+  int count = 0;
+
+  portENTER_CRITICAL(&lock);
+  while (pendingCount > 0 && tickTimeUs(currentTick) <= nowUs) {
+    count = runTick(expired, count);
+  }
+  rearm(nowUs);
+  portEXIT_CRITICAL(&lock);
+
+  for (int i = 0; i < count; i++) {
+    EventQueue::post({EVENT_TIMER_EXPIRED, nowUs, expired[i]});
+  }
+}
+
+void TimerWheel::onTicker(void* arg) {
+  advance(esp_timer_get_time());
+}
+
+// The next tick with work is the first non-empty level-0 slot, or the next wrap of level 0,
+// where higher levels cascade down; either is at most 64 ticks away
+void TimerWheel::rearm(int64_t nowUs) {
+  if (ticker == nullptr) {
+    return;
+  }
+  esp_timer_stop(ticker);
+  if (pendingCount == 0) {
+    return;
+  }
+
+  uint32_t tick = currentTick;
+  for (uint32_t i = 0; i < slotCount; i++, tick++) {
+    uint32_t index = tick & slotMask;
+    if (index == 0 || slots[0][index].next != &slots[0][index]) {
+      break;
+    }
+  }
+
+  int64_t waitUs = tickTimeUs(tick) - nowUs;
+  esp_timer_start_once(ticker, waitUs > 0 ? (uint64_t)waitUs : 0);
+}
+
+void TimerWheel::add(Node& node) {
+  uint32_t delta = node.expiryTick - currentTick;
+  if (delta > maxDelayTicks) {
+    node.expiryTick = currentTick + maxDelayTicks;
+    delta = maxDelayTicks;
+  }
+
+  int level = 0;
+  while (level < levels - 1 && delta >= (1u << (slotBits * (level + 1)))) {
+    level++;
+  }
+
+  Node& head = slots[level][(node.expiryTick >> (slotBits * level)) & slotMask];
+  node.prev = head.prev;
+  node.next = &head;
+  head.prev->next = &node;
+  head.prev = &node;
+}
+
+void TimerWheel::unlink(Node& node) {
+  node.prev->next = node.next;
+  node.next->prev = node.prev;
+  node.prev = nullptr;
+  node.next = nullptr;
+}
+
+void TimerWheel::cascade(int level, uint32_t index) {
+  Node& head = slots[level][index];
+  while (head.next != &head) {
+    Node& node = *head.next;
+    unlink(node);
+    add(node);
+  }
+}
+
+// When level 0 wraps, the next slot of each level above is spread out over the levels below
+int TimerWheel::runTick(uint32_t expired[], int count) {
+  uint32_t index = currentTick & slotMask;
+  for (int level = 1; index == 0 && level < levels; level++) {
+    index = (currentTick >> (slotBits * level)) & slotMask;
+    cascade(level, index);
+  }
+
+  Node& head = slots[0][currentTick & slotMask];
+  while (head.next != &head) {
+    Node& node = *head.next;
+    unlink(node);
+    node.pending = false;
+    pendingCount--;
+    uint32_t id = (uint32_t)(&node - timers);
+    expired[count++] = id | (node.generation & 0xFFFFFF) << 8;
+  }
+
+  currentTick++;
+  return count;
+}
+
+int64_t TimerWheel::tickTimeUs(uint32_t tick) {
+  return originUs + (int64_t)tick * TIMER_WHEEL_TICK_US;
+}
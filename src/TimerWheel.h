@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "hardware_config.h"
+
+// Every deadline in the firmware has a fixed slot here; scheduling one that is already pending
+// moves it
+enum TimerId : uint8_t {
+  TIMER_PHASE_TIMEOUT,
+  TIMER_ORIENTATION_REFRESH,
+  TIMER_COUNTDOWN,
+  TIMER_MELODY,
+  TIMER_LED_ANIMATION,
+  TIMER_LINK_PROBE,
+  TIMER_ORIENTATION_STREAM,
+  TIMER_PLAYER_STATUS,
+  TIMER_SCRIPT_OFFER,
+  TIMER_SCRIPT_TRANSFER,
+  TIMER_LINK_FLUSH,
+  TIMER_REJOIN,
+  TIMER_COUNT,
+};
+
+// Hierarchical timer wheel: four levels of 64 slots, TIMER_WHEEL_TICK_US per level-0 slot.
+// Schedule and cancel are O(1); a timer is moved down a level at most three times before it
+// expires. Expiries are posted to the EventQueue as EVENT_TIMER_EXPIRED.
+//
+// The wheel is driven by a one-shot esp_timer armed for the next slot that has work, so nothing
+// ticks while no deadline is near. advance() can also be called directly with any clock.
+class TimerWheel {
+  public:
+    static void begin();
+
+    static void schedule(TimerId id, uint32_t delayUs);
+    static void cancel(TimerId id);
+    static bool isPending(TimerId id);
+
+    static void advance(int64_t nowUs);
+
+    // Unpacks an EVENT_TIMER_EXPIRED value. False if the timer was rescheduled or cancelled after
+    // the expiry was posted, so a stale expiry is never acted on.
+    static bool claimExpiry(uint32_t eventValue, TimerId& id);
+
+  private:
+    struct Node {
+        Node* prev;
+        Node* next;
+        uint32_t expiryTick;
+        uint32_t generation;  // bumped by every schedule and cancel
+        bool pending;
+    };
+
+    static constexpr int levels = 4;
+    static constexpr int slotBits = 6;
+    static constexpr uint32_t slotCount = 1u << slotBits;
+    static constexpr uint32_t slotMask = slotCount - 1;
+    static constexpr uint32_t maxDelayTicks = (1u << (slotBits * levels)) - 1;
+
+    static Node timers[TIMER_COUNT];
+    static Node slots[levels][slotCount];  // list heads
+    static uint32_t currentTick;           // next tick to run
+    static int64_t originUs;               // time of tick 0
+    static int pendingCount;
+    static esp_timer_handle_t ticker;
+    static portMUX_TYPE lock;
+
+    static void onTicker(void* arg);
+    static void rearm(int64_t nowUs);
+
+    static void add(Node& node);
+    static void unlink(Node& node);
+    static void cascade(int level, uint32_t index);
+    static int runTick(uint32_t expired[], int count);
+    static int64_t tickTimeUs(uint32_t tick);
+};
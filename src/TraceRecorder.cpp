@@ -0,0 +1,264 @@
+#include "TraceRecorder.h"
+
+#include "Crc.h"
+#include "DeadlineMonitor.h"
+
+const esp_partition_t* TraceRecorder::partition = nullptr;
+QueueHandle_t TraceRecorder::queue = nullptr;
+StaticQueue_t TraceRecorder::queueControl;
+uint8_t TraceRecorder::queueStorage[TRACE_QUEUE_LENGTH * sizeof(Record)];
+StackType_t TraceRecorder::writerStack[writerStackSize];
+StaticTask_t TraceRecorder::writerTaskControl;
+volatile bool TraceRecorder::dumpRequested = false;
+volatile uint32_t TraceRecorder::droppedRecords = 0;
+
+uint32_t TraceRecorder::pageCount = 0;
+uint32_t TraceRecorder::nextPage = 0;
+uint32_t TraceRecorder::nextSequence = 0;
+
+uint8_t TraceRecorder::page[pageSize];
+TraceRecorder::PageHeader TraceRecorder::header = {};
+int64_t TraceRecorder::lastRecordUs = 0;
+int16_t TraceRecorder::lastImu[6] = {};
+int32_t TraceRecorder::lastTemperature = INT32_MIN;
+
+// Picks up after the newest page left by the previous run. Pages past it in the same sector were
+// erased when that sector was entered, so writing can resume there without another erase.
+bool TraceRecorder::begin() {
+  partition = esp_partition_find_first((esp_partition_type_t)TRACE_PARTITION_TYPE,
+                                       ESP_PARTITION_SUBTYPE_ANY, TRACE_PARTITION_LABEL);
+  if (partition == nullptr) {
+    Serial.println("  ✗ No trace partition, recorder disabled");
+    return false;
+  }
+
+  pageCount = partition->size / pageSize;
+  uint32_t newestSequence = erasedSequence;
+  for (uint32_t i = 0; i < pageCount; i++) {
+    PageHeader stored;
+    if (esp_partition_read(partition, i * pageSize, &stored, sizeof(stored)) != ESP_OK) {
+      continue;
+    }
+    if (stored.sequence == erasedSequence) {
+      continue;
+    }
+    if (newestSequence == erasedSequence || stored.sequence > newestSequence) {
+      newestSequence = stored.sequence;
+      nextPage = (i + 1) % pageCount;
+    }
+  }
+  nextSequence = newestSequence == erasedSequence ? 0 : newestSequence + 1;
+
+  queue = xQueueCreateStatic(TRACE_QUEUE_LENGTH, sizeof(Record), queueStorage, &queueControl);
+  xTaskCreateStaticPinnedToCore(&writerTask, "trace", writerStackSize, nullptr, 1, writerStack,
+                                &writerTaskControl, 0);
+
+  Serial.printf("  ✓ Trace recorder on %u pages, resuming at page %u\n", pageCount, nextPage);
+  return true;
+}
+
+void TraceRecorder::requestDump() {
+  dumpRequested = true;
+}
+
+void TraceRecorder::recordImu(int64_t timestampUs, const float acc[3], const float gyro[3]) {
+  Record record = {timestampUs, TRACE_RECORD_IMU, 0, {}};
+  for (int i = 0; i < 3; i++) {
+    record.imu[i] = (int16_t)constrain(acc[i] * 1000.0f, -32768.0f, 32767.0f);        // mg
+    record.imu[3 + i] = (int16_t)constrain(gyro[i] * 100.0f, -32768.0f, 32767.0f);  // cdeg/s
+  }
+  post(record);
+}
+
+// In centidegrees, and only when it has moved by a tenth of a degree; the die warms slowly
+void TraceRecorder::recordTemperature(int64_t timestampUs, float temperatureC) {
+  int32_t temperature = (int32_t)lroundf(temperatureC * 100.0f);
+  if (lastTemperature != INT32_MIN && abs(temperature - lastTemperature) < 10) {
+    return;
+  }
+  lastTemperature = temperature;
+
+  Record record = {timestampUs, TRACE_RECORD_TEMPERATURE, 0, {}};
+  record.value = temperature;
+  post(record);
+}
+
+void TraceRecorder::recordState(int64_t timestampUs, int state) {
+  Record record = {timestampUs, TRACE_RECORD_STATE, 0, {}};
+  record.value = state;
+  post(record);
+}
+
+void TraceRecorder::recordButton(int64_t timestampUs, uint8_t pin) {
+  Record record = {timestampUs, TRACE_RECORD_BUTTON, 0, {}};
+  record.value = pin;
+  post(record);
+}
+
+void TraceRecorder::recordMessage(int64_t timestampUs, TraceMessageKind kind, const void* data,
+                                  size_t length) {
+  Record record = {timestampUs, TRACE_RECORD_MESSAGE, 0, {}};
+  record.length = (uint8_t)(length < sizeof(record.bytes) ? length : sizeof(record.bytes) - 1);
+  record.bytes[0] = kind;
+  memcpy(record.bytes + 1, data, record.length);
+  post(record);
+}
+
+// Peer (last byte of its MAC), frame type, payload length and whether it could wait for a bundle
+void TraceRecorder::recordLinkMessage(int64_t timestampUs, const uint8_t* mac, uint8_t type,
+                                      size_t length, bool deferrable) {
+  Record record = {timestampUs, TRACE_RECORD_LINK, 4, {}};
+  record.bytes[0] = mac[5];
+  record.bytes[1] = type;
+  record.bytes[2] = (uint8_t)length;
+  record.bytes[3] = deferrable;
+  post(record);
+}
+
+void TraceRecorder::post(const Record& record) {
+  if (queue == nullptr) {
+    return;
+  }
+  if (xQueueSend(queue, &record, 0) != pdTRUE) {
+    droppedRecords = droppedRecords + 1;
+  }
+}
+
+// A page that has been open for the flush interval is written even if not full, so at most that
+// much is lost to a reset
+void TraceRecorder::writerTask(void* arg) {
+  int deadline = DeadlineMonitor::add("trace", DEADLINE_TRACE_MS);
+  Record record;
+  for (;;) {
+    DeadlineMonitor::checkIn(deadline);
+    if (xQueueReceive(queue, &record, pdMS_TO_TICKS(TRACE_FLUSH_INTERVAL_MS)) == pdTRUE) {
+      if (header.records > 0 && (sizeof(PageHeader) + header.length + maxRecordSize > pageSize ||
+                                 record.timestampUs - header.baseUs >
+                                     TRACE_FLUSH_INTERVAL_MS * 1000LL)) {
+        flushPage();
+      }
+      if (header.records == 0) {
+        startPage(record.timestampUs);
+      }
+      encode(record);
+    } else if (header.records > 0) {
+      flushPage();
+    }
+
+    if (dumpRequested) {
+      if (header.records > 0) {
+        flushPage();
+      }
+      DeadlineMonitor::pause(deadline);  // a dump prints the whole partition
+      dump();
+      dumpRequested = false;
+    }
+  }
+}
+
+// Record layout: type byte, zigzag varint microseconds since the previous record in the page
+// (records from different tasks can arrive slightly out of order), payload. IMU payloads are
+// zigzag varint deltas from the page's previous IMU record.
+void TraceRecorder::encode(const Record& record) {
+  uint8_t* start = page + sizeof(PageHeader) + header.length;
+  uint8_t* out = start;
+
+  *out++ = record.type;
+  out = putVarint(out, zigzag((int32_t)(record.timestampUs - lastRecordUs)));
+  lastRecordUs = record.timestampUs;
+
+  switch (record.type) {
+    case TRACE_RECORD_IMU:
+      for (int i = 0; i < 6; i++) {
+        out = putVarint(out, zigzag(record.imu[i] - lastImu[i]));
+        lastImu[i] = record.imu[i];
+      }
+      break;
+    case TRACE_RECORD_STATE:
+    case TRACE_RECORD_BUTTON:
+    case TRACE_RECORD_TEMPERATURE:
+      out = putVarint(out, zigzag(record.value));
+      break;
+    case TRACE_RECORD_MESSAGE:
+      *out++ = record.bytes[0];
+      *out++ = record.length;
+      memcpy(out, record.bytes + 1, record.length);
+      out += record.length;
+      break;
+    case TRACE_RECORD_LINK:
+      memcpy(out, record.bytes, record.length);
+      out += record.length;
+      break;
+  }
+
+  header.length += out - start;
+  header.records++;
+}
+
+void TraceRecorder::startPage(int64_t baseUs) {
+  header = {};
+  header.baseUs = baseUs;
+  lastRecordUs = baseUs;
+  memset(lastImu, 0, sizeof(lastImu));
+}
+
+void TraceRecorder::flushPage() {
+  header.sequence = nextSequence++;
+  header.dropped = droppedRecords;
+  droppedRecords = 0;
+  header.crc = Crc::crc32(&header, offsetof(PageHeader, crc));
+  header.crc = Crc::crc32(page + sizeof(PageHeader), header.length, header.crc);
+  memcpy(page, &header, sizeof(header));
+
+  size_t offset = nextPage * pageSize;
+  if (offset % sectorSize == 0) {
+    esp_partition_erase_range(partition, offset, sectorSize);
+  }
+  esp_partition_write(partition, offset, page, sizeof(PageHeader) + header.length);
+
+  nextPage = (nextPage + 1) % pageCount;
+  header = {};
+}
+
+// Pages are printed oldest first as hex lines between markers; recording pauses meanwhile and
+// anything that overflows the queue is counted as dropped
+void TraceRecorder::dump() {
+  char line[2 * pageSize + 1];
+  static const char hex[] = "0123456789abcdef";
+
+  Serial.printf("trace-begin %u\n", pageSize);
+  for (uint32_t i = 0; i < pageCount; i++) {
+    uint32_t index = (nextPage + i) % pageCount;
+    if (esp_partition_read(partition, index * pageSize, page, pageSize) != ESP_OK) {
+      continue;
+    }
+
+    PageHeader stored;
+    memcpy(&stored, page, sizeof(stored));
+    if (stored.sequence == erasedSequence || sizeof(PageHeader) + stored.length > pageSize) {
+      continue;
+    }
+
+    size_t size = sizeof(PageHeader) + stored.length;
+    for (size_t b = 0; b < size; b++) {
+      line[2 * b] = hex[page[b] >> 4];
+      line[2 * b + 1] = hex[page[b] & 0x0F];
+    }
+    line[2 * size] = '\0';
+    Serial.println(line);
+  }
+  Serial.println("trace-end");
+}
+
+uint8_t* TraceRecorder::putVarint(uint8_t* out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (uint8_t)value;
+  return out;
+}
+
+uint32_t TraceRecorder::zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "hardware_config.h"
+
+enum TraceRecordType : uint8_t {
+  TRACE_RECORD_IMU = 1,
+  TRACE_RECORD_STATE = 2,
+  TRACE_RECORD_BUTTON = 3,
+  TRACE_RECORD_MESSAGE = 4,
+  TRACE_RECORD_LINK = 5,  // a message handed to EspNowLink, before bundling
+  TRACE_RECORD_TEMPERATURE = 6,
+};
+
+enum TraceMessageKind : uint8_t {
+  TRACE_MESSAGE_SUBMISSION = 1,
+  TRACE_MESSAGE_PHASE = 2,
+  TRACE_MESSAGE_TRANSMISSION = 3,
+};
+
+// Records IMU samples, die temperature, state changes, button presses, received messages and
+// outgoing link messages into a circular log on the "trace" flash partition. Callers only queue a
+// fixed-size record; a background task delta-encodes records into page buffers and writes whole
+// pages, so no caller waits on flash. Every record call is a no-op until begin() has run. The
+// format is decoded by tools/trace_decode.py.
+class TraceRecorder {
+  public:
+    static bool begin();
+    static void requestDump();
+
+    static void recordImu(int64_t timestampUs, const float acc[3], const float gyro[3]);
+    static void recordState(int64_t timestampUs, int state);
+    static void recordButton(int64_t timestampUs, uint8_t pin);
+    static void recordMessage(int64_t timestampUs, TraceMessageKind kind, const void* data,
+                              size_t length);
+    static void recordTemperature(int64_t timestampUs, float temperatureC);
+    static void recordLinkMessage(int64_t timestampUs, const uint8_t* mac, uint8_t type,
+                                  size_t length, bool deferrable);
+
+  private:
+    struct Record {
+        int64_t timestampUs;
+        TraceRecordType type;
+        uint8_t length;
+        union {
+            int16_t imu[6];
+            int32_t value;
+            uint8_t bytes[16];
+        };
+    };
+
+    // Each page carries its own base time and CRC, so it decodes on its own even when the pages
+    // around it were overwritten or torn by a reset
+    struct PageHeader {
+        uint32_t sequence;
+        uint16_t length;  // payload bytes after the header
+        uint16_t records;
+        int64_t baseUs;
+        uint32_t dropped;  // records lost to a full queue since the previous page
+        uint32_t crc;      // over the header up to here, then the payload
+    };
+
+    static constexpr size_t pageSize = TRACE_PAGE_SIZE;
+    static constexpr size_t sectorSize = 4096;
+    static constexpr size_t maxRecordSize = 1 + 5 + 6 * 3;  // an IMU record, the largest
+    static constexpr uint32_t erasedSequence = 0xFFFFFFFF;
+
+    static const esp_partition_t* partition;
+    static QueueHandle_t queue;
+    static StaticQueue_t queueControl;
+    static uint8_t queueStorage[TRACE_QUEUE_LENGTH * sizeof(Record)];
+    static volatile bool dumpRequested;
+    static volatile uint32_t droppedRecords;
+
+    static uint32_t pageCount;
+    static uint32_t nextPage;
+    static uint32_t nextSequence;
+
+    static uint8_t page[pageSize];
+    static PageHeader header;
+    static int64_t lastRecordUs;
+    static int16_t lastImu[6];
+    static int32_t lastTemperature;
+
+    static constexpr uint32_t writerStackSize = 4096;
+    static StackType_t writerStack[writerStackSize];
+    static StaticTask_t writerTaskControl;
+
+    static void post(const Record& record);
+    static void writerTask(void* arg);
+
+    static void encode(const Record& record);
+    static void startPage(int64_t baseUs);
+    static void flushPage();
+    static void dump();
+
+    static uint8_t* putVarint(uint8_t* out, uint32_t value);
+    static uint32_t zigzag(int32_t value);
+};
@@ -1,8 +1,9 @@
 #pragma once
 
 #define NUM_PLAYERS 3  // (1=Master only, 2=Master+1, 3=Master+2)
-#define NUM_PHASES 3   // Number of orientation phases players must complete before transmission
-#define ORIENTATION_TOLERANCE 2  // degrees of tolerance for matching orientation targets
+#define MAX_PHASES 8   // Most phases a phase script may hold (see PhaseScript)
+#define ORIENTATION_TOLERANCE 3  // default degrees from a phase target that still match it
+// #define MATCH_BENCHMARK        // print orientation match timings over serial at boot
 
 // ====================
 // This Devices Configuration
@@ -34,6 +35,7 @@
 #define RESET_OFFSETS_BUTTON_PIN GPIO_NUM_17  // TX2
 #define TRANSMIT_BUTTON_PIN GPIO_NUM_16       // RX2
 #define LOAD_PHASE_BUTTON_PIN GPIO_NUM_4
+#define BUTTON_DEBOUNCE_US 30000  // line must be quiet this long before a falling edge is a press
 
 // ====================
 // LED Configuration
@@ -56,4 +58,157 @@
 // MPU6050 Configuration
 // ====================
 #define CALCULATE_OFFSET_GYRO true
-#define CALCULATE_OFFSET_ACCEL true
\ No newline at end of file
+#define CALCULATE_OFFSET_ACCEL true
+#define SENSOR_POWER_UP_DELAY_MS 100         // settle time before the first I2C access
+#define CALIBRATION_STILLNESS_CHECK_MS 150   // sampling window for validating stored offsets
+#define CALIBRATION_MAX_GYRO_BIAS_DPS 0.5f   // residual rate allowed with stored offsets applied
+#define CALIBRATION_MAX_ACCEL_ERROR_G 0.05f  // allowed deviation of |accel| from 1 g
+#define CALIBRATION_MAX_TEMP_DRIFT_C 8.0f    // die temperature change that invalidates offsets
+#define ORIENTATION_HISTORY_SIZE 64  // samples kept for judging a submission at the press time
+
+// ====================
+// Auto Submit Configuration
+// ====================
+// #define AUTO_SUBMIT_ENABLED        // submit automatically once the device holds on target
+#define AUTO_SUBMIT_WINDOW_SAMPLES 32  // sliding window for orientation mean and variance
+#define AUTO_SUBMIT_DWELL_MS 750       // time the device must stay steady on target
+#define AUTO_SUBMIT_MAX_STDDEV 0.5f    // degrees, per axis, for the window to count as steady
+
+// ====================
+// Recalibration Configuration
+// ====================
+#define MPU_INIT_TIMEOUT_MS 1000                  // give up on MPU6050 begin() after this long
+#define RECALIBRATION_SAMPLES 500                 // matches the library's calcOffsets sample count
+#define RECALIBRATION_TIMEOUT_MS 5000             // abandon a background recalibration after this
+#define RECALIBRATION_MAX_GYRO_DEVIATION_DPS 2.0f  // per-sample deviation that counts as movement
+
+// ====================
+// Stillness / Gyro Bias Tracking Configuration
+// ====================
+#define STILLNESS_WINDOW_SAMPLES 64          // samples each stillness decision looks back over
+#define STILLNESS_MAX_GYRO_STDDEV_DPS 0.3f   // per-axis gyro noise allowed at rest
+#define STILLNESS_MAX_GYRO_MEAN_DPS 0.3f     // largest residual rate still treated as bias
+#define STILLNESS_MAX_ACCEL_STDDEV_G 0.01f   // accel magnitude noise allowed at rest
+#define STILLNESS_MAX_ACCEL_ERROR_G 0.05f    // allowed deviation of |accel| from 1 g
+#define GYRO_BIAS_REPORT_INTERVAL_MS 30000   // minimum time between bias tracking reports
+#define GYRO_BIAS_MIN_STILL_MS 3000          // rest needed before its mean is learned as bias
+#define GYRO_BIAS_MAX_DEVIATION_DPS 0.5f     // learned bias allowed away from the calibration
+#define GYRO_BIAS_TEMPCO_DPS_PER_C 0.05f     // and further per degree from its temperature
+
+// ====================
+// I2C Fault Handling Configuration
+// ====================
+#define MPU_I2C_ADDRESS 0x68
+#define I2C_TIMEOUT_MS 10                 // per-transaction timeout, bounds every bus stall
+#define I2C_HEALTH_CHECK_INTERVAL_MS 20   // how often both devices are probed
+#define I2C_FROZEN_SAMPLE_LIMIT 8         // identical consecutive MPU samples that mean a dead read
+#define I2C_RECOVERY_BACKOFF_MS 250       // minimum time between recovery attempts
+#define I2C_RECOVERY_BUDGET_MS 50         // recoveries slower than this are reported
+#define DISPLAY_INIT_TIMEOUT_MS 1000      // give up on the OLED after this long at boot
+
+// ====================
+// Power Configuration
+// ====================
+#define ACTIVE_CPU_FREQ_MHZ 240
+#define IDLE_CPU_FREQ_MHZ 80       // lowest clock that keeps the radio running for ESP-NOW
+// #define IDLE_AUTO_LIGHT_SLEEP   // also light sleep when idle; needs PM in the SDK build
+
+// ====================
+// Orientation Prediction
+// ====================
+#define PREDICTION_DISPLAY_LATENCY_PRIOR_US 30000  // starting guess before the first flush
+#define PREDICTION_RADIO_LATENCY_PRIOR_US 3000     // starting guess before the first send
+#define PREDICTION_RADIO_AIR_TIME_US 1000          // one-way delivery until probes measure it
+#define PREDICTION_MAX_HORIZON_US 60000
+#define PREDICTION_LATENCY_GAIN 0.125f             // weight of each new latency measurement
+
+// ====================
+// Trace Recorder
+// ====================
+// #define TRACE_RECORDER_ENABLED         // record to flash; dump by sending 'd' on the serial port
+#define TRACE_PARTITION_TYPE 0x40         // data partition in partitions.csv
+#define TRACE_PARTITION_LABEL "trace"
+#define TRACE_PAGE_SIZE 512
+#define TRACE_QUEUE_LENGTH 64
+#define TRACE_FLUSH_INTERVAL_MS 1000      // longest a record waits in RAM before hitting flash
+
+// ====================
+// Logging
+// ====================
+#define LOG_LEVEL LOG_LEVEL_INFO  // calls above this level are compiled out
+#define LOG_CATEGORIES LOG_CAT_ALL
+#define LOG_RING_SIZE 64          // entries; must be a power of two
+#define LOG_LINE_LENGTH 160
+#define LOG_DRAIN_INTERVAL_MS 10
+// #define LOG_BINARY_OUTPUT      // send frames for tools/log_decode.py instead of text
+
+// ====================
+// Link Probing
+// ====================
+#define LINK_PROBE_INTERVAL_MS 1000       // one ping per interval, peers taken in turn
+#define LINK_PROBE_GAIN 0.125f            // weight of new samples in one-way and drift estimates
+#define LINK_PROBE_OFFSET_WINDOW 8        // recent exchanges; the fastest sets the clock offset
+#define LINK_PROBE_DRIFT_SPAN_MS 30000    // shortest span a clock drift is measured over
+#define LINK_PROBE_MAX_DRIFT_PPM 100      // past any two crystals; a larger drift is clamped
+#define LINK_PROBE_OFFSET_JUMP_US 20000   // offset error no exchange explains: peer restarted
+
+// ====================
+// Timers
+// ====================
+#define TIMER_WHEEL_TICK_US 1000  // deadline resolution; longest deadline is 2^24 ticks
+
+// ====================
+// Orientation Streaming
+// ====================
+// #define ORIENTATION_STREAM_ENABLED          // players stream live angles to the master
+#define ORIENTATION_STREAM_RATE_HZ 20          // sampling rate; frames only go out on change
+#define ORIENTATION_STREAM_QUANTUM_DEG 0.5f
+#define ORIENTATION_STREAM_THRESHOLD_DEG 1.0f  // smallest change worth a frame
+#define ORIENTATION_STREAM_KEYFRAME_MS 1000    // absolute refresh and heartbeat
+#define ORIENTATION_STREAM_AIRTIME_US 50000    // per second, shared by all streaming players
+#define PLAYER_STATUS_REFRESH_MS 200           // master's view of the players while it waits
+
+// ====================
+// Hot Path Placement
+// ====================
+// #define HOT_PATH_IN_IRAM       // per-sample code in IRAM and its tables in DRAM (see HotPath.h)
+// #define LOOP_PROFILER_ENABLED  // time every loop() pass; send 'p' for the distribution
+
+// ====================
+// Phase Scripts
+// ====================
+#define PHASE_SCRIPT_PARTITION_TYPE 0x41  // data partition in partitions.csv, two script slots
+#define PHASE_SCRIPT_PARTITION_LABEL "phases"
+#define PHASE_SCRIPT_OFFER_INTERVAL_MS 2000  // master offers its script until every slave has it
+#define PHASE_SCRIPT_RETRY_MS 500            // slave re-requests a chunk that did not arrive
+#define PHASE_SCRIPT_MAX_RETRIES 5           // then waits for the next offer to resume
+
+// ====================
+// Session Rejoin
+// ====================
+#define SESSION_REJOIN_RETRY_MS 500     // a resumed slave asks the master again until it answers
+#define SESSION_REJOIN_MAX_ATTEMPTS 10  // then it stays in the state it resumed into
+
+// ====================
+// Link Aggregation
+// ====================
+#define LINK_AGGREGATION_WINDOW_US 5000  // how long a message may wait to share a frame; 0 = never
+
+// ====================
+// Deadline Monitor
+// ====================
+#define DEADLINE_CHECK_INTERVAL_MS 50  // a stall is caught at most this long after its deadline
+#define DEADLINE_LOOP_MS 250           // longest loop() pass, its idle wait included
+#define DEADLINE_BOOT_MS 15000         // setup(), offset calibration included
+#define DEADLINE_LOG_MS 2000           // the log drain runs at idle priority
+#define DEADLINE_TRACE_MS 3000         // TRACE_FLUSH_INTERVAL_MS plus a page write
+
+// ====================
+// Gyro Bias Model
+// ====================
+#define BIAS_MODEL_MIN_C 10.0f              // die temperature of the first node
+#define BIAS_MODEL_STEP_C 4.0f              // node spacing; the bias is interpolated between
+#define BIAS_MODEL_NODES 12                 // 10 to 54 C; outside, the end nodes hold
+#define BIAS_MODEL_MAX_WEIGHT 16            // still windows a node averages before it forgets
+#define BIAS_MODEL_CALIBRATION_WEIGHT 8     // windows a calibration restarts its node at
+#define BIAS_MODEL_SAVE_INTERVAL_MS 300000  // shortest time between NVS writes of the model
@@ -4,14 +4,44 @@
 #include <Adafruit_SSD1306.h>
 #include <Arduino.h>
 #include <MPU6050_light.h>
+#include <esp_timer.h>
 #include <shared_hardware_config.h>
 #include <stdint.h>
 
 #include "Button.h"
 #include "BuzzerController.h"
+#include "CalibrationStore.h"
+#include "AutoSubmitDetector.h"
+#include "BootSequencer.h"
+#include "DeadlineMonitor.h"
 #include "EspNowHelper.h"
+#include "EspNowLink.h"
+#include "EventQueue.h"
+#include "GyroBiasModel.h"
+#include "HotPath.h"
+#include "I2CBus.h"
+#include "I2CHealth.h"
+#include "InputCapture.h"
+#include "LinkProbe.h"
+#include "Log.h"
+#include "LoopProfiler.h"
+#include "MemoryMonitor.h"
 #include "OLEDController.h"
+#include "OffsetCalibrator.h"
+#include "OrientationHistory.h"
+#include "OrientationPredictor.h"
+#include "OrientationStream.h"
+#include "OrientationTarget.h"
+#include "PhaseScript.h"
+#include "PhaseScriptTransfer.h"
+#include "PowerManager.h"
+#include "SensorProfiles.h"
+#include "SessionCheckpoint.h"
+#include "StaticPool.h"
+#include "StillnessDetector.h"
 #include "Timer.h"
+#include "TimerWheel.h"
+#include "TraceRecorder.h"
 #include "Wire.h"
 #include "hardware_config.h"
 
@@ -25,16 +55,39 @@ uint8_t orientationSlave2Address[] = ORIENTATION_SLAVE_2_MAC_ADDRESS;
 
 EspNowHelper espNowHelper;
 
-unsigned long orientationRefreshTimer = 0;
+NvsCalibrationStorage calibrationStorage;
+CalibrationStore calibrationStore(calibrationStorage);
+NvsCalibrationStorage biasModelStorage("gyrobias");
+GyroBiasModel gyroBiasModel(biasModelStorage);
+unsigned long biasModelSaveTime = 0;
+bool calibrationUnsaved = false;  // offsets and model of a calibration not yet in NVS
+
 const unsigned long ORIENTATION_REFRESH_INTERVAL_MS = 100;
 
 unsigned long processingPhaseStartTime = 0;
 
-const int COUNTDOWN_SECONDS_BOOT = 5;
 const int COUNTDOWN_SECONDS_PHASE_START = 5;
 const int COUNTDOWN_SECONDS_INVALID_SUBMISSION = 4;
 const int COUNTDOWN_SECONDS_TIMEOUT_SUBMISSION = 4;
 
+int countdownSecondsLeft = 0;
+int countdownNextState = 0;
+
+const int LED_CHASE_STEP_MS = 25;
+const int LED_CHASE_LOCK_MS = 150;
+int ledChaseLocked = 0;  // LEDs already locked in green
+int ledChaseStep = 0;    // position of the chasing dot within the current lap
+
+BootSequencer bootSequencer;
+
+StaticPool<Button, 3> buttons;
+
+SessionSnapshot resumedSession;
+bool resumingSession = false;
+int64_t phaseSentUs = 0;     // master: when the phase in play went out to the slaves
+int rejoinAttemptsLeft = 0;  // slave: asks left before it gives up on the master's answer
+int loopDeadline = -1;
+
 const int STATE_BOOTING = -1;
 const int STATE_OFFSETS_SETUP = 0;
 const int STATE_PHASE_STAGED = 1;
@@ -50,7 +103,7 @@ const int STATE_TIMEOUT_SUBMISSION = 10;
 
 int currentState = STATE_BOOTING;
 int currentPhase = 0;
-bool phaseCompleted[NUM_PHASES] = {};
+bool phaseCompleted[MAX_PHASES] = {};
 
 #define NUM_LEDS 24
 CRGB leds[NUM_LEDS];
@@ -61,25 +114,37 @@ struct Orientation {
     int z;
 };
 
-const Orientation phaseTargets[NUM_PHASES] = {
-    {0, 0, 10},  // Phase 1
-    {0, 0, 15},  // Phase 2
-    {0, 0, 10}   // Phase 3
-};
+Orientation currentOrientation = {0, 0, 0};
+float angleZOffset = 0.0f;
 
-struct PhaseMeta {
-    bool isTimed;
-    int numSeconds;
-};
+OrientationHistory orientationHistory;
+OrientationPredictor orientationPredictor;
+OffsetCalibrator offsetCalibrator;
 
-const PhaseMeta phaseMetas[NUM_PHASES] = {
-    {false, 0},  // Phase 1 - untimed
-    {true, 20},  // Phase 2 - 20 seconds
-    {true, 30},  // Phase 3 - 30 seconds
-};
+StillnessDetector stillnessDetector;
+unsigned long gyroBiasReportTime = 0;
+unsigned long gyroBiasMotionTime = 0;  // last sample that was not at rest
+float calibratedGyroBias[3] = {};      // offsets of the last calibration, stored or fresh
+float calibratedTemperatureC = 0.0f;
 
-Orientation currentOrientation = {0, 0, 0};
-float angleZOffset = 0.0f;
+I2CHealth i2cHealth;
+uint8_t framebufferBackup[OLED_SCREEN_WIDTH * OLED_SCREEN_HEIGHT / 8];
+
+volatile SensorProfileId requestedSensorProfile = SENSOR_PROFILE_IDLE;
+int appliedSensorProfile = -1;  // none yet; forces the first apply
+unsigned long sensorPollTime = 0;
+
+EspPowerHal powerHal;
+PowerManager powerManager(powerHal);
+
+#ifdef AUTO_SUBMIT_ENABLED
+AutoSubmitDetector autoSubmitDetector(AUTO_SUBMIT_DWELL_MS, AUTO_SUBMIT_MAX_STDDEV);
+#endif
+
+#ifdef ORIENTATION_STREAM_ENABLED
+OrientationStreamEncoder orientationStream;
+StreamedOrientation streamedPlayers[NUM_PLAYERS];  // indexed like playerSubmissions
+#endif
 
 struct PlayerSubmission {
     uint8_t deviceId;
@@ -108,15 +173,71 @@ void setupDisplay();
 void setupMPU();
 void setupButtons();
 void setupEffects();
+void setupOffsets();
+void resumeOffsets();
+void showBootSplash();
+void setupTraceRecorder();
+
+#ifdef MATCH_BENCHMARK
+void runMatchBenchmark();
+#endif
 
 void calculateOffsets();
+bool restoreOffsets(bool requireStillness);
+bool offsetsHoldStill();
+void saveOffsets();
+
+void startRecalibration();
+void updateRecalibration();
+void applyRecalibratedOffsets();
+void reseedOrientation();
+
+void trackGyroBias();
+void resetGyroBiasTracking();
+bool isPlausibleGyroBias(float temperatureC, const float bias[3]);
+void setCalibratedGyroBias(const float offsets[3], float temperatureC);
+void seedGyroBiasModel();
+void applyGyroBiasModel();
+void saveCalibrationWhenIdle();
+
+void checkI2CHealth();
+void recoverI2CBus();
+
+SensorProfileId getSensorProfileForState(int state);
+void updateSensorProfile();
+bool sensorSampleDue();
+unsigned long msUntilNextSample();
+
+PowerMode getPowerModeForState(int state);
+void updatePowerMode();
+void boostPowerMode();
+void printWakeLatency();
+void waitForWork();
 
 void handleOffsetsButtonPressed(void* button_handle, void* usr_data);
-void handleSubmitPhaseButtonPressed(void* button_handle, void* usr_data);
+void handleSubmitPhasePressed(int64_t pressedAtUs);
 void handleLoadPhaseButtonPressed(void* button_handle, void* usr_data);
+void handleLoadPhasePressed();
 void handleTransmitButtonPressed(void* button_handle, void* usr_data);
+void handleTransmitPressed();
 
 void handleOrientationTimeout();
+void handleTimerExpired(TimerId id);
+void advanceCountdown();
+int getCountdownSeconds(int state);
+
+void processEvents();
+
+void receiveSubmissionFrame(const uint8_t* mac, const uint8_t* payload, size_t length);
+void receivePhaseFrame(const uint8_t* mac, const uint8_t* payload, size_t length);
+void receiveTransmissionFrame(const uint8_t* mac, const uint8_t* payload, size_t length);
+void receiveRejoinFrame(const uint8_t* mac, const uint8_t* payload, size_t length);
+void receiveSessionFrame(const uint8_t* mac, const uint8_t* payload, size_t length);
+void sendSubmission(const uint8_t* mac, int x, int y, int z, bool success);
+void sendPhase(const uint8_t* mac);
+void sendTransmission(const uint8_t* mac);
+void requestRejoin();
+uint32_t getPhaseTimeLeftMs();
 
 void handleSubmissionMessageFromSlave(const OrientationSubmissionMessage& message);
 void handleSubmissionMessageFromMaster(const OrientationSubmissionMessage& message);
@@ -129,11 +250,31 @@ void setCurrentState(const int state);
 void transitionTo(const int state);
 void transitionToAndThen(const int state, const int nextState);
 int getProcessingStateType();
+void resumeTimedPhase(uint32_t timeLeftMs);
+int getInitialState();
 
-void setCurrentOrientation();
-bool orientationMatches(const Orientation& target, int x, int y, int z);
+bool isResumableState(int state);
+void checkpointSession(int state);
+void resumeSession();
 
-void processOrientationMatch(uint16_t x, uint16_t y, uint16_t z);
+void setCurrentOrientation();
+void recordOrientationSample();
+void recordTraceSample();
+void processSerialCommands();
+OrientationSample getOrientationSampleAt(int64_t timestampUs);
+bool evaluateAutoSubmit();
+bool orientationMatches(const OrientationTarget& target, const OrientationSample& sample);
+
+void processOrientationMatch();
+void sendPredictedSubmission();
+
+void startOrientationStream();
+void stopOrientationStream();
+void streamOrientation();
+void receiveOrientationFrame(const uint8_t* mac, const uint8_t* payload, size_t length);
+void renderPlayerStatus();
+bool adoptPhaseScriptIfIdle();
+void renderPredictedOrientation();
 void processOrientationMismatch();
 void processSubmissionTimeout();
 
@@ -149,12 +290,13 @@ void completeTransmit();
 
 void playPhaseCompletionEffects(int completedPhase);
 void playTransmitCompletionEffects();
+void advanceLedChase();
 
 bool isCalibrated();
 
 // Returns true if all phases are completed
 bool isCalibrated() {
-  for (int i = 0; i < NUM_PHASES; i++) {
+  for (int i = 0; i < PhaseScript::getPhaseCount(); i++) {
     if (!phaseCompleted[i]) {
       return false;
     }
@@ -164,103 +306,178 @@ bool isCalibrated() {
 
 void setup() {
   Serial.begin(115200);
+  Log::begin();
+  EventQueue::begin();
+  TimerWheel::begin();
+  DeadlineMonitor::begin(&currentState, &getStateName);
+  loopDeadline = DeadlineMonitor::add("loop", DEADLINE_BOOT_MS);  // setup() runs on the loop task
+
+  I2CBus::begin();
+  delay(SENSOR_POWER_UP_DELAY_MS);
+
+  // A device reset mid-transfer can leave a slave holding SDA. The bus is freed here, before any
+  // boot step runs: once they start, only the step that owns Wire may touch it.
+  if (!I2CBus::probe(MPU_I2C_ADDRESS) || !I2CBus::probe(OLED_I2C_ADDRESS)) {
+    bool released = I2CBus::recover();
+    Serial.printf("I2C device not answering; bus reset, lines %s\n", released ? "free" : "stuck");
+  }
 
-  Wire.begin();
-  delay(2000);
-
-  setupESPNow();
-  setupDisplay();
-  setupMPU();
-
-  transitionTo(STATE_BOOTING);
-  transitionTo(STATE_OFFSETS_SETUP);
+  // Before the session is restored: a checkpoint is only good for the script it was taken under
+  PhaseScript::begin();
+  resumingSession = SessionCheckpoint::restore(resumedSession) &&
+                    resumedSession.phase <= PhaseScript::getPhaseCount();
+
+  // Independent steps overlap: radio, button, effects and trace setup run alongside the steps on
+  // the shared I2C bus. Those run one after another, since Wire is not safe to drive from two
+  // tasks at once. A device that reset mid-session skips the splash and rejoins straight away.
+  uint32_t displayReady = bootSequencer.addStep("display", &setupDisplay);
+  uint32_t mpuReady = bootSequencer.addStep("mpu", &setupMPU, displayReady);
+  if (resumingSession) {
+    bootSequencer.addStep("offsets", &resumeOffsets, mpuReady);
+  } else {
+    uint32_t splashShown = bootSequencer.addStep("splash", &showBootSplash, mpuReady);
+    bootSequencer.addStep("offsets", &setupOffsets, splashShown);
+  }
+  bootSequencer.addStep("espnow", &setupESPNow);
+  bootSequencer.addStep("buttons", &setupButtons);
+  bootSequencer.addStep("effects", &setupEffects);
+#ifdef TRACE_RECORDER_ENABLED
+  bootSequencer.addStep("trace", &setupTraceRecorder);
+#endif
+  bootSequencer.run();
 
-  calculateOffsets();
+#ifdef MATCH_BENCHMARK
+  runMatchBenchmark();
+#endif
 
-  setupButtons();
-  setupEffects();
+  if (resumingSession) {
+    resumeSession();
+  } else {
+    transitionTo(getInitialState());
+  }
 
-#ifdef DEVICE_ROLE_MASTER
-  transitionTo(STATE_PHASE_STAGED);
-#endif
-#ifdef DEVICE_ROLE_SLAVE_1
-  transitionTo(STATE_SLAVE_WAITING);
-#endif
-#ifdef DEVICE_ROLE_SLAVE_2
-  transitionTo(STATE_SLAVE_WAITING);
+  bootSequencer.printTimeline(esp_timer_get_time());
+  MemoryMonitor::seal();
+  DeadlineMonitor::setPeriod(loopDeadline, DEADLINE_LOOP_MS);
+  DeadlineMonitor::checkIn(loopDeadline);
+#ifdef LOOP_PROFILER_ENABLED
+  LoopProfiler::begin();
 #endif
 }
 
-void loop() {
-  mpu.update();
+void HOT_CODE loop() {
+  DeadlineMonitor::checkIn(loopDeadline);
+  waitForWork();
+#ifdef LOOP_PROFILER_ENABLED
+  LoopProfiler::Scope profile;  // the rest of the pass, whichever way it returns
+#endif
+  updatePowerMode();
+  updateSensorProfile();
+
+  if (sensorSampleDue()) {
+    mpu.update();
+    DeadlineMonitor::noteSensorUpdate();
+    checkI2CHealth();
+    recordOrientationSample();
+    recordTraceSample();
+    updateRecalibration();
+    trackGyroBias();
+    saveCalibrationWhenIdle();
+    applyGyroBiasModel();  // last, so everything above read the sample as it was corrected
+  }
+
+  processEvents();
+  processSerialCommands();
+  MemoryMonitor::poll();
 
   if (currentState != STATE_PROCESSING && currentState != STATE_TIMED_PROCESSING) {
     return;  // Skip processing if we are in a non-processing state
   }
 
-  if (currentState == STATE_TIMED_PROCESSING) {
-    unsigned long timeoutMs = (unsigned long)phaseMetas[currentPhase].numSeconds * 1000UL;
-    if (millis() - processingPhaseStartTime >= timeoutMs) {
-      Serial.println("Processing timer expired. Restarting phase.");
-      handleOrientationTimeout();
-      return;
-    }
-  }
-
-  if ((millis() - orientationRefreshTimer) > ORIENTATION_REFRESH_INTERVAL_MS) {
-    setCurrentOrientation();
+#ifdef AUTO_SUBMIT_ENABLED
+  evaluateAutoSubmit();
+#endif
+}
 
-    if (currentState == STATE_TIMED_PROCESSING) {
-      unsigned long timeoutMs = (unsigned long)phaseMetas[currentPhase].numSeconds * 1000UL;
-      OLEDController::renderOrientationValues(oled, currentOrientation.x, currentOrientation.y,
-                                              currentOrientation.z, false);
-      Timer::drawHorizontalTimer(oled, processingPhaseStartTime, timeoutMs);
-    } else {
-      OLEDController::renderOrientationValues(oled, currentOrientation.x, currentOrientation.y,
-                                              currentOrientation.z, true);
-    }
+// Shows where the device will be when the flush completes rather than where it was when last
+// sampled, and feeds the measured sample-to-flush time back into the estimate
+void HOT_CODE renderPredictedOrientation() {
+  int64_t sampledUs = orientationHistory.newest().timestampUs;
+  OrientationSample shown = orientationPredictor.predictAhead(LATENCY_PATH_DISPLAY);
 
-    orientationRefreshTimer = millis();
+  if (currentState == STATE_TIMED_PROCESSING) {
+    unsigned long timeoutMs = PhaseScript::getTimeLimitSeconds(currentPhase) * 1000UL;
+    OLEDController::renderOrientationValues(oled, (int)shown.x, (int)shown.y, (int)shown.z,
+                                            false);
+    Timer::drawHorizontalTimer(oled, processingPhaseStartTime, timeoutMs);
+  } else {
+    OLEDController::renderOrientationValues(oled, (int)shown.x, (int)shown.y, (int)shown.z,
+                                            true);
   }
+
+  orientationPredictor.observeLatency(LATENCY_PATH_DISPLAY,
+                                      (uint32_t)(esp_timer_get_time() - sampledUs));
 }
 
+// EspNowHelper brings up the radio and announces the module to the hub; traffic between
+// orientation modules goes over EspNowLink
 void setupESPNow() {
   espNowHelper.begin(DEVICE_ID);
+  EspNowLink::begin();
+  LinkProbe::begin();
 
 #ifdef DEVICE_ROLE_MASTER
   Serial.println("Device role: MASTER");
   espNowHelper.addPeer(hubAddress);
   espNowHelper.addPeer(orientationSlave1Address);
   espNowHelper.addPeer(orientationSlave2Address);
+  LinkProbe::addPeer("hub", hubAddress, false);
+  LinkProbe::addPeer("slave 1", orientationSlave1Address, true);
+  LinkProbe::addPeer("slave 2", orientationSlave2Address, true);
+  PhaseScriptTransfer::addPeer(orientationSlave1Address);
+  PhaseScriptTransfer::addPeer(orientationSlave2Address);
+  PhaseScriptTransfer::beginMaster();
+
+  LinkProbe::noteSend(hubAddress, esp_timer_get_time());
   espNowHelper.sendModuleConnected(hubAddress);
 
-  espNowHelper.registerOrientationMessageHandler(&handleSubmissionMessageFromSlave);
+  EspNowLink::registerHandler(LINK_FRAME_SUBMISSION, &receiveSubmissionFrame);
+  EspNowLink::registerHandler(LINK_FRAME_REJOIN, &receiveRejoinFrame);
+#ifdef ORIENTATION_STREAM_ENABLED
+  EspNowLink::registerHandler(LINK_FRAME_ORIENTATION, &receiveOrientationFrame);
+#endif
 #endif
 
+#if defined(DEVICE_ROLE_SLAVE_1) || defined(DEVICE_ROLE_SLAVE_2)
 #ifdef DEVICE_ROLE_SLAVE_1
   Serial.println("Device role: SLAVE 1");
-  espNowHelper.addPeer(orientationMasterAddress);
-
-  espNowHelper.registerOrientationMessageHandler(&handleSubmissionMessageFromMaster);
-  espNowHelper.registerOrientationPhaseMessageHandler(&handlePhaseMessageFromMaster);
-  espNowHelper.registerOrientationTransmissionHandler(&handleTransmissionMessageFromMaster);
-#endif
-
-#ifdef DEVICE_ROLE_SLAVE_2
+#else
   Serial.println("Device role: SLAVE 2");
+#endif
   espNowHelper.addPeer(orientationMasterAddress);
+  LinkProbe::addPeer("master", orientationMasterAddress, true);
+  PhaseScriptTransfer::beginSlave();
 
-  espNowHelper.registerOrientationMessageHandler(&handleSubmissionMessageFromMaster);
-  espNowHelper.registerOrientationPhaseMessageHandler(&handlePhaseMessageFromMaster);
-  espNowHelper.registerOrientationTransmissionHandler(&handleTransmissionMessageFromMaster);
+  EspNowLink::registerHandler(LINK_FRAME_SUBMISSION, &receiveSubmissionFrame);
+  EspNowLink::registerHandler(LINK_FRAME_PHASE, &receivePhaseFrame);
+  EspNowLink::registerHandler(LINK_FRAME_TRANSMISSION, &receiveTransmissionFrame);
+  EspNowLink::registerHandler(LINK_FRAME_SESSION, &receiveSessionFrame);
 #endif
 }
 
 void setupDisplay() {
   Serial.println("Initializing OLED display...");
-  if (!oled.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS)) {
-    Serial.println("  ✗ SSD1306 allocation failed");
-    while (true);
+
+  unsigned long start = millis();
+  bool initialized = oled.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS, true, false);
+  while (!initialized && millis() - start < DISPLAY_INIT_TIMEOUT_MS) {
+    delay(10);
+    initialized = oled.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS, true, false);
+  }
+
+  if (!initialized) {
+    Serial.println("  ✗ SSD1306 initialization failed, continuing without display");
+    return;
   }
   Serial.println("  ✓ OLED display initialized.");
 }
@@ -268,32 +485,43 @@ void setupDisplay() {
 void setupMPU() {
   Serial.println("Initializing MPU6050...");
 
+  unsigned long start = millis();
   byte status = mpu.begin();
-  Serial.printf("  MPU6050 status: %d\n", status);
-  while (status != 0) {
-  }  // stop everything if could not connect to MPU6050
+  while (status != 0 && millis() - start < MPU_INIT_TIMEOUT_MS) {
+    delay(10);
+    status = mpu.begin();
+  }
 
+  Serial.printf("  MPU6050 status: %d\n", status);
+  if (status != 0) {
+    Serial.println("  ✗ MPU6050 not responding");
+    return;
+  }
   Serial.println("  ✓ MPU6050 initialized.");
 }
 
 void setupButtons() {
-  Button* resetOffsetsButton = new Button(RESET_OFFSETS_BUTTON_PIN, false);
+  Button* resetOffsetsButton = buttons.create(RESET_OFFSETS_BUTTON_PIN, false);
   resetOffsetsButton->attachPressDownEventCb(&handleOffsetsButtonPressed, NULL);
 
-  Button* submitButton = new Button(SUBMIT_PHASE_BUTTON_PIN, false);
-  submitButton->attachPressDownEventCb(&handleSubmitPhaseButtonPressed, NULL);
+  InputCapture::attach(SUBMIT_PHASE_BUTTON_PIN, EVENT_SUBMIT_PRESSED);
 
 #ifdef DEVICE_ROLE_MASTER
   Serial.println("Setting up master load phase button...");
-  Button* masterLoadPhaseButton = new Button(LOAD_PHASE_BUTTON_PIN, false);
+  Button* masterLoadPhaseButton = buttons.create(LOAD_PHASE_BUTTON_PIN, false);
   masterLoadPhaseButton->attachPressDownEventCb(&handleLoadPhaseButtonPressed, NULL);
 
   Serial.println("Setting up master transmit button...");
-  Button* masterTransmitButton = new Button(TRANSMIT_BUTTON_PIN, false);
+  Button* masterTransmitButton = buttons.create(TRANSMIT_BUTTON_PIN, false);
   masterTransmitButton->attachPressDownEventCb(&handleTransmitButtonPressed, NULL);
 #endif
 }
 
+void setupTraceRecorder() {
+  Serial.println("Initializing trace recorder...");
+  TraceRecorder::begin();
+}
+
 void setupEffects() {
 #ifdef DEVICE_ROLE_MASTER
   FastLED.addLeds<WS2812, LED_RING_PIN, GRB>(leds, NUM_LEDS);
@@ -305,69 +533,563 @@ void setupEffects() {
 #endif
 }
 
+void showBootSplash() {
+  transitionTo(STATE_BOOTING);
+}
+
+// Stored offsets that still hold skip the full calibration
+void setupOffsets() {
+  gyroBiasModel.load();
+  if (!restoreOffsets(true)) {
+    transitionTo(STATE_OFFSETS_SETUP);
+    calculateOffsets();
+  }
+}
+
+// Mid-session the device is likely in a player's hand, so the stillness check is skipped
+void resumeOffsets() {
+  gyroBiasModel.load();
+  if (!restoreOffsets(false)) {
+    transitionTo(STATE_OFFSETS_SETUP);
+    calculateOffsets();
+  }
+}
+
 void calculateOffsets() {
   Serial.println("Calculating MPU6050 offsets, do not move MPU6050");
   delay(1000);
   mpu.calcOffsets(CALCULATE_OFFSET_GYRO, CALCULATE_OFFSET_ACCEL);
   delay(1000);
+  seedGyroBiasModel();
+  resetGyroBiasTracking();
+}
+
+// Reuses offsets from an earlier boot when they still describe this sensor: the die temperature
+// is close to the one at capture time and a still device reads ~0 deg/s and ~1 g with them applied
+bool restoreOffsets(bool requireStillness) {
+  CalibrationRecord record;
+  if (!calibrationStore.load(record)) {
+    Serial.println("  No valid stored MPU6050 offsets");
+    return false;
+  }
+
+  mpu.setGyroOffsets(record.gyroOffsets[0], record.gyroOffsets[1], record.gyroOffsets[2]);
+  mpu.setAccOffsets(record.accOffsets[0], record.accOffsets[1], record.accOffsets[2]);
+  setCalibratedGyroBias(record.gyroOffsets, record.temperatureC);
+  mpu.update();
+
+  // Stored gyro offsets only go stale with temperature where the bias model has not learned
+  float temperatureDrift = fabsf(mpu.getTemp() - record.temperatureC);
+  if (gyroBiasModel.covers(mpu.getTemp())) {
+    applyGyroBiasModel();
+    mpu.update();
+  } else if (temperatureDrift > CALIBRATION_MAX_TEMP_DRIFT_C) {
+    Serial.printf("  Stored offsets stale: temperature moved %.1f C\n", temperatureDrift);
+    return false;
+  }
+
+  if (requireStillness && !offsetsHoldStill()) {
+    Serial.println("  Stored offsets stale: device not reading still");
+    return false;
+  }
+
+  Serial.println("  ✓ Restored stored MPU6050 offsets");
+  return true;
+}
+
+bool offsetsHoldStill() {
+  float gyroSum[3] = {0.0f, 0.0f, 0.0f};
+  float accelMagnitudeSum = 0.0f;
+  int samples = 0;
+
+  unsigned long start = millis();
+  while (millis() - start < CALIBRATION_STILLNESS_CHECK_MS) {
+    mpu.update();
+    gyroSum[0] += mpu.getGyroX();
+    gyroSum[1] += mpu.getGyroY();
+    gyroSum[2] += mpu.getGyroZ();
+    float ax = mpu.getAccX(), ay = mpu.getAccY(), az = mpu.getAccZ();
+    accelMagnitudeSum += sqrtf(ax * ax + ay * ay + az * az);
+    samples++;
+    delay(1);
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (fabsf(gyroSum[axis] / samples) > CALIBRATION_MAX_GYRO_BIAS_DPS) {
+      return false;
+    }
+  }
+  return fabsf(accelMagnitudeSum / samples - 1.0f) <= CALIBRATION_MAX_ACCEL_ERROR_G;
+}
+
+// Zero-velocity update: whatever the gyro reads while the device is at rest is bias. Each
+// GYRO_BIAS_MIN_STILL_MS of rest is averaged and learned into the bias model at the current die
+// temperature, which then corrects every sample, including those taken in motion as the device
+// warms up. A slow turn that passes the stillness checks rarely holds that steady for that long.
+void trackGyroBias() {
+  float gyro[3] = {mpu.getGyroX(), mpu.getGyroY(), mpu.getGyroZ()};
+  float acc[3] = {mpu.getAccX(), mpu.getAccY(), mpu.getAccZ()};
+  stillnessDetector.addSample(gyro, acc);
+
+  if (!stillnessDetector.isStill() || offsetCalibrator.isRunning()) {
+    gyroBiasMotionTime = millis();
+    return;
+  }
+  if (millis() - gyroBiasMotionTime < GYRO_BIAS_MIN_STILL_MS) {
+    return;
+  }
+  gyroBiasMotionTime = millis();  // the next estimate needs a rest of its own
+
+  float residual[3];
+  stillnessDetector.getRunMean(residual);
+  stillnessDetector.restartRun();
+  float temperatureC = mpu.getTemp();
+  float bias[3] = {mpu.getGyroXoffset() + residual[0], mpu.getGyroYoffset() + residual[1],
+                   mpu.getGyroZoffset() + residual[2]};
+  if (!isPlausibleGyroBias(temperatureC, bias)) {
+    LOG_WARN(LOG_CAT_SENSOR, "Gyro bias Z %.3f deg/s at %.1f C too far from calibration to learn",
+             bias[2], temperatureC);
+    return;
+  }
+  gyroBiasModel.observe(temperatureC, bias, 1);
+
+  if (millis() - gyroBiasReportTime >= GYRO_BIAS_REPORT_INTERVAL_MS) {
+    LOG_INFO(LOG_CAT_SENSOR,
+             "Gyro bias model: Z residual %.3f deg/s (%.1f deg/min of yaw drift) at %.1f C, "
+             "%d nodes learned",
+             residual[2], residual[2] * 60.0f, temperatureC, gyroBiasModel.getLearnedNodes());
+    gyroBiasReportTime = millis();
+  }
+}
+
+// An NVS write stalls the loop for a few milliseconds; never while a phase is played. A
+// calibration is written at the first chance, what the model learns at most once an interval.
+void saveCalibrationWhenIdle() {
+  if (currentState == STATE_PROCESSING || currentState == STATE_TIMED_PROCESSING) {
+    return;
+  }
+  if (calibrationUnsaved) {
+    saveOffsets();
+    calibrationUnsaved = false;
+  } else if (!gyroBiasModel.isDirty() ||
+             millis() - biasModelSaveTime < BIAS_MODEL_SAVE_INTERVAL_MS) {
+    return;
+  }
+  gyroBiasModel.save();
+  biasModelSaveTime = millis();
+}
+
+void resetGyroBiasTracking() {
+  stillnessDetector.reset();
+  gyroBiasMotionTime = millis();
+}
+
+// Bias moves with temperature, but only so far: a rest that disagrees with the calibration by
+// more than that is taken for a slow turn, which would otherwise be learned and saved
+bool isPlausibleGyroBias(float temperatureC, const float bias[3]) {
+  float limit = GYRO_BIAS_MAX_DEVIATION_DPS +
+                GYRO_BIAS_TEMPCO_DPS_PER_C * fabsf(temperatureC - calibratedTemperatureC);
+  for (int axis = 0; axis < 3; axis++) {
+    if (fabsf(bias[axis] - calibratedGyroBias[axis]) > limit) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void setCalibratedGyroBias(const float offsets[3], float temperatureC) {
+  memcpy(calibratedGyroBias, offsets, sizeof(calibratedGyroBias));
+  calibratedTemperatureC = temperatureC;
+}
+
+// A full calibration is a good measurement of the bias at the temperature it ran at. Both it and
+// the model are saved once no phase is played.
+void seedGyroBiasModel() {
+  float offsets[3] = {mpu.getGyroXoffset(), mpu.getGyroYoffset(), mpu.getGyroZoffset()};
+  setCalibratedGyroBias(offsets, mpu.getTemp());
+  gyroBiasModel.calibrate(mpu.getTemp(), offsets);
+  calibrationUnsaved = true;
+}
+
+// The offsets for the next sample, from the temperature of this one
+void HOT_CODE applyGyroBiasModel() {
+  if (gyroBiasModel.isEmpty() || offsetCalibrator.isRunning()) {
+    return;
+  }
+  float bias[3];
+  gyroBiasModel.lookup(mpu.getTemp(), bias);
+  mpu.setGyroOffsets(bias[0], bias[1], bias[2]);
+}
+
+void checkI2CHealth() {
+  float reading[6] = {mpu.getAccX(),  mpu.getAccY(),  mpu.getAccZ(),
+                      mpu.getGyroX(), mpu.getGyroY(), mpu.getGyroZ()};
+  if (i2cHealth.check(reading, millis())) {
+    recoverI2CBus();
+  }
+}
+
+void recoverI2CBus() {
+  i2cHealth.noteRecovery(millis());
+  int64_t start = esp_timer_get_time();
+
+  uint8_t* framebuffer = oled.getBuffer();
+  if (framebuffer != nullptr) {
+    memcpy(framebufferBackup, framebuffer, sizeof(framebufferBackup));
+  }
+
+  bool released = I2CBus::recover();
+  bool mpuReady = mpu.begin() == 0;
+  appliedSensorProfile = -1;  // begin() restored the register defaults
+  bool oledReady = oled.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS, false, false);
+  if (oledReady && framebuffer != nullptr) {
+    memcpy(oled.getBuffer(), framebufferBackup, sizeof(framebufferBackup));
+    oled.display();
+  }
+
+  uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - start);
+  bool succeeded = released && mpuReady && oledReady;
+  I2CBus::recordRecovery(succeeded, elapsedUs);
+
+  LOG_WARN(LOG_CAT_SENSOR, "I2C bus recovery %s in %u us (bus %s, MPU6050 %s, OLED %s)",
+           succeeded ? "succeeded" : "failed", elapsedUs, released ? "ok" : "stuck",
+           mpuReady ? "ok" : "down", oledReady ? "ok" : "down");
+  if (elapsedUs > I2C_RECOVERY_BUDGET_MS * 1000UL) {
+    LOG_WARN(LOG_CAT_SENSOR, "  ✗ Recovery exceeded its time budget");
+  }
+}
+
+// Countdowns into processing already run the active profile so its filter has settled
+SensorProfileId getSensorProfileForState(int state) {
+  switch (state) {
+    case STATE_PHASE_LOADING:
+    case STATE_PROCESSING:
+    case STATE_TIMED_PROCESSING:
+    case STATE_INVALID_SUBMISSION:
+      return SENSOR_PROFILE_ACTIVE;
+    default:
+      return SENSOR_PROFILE_IDLE;
+  }
+}
+
+// Applied from loop() so register writes never interleave with an update() in progress
+void updateSensorProfile() {
+  SensorProfileId requested = requestedSensorProfile;
+  if (requested == appliedSensorProfile) {
+    return;
+  }
+
+  const SensorProfile& profile = SensorProfiles::get(requested);
+  if (SensorProfiles::apply(mpu, profile)) {
+    appliedSensorProfile = requested;
+    LOG_INFO(LOG_CAT_SENSOR, "Sensor profile: %s", profile.name);
+  }
+}
+
+unsigned long msUntilNextSample() {
+  if (appliedSensorProfile < 0) {
+    return 0;
+  }
+
+  const SensorProfile& profile = SensorProfiles::get((SensorProfileId)appliedSensorProfile);
+  unsigned long elapsed = millis() - sensorPollTime;
+  return elapsed >= profile.pollIntervalMs ? 0 : profile.pollIntervalMs - elapsed;
+}
+
+// Only the waiting screens idle; anything with a countdown, a live readout or effects stays at
+// full clock
+PowerMode getPowerModeForState(int state) {
+  switch (state) {
+    case STATE_PHASE_STAGED:
+    case STATE_MASTER_WAITING:
+    case STATE_SLAVE_WAITING:
+    case STATE_TRANSMIT_STAGED:
+    case STATE_TRANSMIT_COMPLETE:
+      return POWER_MODE_IDLE;
+    default:
+      return POWER_MODE_ACTIVE;
+  }
+}
+
+void updatePowerMode() {
+  if (!powerManager.apply()) {
+    return;
+  }
+
+  if (powerManager.getMode() == POWER_MODE_IDLE) {
+    LOG_INFO(LOG_CAT_POWER, "Power mode: idle (%d MHz)", IDLE_CPU_FREQ_MHZ);
+  } else {
+    LOG_INFO(LOG_CAT_POWER, "Power mode: active (%d MHz)", ACTIVE_CPU_FREQ_MHZ);
+  }
+}
+
+// Every screen is drawn at full clock. If the new state idles, the next loop() pass drops back.
+void boostPowerMode() {
+  if (powerManager.getMode() == POWER_MODE_IDLE) {
+    powerManager.boost();
+    LOG_INFO(LOG_CAT_POWER, "Power mode: active (%d MHz)", ACTIVE_CPU_FREQ_MHZ);
+  }
+}
+
+void printWakeLatency() {
+  LOG_INFO(LOG_CAT_POWER, "Wake-to-render: last %lld us, avg %lld us, max %lld us over %u wakes",
+           powerManager.getLastLatencyUs(), powerManager.getAverageLatencyUs(),
+           powerManager.getMaxLatencyUs(), powerManager.getWakeCount());
+}
+
+bool HOT_CODE sensorSampleDue() {
+  if (appliedSensorProfile < 0) {
+    return true;
+  }
+
+  const SensorProfile& profile = SensorProfiles::get((SensorProfileId)appliedSensorProfile);
+  if (millis() - sensorPollTime < profile.pollIntervalMs) {
+    return false;
+  }
+  sensorPollTime = millis();
+  return true;
+}
+
+// The gyro offsets as calibrated; the bias model may have moved the live ones since
+void saveOffsets() {
+  float accOffsets[3] = {mpu.getAccXoffset(), mpu.getAccYoffset(), mpu.getAccZoffset()};
+  if (!calibrationStore.save(calibratedGyroBias, accOffsets, calibratedTemperatureC)) {
+    LOG_ERROR(LOG_CAT_SENSOR, "  ✗ Failed to store MPU6050 offsets");
+  }
 }
 
 void handleOffsetsButtonPressed(void* button_handle, void* usr_data) {
-  Serial.println("Offsets button pressed");
+  TraceRecorder::recordButton(esp_timer_get_time(), RESET_OFFSETS_BUTTON_PIN);
+  LOG_INFO(LOG_CAT_INPUT, "Offsets button pressed");
 
   if (currentState != STATE_PROCESSING && currentState != STATE_TIMED_PROCESSING) {
     return;
   }
 
-  int oldState = currentState;
-  transitionTo(STATE_OFFSETS_SETUP);
+  EventQueue::post({EVENT_RECALIBRATE_REQUESTED, esp_timer_get_time()});
+}
+
+// Recalibration runs in the background from the live sample stream, so the phase keeps going
+void startRecalibration() {
+  LOG_INFO(LOG_CAT_SENSOR, "Recalibrating offsets in the background, hold the device still");
+  offsetCalibrator.start(esp_timer_get_time());
+}
+
+void updateRecalibration() {
+  if (!offsetCalibrator.isRunning()) {
+    return;
+  }
+
+  float rawGyro[3] = {mpu.getGyroX() + mpu.getGyroXoffset(), mpu.getGyroY() + mpu.getGyroYoffset(),
+                      mpu.getGyroZ() + mpu.getGyroZoffset()};
+  float rawAcc[3] = {mpu.getAccX() + mpu.getAccXoffset(), mpu.getAccY() + mpu.getAccYoffset(),
+                     mpu.getAccZ() + mpu.getAccZoffset()};
+
+  switch (offsetCalibrator.addSample(rawGyro, rawAcc, esp_timer_get_time())) {
+    case RECALIBRATION_DONE:
+      applyRecalibratedOffsets();
+      break;
+    case RECALIBRATION_TIMED_OUT:
+      LOG_WARN(LOG_CAT_SENSOR, "  ✗ Recalibration timed out, keeping previous offsets");
+      break;
+    default:
+      break;
+  }
+}
+
+// Called from loop() between updates, so the sensor never sees a half-applied set of offsets
+void applyRecalibratedOffsets() {
+  float gyroOffsets[3];
+  float accOffsets[3];
+  offsetCalibrator.getOffsets(gyroOffsets, accOffsets);
+
+  if (CALCULATE_OFFSET_GYRO) {
+    mpu.setGyroOffsets(gyroOffsets[0], gyroOffsets[1], gyroOffsets[2]);
+  }
+  if (CALCULATE_OFFSET_ACCEL) {
+    mpu.setAccOffsets(accOffsets[0], accOffsets[1], accOffsets[2]);
+  }
 
-  calculateOffsets();              // compute new bias offsets at current position first
-  setupMPU();                      // re-init: seeds angleX/Y from accelerometer using new offsets
-  angleZOffset = mpu.getAngleZ();  // angleZ is gyro-only and never reset by begin() -- snapshot it
+  reseedOrientation();
+  angleZOffset = mpu.getAngleZ();  // angleZ is gyro-only and never reseeded -- snapshot it
+  seedGyroBiasModel();
+  resetGyroBiasTracking();
 
-  transitionTo(oldState);
+  LOG_INFO(LOG_CAT_SENSOR, "  ✓ Offsets recalibrated");
 }
 
-void handleSubmitPhaseButtonPressed(void* button_handle, void* usr_data) {
-  Serial.println("Submit phase button pressed");
+// One update with the gyro weight at zero sets angleX/Y straight from the accelerometer, which is
+// what begin() does, without reinitializing the sensor
+void reseedOrientation() {
+  float gyroCoefficient = mpu.getFilterGyroCoef();
+  mpu.setFilterGyroCoef(0.0f);
+  mpu.update();
+  mpu.setFilterGyroCoef(gyroCoefficient);
+}
+
+// Waiting states block on the event queue between sensor polls instead of spinning, so the
+// idle task can clock-gate the CPU until a button, a message or the next poll is due
+void waitForWork() {
+  if (powerManager.getMode() != POWER_MODE_IDLE) {
+    return;
+  }
+  EventQueue::waitForEvent(pdMS_TO_TICKS(msUntilNextSample()));
+}
+
+void HOT_CODE processEvents() {
+  Event event;
+  while (EventQueue::poll(event)) {
+    DeadlineMonitor::noteEvent(event);
+    switch (event.type) {
+      case EVENT_SUBMIT_PRESSED:
+        powerManager.markWake(event.timestampUs);
+        TraceRecorder::recordButton(event.timestampUs, SUBMIT_PHASE_BUTTON_PIN);
+        handleSubmitPhasePressed(event.timestampUs);
+        break;
+      case EVENT_RECALIBRATE_REQUESTED:
+        powerManager.markWake(event.timestampUs);
+        startRecalibration();
+        break;
+      case EVENT_LOAD_PHASE_PRESSED:
+        powerManager.markWake(event.timestampUs);
+        TraceRecorder::recordButton(event.timestampUs, LOAD_PHASE_BUTTON_PIN);
+        handleLoadPhasePressed();
+        break;
+      case EVENT_TRANSMIT_PRESSED:
+        powerManager.markWake(event.timestampUs);
+        TraceRecorder::recordButton(event.timestampUs, TRANSMIT_BUTTON_PIN);
+        handleTransmitPressed();
+        break;
+      case EVENT_WAKE:
+        break;
+      case EVENT_TIMER_EXPIRED: {
+        TimerId id;
+        if (TimerWheel::claimExpiry(event.value, id)) {
+          handleTimerExpired(id);
+        }
+        break;
+      }
+      case EVENT_LINK_MESSAGE:
+        EspNowLink::service();
+        break;
+      case EVENT_CHECKPOINT:
+        SessionCheckpoint::journal();
+        break;
+      case EVENT_SCRIPT_FRAME:
+        PhaseScriptTransfer::service();
+        if (adoptPhaseScriptIfIdle()) {
+          transitionTo(currentState);  // redraw with the new phases
+        }
+        break;
+    }
+  }
+}
+
+void handleTimerExpired(TimerId id) {
+  switch (id) {
+    case TIMER_PHASE_TIMEOUT:
+      if (currentState == STATE_TIMED_PROCESSING) {
+        LOG_INFO(LOG_CAT_STATE, "Processing timer expired. Restarting phase.");
+        handleOrientationTimeout();
+      }
+      break;
+    case TIMER_ORIENTATION_REFRESH:
+      if (currentState == STATE_PROCESSING || currentState == STATE_TIMED_PROCESSING) {
+        setCurrentOrientation();
+        renderPredictedOrientation();
+        checkpointSession(currentState);  // RTC only, so a reset keeps the yaw turned since
+        TimerWheel::schedule(TIMER_ORIENTATION_REFRESH, ORIENTATION_REFRESH_INTERVAL_MS * 1000UL);
+      }
+      break;
+    case TIMER_COUNTDOWN:
+      advanceCountdown();
+      break;
+    case TIMER_MELODY:
+      BuzzerController::advance();
+      break;
+    case TIMER_LED_ANIMATION:
+      advanceLedChase();
+      break;
+    case TIMER_LINK_PROBE:
+      LinkProbe::probe();
+      break;
+    case TIMER_ORIENTATION_STREAM:
+      streamOrientation();
+      break;
+    case TIMER_PLAYER_STATUS:
+      if (currentState == STATE_MASTER_WAITING) {
+        renderPlayerStatus();
+      }
+      break;
+    case TIMER_SCRIPT_OFFER:
+      PhaseScriptTransfer::offer();
+      break;
+    case TIMER_SCRIPT_TRANSFER:
+      PhaseScriptTransfer::retry();
+      break;
+    case TIMER_LINK_FLUSH:
+      EspNowLink::flush();
+      break;
+    case TIMER_REJOIN:
+      requestRejoin();
+      break;
+    default:
+      break;
+  }
+}
+
+// Judged against the orientation at the moment of the press, not the last display refresh
+void handleSubmitPhasePressed(int64_t pressedAtUs) {
+  LOG_INFO(LOG_CAT_INPUT, "Submit phase button pressed");
 
   if (currentState != STATE_PROCESSING && currentState != STATE_TIMED_PROCESSING) {
     return;
   }
 
-  if (currentPhase >= NUM_PHASES) {
+  if (currentPhase >= PhaseScript::getPhaseCount()) {
     return;
   }
 
-  int x = currentOrientation.x;
-  int y = currentOrientation.y;
-  int z = currentOrientation.z;
-  Serial.printf("Current orientation: x=%d, y=%d, z=%d\n", x, y, z);
+  OrientationSample pressed = getOrientationSampleAt(pressedAtUs);
+  int x = (int)pressed.x;
+  int y = (int)pressed.y;
+  int z = (int)pressed.z;
+  LOG_INFO(LOG_CAT_INPUT, "Orientation at press: x=%d, y=%d, z=%d", x, y, z);
 
-  const Orientation& target = phaseTargets[currentPhase];
-  if (orientationMatches(target, x, y, z)) {
-    processOrientationMatch(x, y, z);
+  const OrientationTarget& target = PhaseScript::getTarget(currentPhase);
+  if (orientationMatches(target, pressed)) {
+    processOrientationMatch();
   } else {
     processOrientationMismatch();
   }
 }
 
+// The button library calls these from its own task, so the press is handed to the loop, which
+// owns the state machine and the link's outboxes
 void handleLoadPhaseButtonPressed(void* button_handle, void* usr_data) {
-  Serial.println("Master load phase button pressed");
+  EventQueue::post({EVENT_LOAD_PHASE_PRESSED, esp_timer_get_time()});
+}
+
+void handleTransmitButtonPressed(void* button_handle, void* usr_data) {
+  EventQueue::post({EVENT_TRANSMIT_PRESSED, esp_timer_get_time()});
+}
+
+void handleLoadPhasePressed() {
+  LOG_INFO(LOG_CAT_INPUT, "Master load phase button pressed");
 
   if (currentState != STATE_PHASE_STAGED) {
     return;
   }
 
-  espNowHelper.sendOrientationPhaseUpdated(orientationSlave1Address, currentPhase);
-  espNowHelper.sendOrientationPhaseUpdated(orientationSlave2Address, currentPhase);
+  phaseSentUs = esp_timer_get_time();
+  sendPhase(orientationSlave1Address);
+  sendPhase(orientationSlave2Address);
 
   transitionToAndThen(STATE_PHASE_LOADING, getProcessingStateType());
 }
 
-void handleTransmitButtonPressed(void* button_handle, void* usr_data) {
-  Serial.println("Master transmit button pressed");
+void handleTransmitPressed() {
+  LOG_INFO(LOG_CAT_INPUT, "Master transmit button pressed");
 
   if (currentState != STATE_TRANSMIT_STAGED) {
     return;
@@ -380,8 +1102,13 @@ void handleTransmitButtonPressed(void* button_handle, void* usr_data) {
 
 // Slave -> Master: Slave submitted orientation match for current phase
 void handleSubmissionMessageFromSlave(const OrientationSubmissionMessage& message) {
-  Serial.printf("Received orientation message from slave module: %d\n", message.deviceId);
-  Serial.printf("  Roll: %d, Pitch: %d, Yaw: %d\n", message.roll, message.pitch, message.yaw);
+  powerManager.markWake(esp_timer_get_time());
+  TraceRecorder::recordMessage(esp_timer_get_time(), TRACE_MESSAGE_SUBMISSION, &message,
+                               sizeof(message));
+  LOG_INFO(LOG_CAT_RADIO, "Received orientation message from slave module: %d",
+           message.deviceId);
+  LOG_INFO(LOG_CAT_RADIO, "  Roll: %d, Pitch: %d, Yaw: %d", message.roll, message.pitch,
+           message.yaw);
 
   if (message.success) {
     submitAndPossiblyCompletePhase(message.deviceId);
@@ -392,8 +1119,13 @@ void handleSubmissionMessageFromSlave(const OrientationSubmissionMessage& messag
 
 // Master -> Slave: Master submitted orientation (timeout only)
 void handleSubmissionMessageFromMaster(const OrientationSubmissionMessage& message) {
-  Serial.printf("Received orientation message from master module: %d\n", message.deviceId);
-  Serial.printf("  Roll: %d, Pitch: %d, Yaw: %d\n", message.roll, message.pitch, message.yaw);
+  powerManager.markWake(esp_timer_get_time());
+  TraceRecorder::recordMessage(esp_timer_get_time(), TRACE_MESSAGE_SUBMISSION, &message,
+                               sizeof(message));
+  LOG_INFO(LOG_CAT_RADIO, "Received orientation message from master module: %d",
+           message.deviceId);
+  LOG_INFO(LOG_CAT_RADIO, "  Roll: %d, Pitch: %d, Yaw: %d", message.roll, message.pitch,
+           message.yaw);
 
   if (!message.success) {
     transitionToAndThen(STATE_TIMEOUT_SUBMISSION, STATE_SLAVE_WAITING);
@@ -402,34 +1134,203 @@ void handleSubmissionMessageFromMaster(const OrientationSubmissionMessage& messa
 
 // Master -> Slave: Master started new phase
 void handlePhaseMessageFromMaster(const OrientationPhaseMessage& message) {
-  Serial.printf("Received orientation progress message from master: %d%%\n", message.phase);
+  powerManager.markWake(esp_timer_get_time());
+  TraceRecorder::recordMessage(esp_timer_get_time(), TRACE_MESSAGE_PHASE, &message,
+                               sizeof(message));
+  LOG_INFO(LOG_CAT_RADIO, "Received orientation progress message from master: %d%%",
+           message.phase);
 
   currentPhase = message.phase;
+  // A slave journals its own progress, so after a brownout it still knows to ask for a rejoin
+  checkpointSession(SESSION_STATE_UNKNOWN);
+  EventQueue::post({EVENT_CHECKPOINT, esp_timer_get_time()});
 
   transitionToAndThen(STATE_PHASE_LOADING, getProcessingStateType());
 }
 
 // Master -> Slave: Master transmitted final orientation submission to hub
 void handleTransmissionMessageFromMaster(const OrientationTransmissionMessage& message) {
-  Serial.println("Received orientation transmission message from master");
+  powerManager.markWake(esp_timer_get_time());
+  TraceRecorder::recordMessage(esp_timer_get_time(), TRACE_MESSAGE_TRANSMISSION, &message,
+                               sizeof(message));
+  LOG_INFO(LOG_CAT_RADIO, "Received orientation transmission message from master");
 
   transitionTo(STATE_TRANSMIT_COMPLETE);
+  EventQueue::post({EVENT_CHECKPOINT, esp_timer_get_time()});
+}
+
+// Link frames carry only what the handlers read; the shared message structs are rebuilt around
+// them so the handlers are the same ones EspNowHelper used to call
+void HOT_CODE receiveSubmissionFrame(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  SubmissionFrame frame;
+  if (length != sizeof(frame)) {
+    return;
+  }
+  memcpy(&frame, payload, sizeof(frame));
+
+  OrientationSubmissionMessage message = {};
+  message.deviceId = frame.deviceId;
+  message.roll = frame.roll;
+  message.pitch = frame.pitch;
+  message.yaw = frame.yaw;
+  message.success = frame.success != 0;
+
+#ifdef DEVICE_ROLE_MASTER
+  handleSubmissionMessageFromSlave(message);
+#else
+  handleSubmissionMessageFromMaster(message);
+#endif
+}
+
+void HOT_CODE receivePhaseFrame(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  PhaseFrame frame;
+  if (length != sizeof(frame)) {
+    return;
+  }
+  memcpy(&frame, payload, sizeof(frame));
+
+  OrientationPhaseMessage message = {};
+  message.phase = frame.phase;
+  handlePhaseMessageFromMaster(message);
+}
+
+void HOT_CODE receiveTransmissionFrame(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  if (length != sizeof(TransmissionFrame)) {
+    return;
+  }
+
+  OrientationTransmissionMessage message = {};
+  handleTransmissionMessageFromMaster(message);
+}
+
+// Master: tells a slave that reset mid-session where the session stands
+void receiveRejoinFrame(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  RejoinFrame rejoin;
+  if (length != sizeof(rejoin)) {
+    return;
+  }
+  memcpy(&rejoin, payload, sizeof(rejoin));
+  LOG_INFO(LOG_CAT_RADIO, "Slave module %d rejoined the session", rejoin.deviceId);
+
+  SessionFrame frame = {(uint8_t)currentPhase, SESSION_BETWEEN_PHASES, 0};
+  switch (currentState) {
+    case STATE_PHASE_LOADING:
+    case STATE_PROCESSING:
+    case STATE_TIMED_PROCESSING:
+    case STATE_MASTER_WAITING:
+    case STATE_INVALID_SUBMISSION:
+      frame.standing = SESSION_PHASE_PLAYING;
+      for (int i = 0; i < NUM_PLAYERS; i++) {
+        if (playerSubmissions[i].deviceId == rejoin.deviceId && playerSubmissions[i].success) {
+          frame.standing = SESSION_PHASE_SUBMITTED;
+        }
+      }
+      frame.timeLeftMs = getPhaseTimeLeftMs();
+      break;
+    case STATE_TRANSMIT_COMPLETE:
+      frame.standing = SESSION_TRANSMITTED;
+      break;
+    default:
+      break;
+  }
+
+  LinkProbe::noteSend(mac, esp_timer_get_time());
+  EspNowLink::send(mac, LINK_FRAME_SESSION, &frame, sizeof(frame));
+}
+
+// Slave: takes up the session where the master says it stands, instead of where the checkpoint
+// left it
+void receiveSessionFrame(const uint8_t* mac, const uint8_t* payload, size_t length) {
+  SessionFrame frame;
+  if (length != sizeof(frame) || !TimerWheel::isPending(TIMER_REJOIN)) {
+    return;
+  }
+  memcpy(&frame, payload, sizeof(frame));
+  if (frame.phase >= PhaseScript::getPhaseCount() && frame.standing != SESSION_TRANSMITTED) {
+    return;
+  }
+  TimerWheel::cancel(TIMER_REJOIN);
+  powerManager.markWake(esp_timer_get_time());
+  currentPhase = frame.phase;
+
+  switch (frame.standing) {
+    case SESSION_PHASE_PLAYING:
+      if (getProcessingStateType() == STATE_TIMED_PROCESSING) {
+        resumeTimedPhase(frame.timeLeftMs);
+      } else {
+        transitionTo(STATE_PROCESSING);
+      }
+      break;
+    case SESSION_TRANSMITTED:
+      transitionTo(STATE_TRANSMIT_COMPLETE);
+      break;
+    default:
+      transitionTo(STATE_SLAVE_WAITING);
+  }
+}
+
+void sendSubmission(const uint8_t* mac, int x, int y, int z, bool success) {
+  SubmissionFrame frame = {DEVICE_ID, (uint8_t)currentPhase, (int16_t)x, (int16_t)y, (int16_t)z,
+                           success};
+  LinkProbe::noteSend(mac, esp_timer_get_time());
+  EspNowLink::send(mac, LINK_FRAME_SUBMISSION, &frame, sizeof(frame));
+}
+
+void sendPhase(const uint8_t* mac) {
+  PhaseFrame frame = {(uint8_t)currentPhase};
+  LinkProbe::noteSend(mac, esp_timer_get_time());
+  EspNowLink::queue(mac, LINK_FRAME_PHASE, &frame, sizeof(frame));
+}
+
+void sendTransmission(const uint8_t* mac) {
+  TransmissionFrame frame = {true};
+  LinkProbe::noteSend(mac, esp_timer_get_time());
+  EspNowLink::queue(mac, LINK_FRAME_TRANSMISSION, &frame, sizeof(frame));
+}
+
+void requestRejoin() {
+  if (rejoinAttemptsLeft == 0) {
+    LOG_WARN(LOG_CAT_RADIO, "Master did not answer; staying in %s", getStateName(currentState));
+    return;
+  }
+  rejoinAttemptsLeft--;
+
+  RejoinFrame frame = {DEVICE_ID};
+  LinkProbe::noteSend(orientationMasterAddress, esp_timer_get_time());
+  EspNowLink::send(orientationMasterAddress, LINK_FRAME_REJOIN, &frame, sizeof(frame));
+  TimerWheel::schedule(TIMER_REJOIN, SESSION_REJOIN_RETRY_MS * 1000UL);
+}
+
+// Master: what a slave has left of the timed phase in play. A slave's clock starts when the
+// phase-start countdown ends; a master that resumed the phase itself no longer knows when that
+// was and reports the full limit.
+uint32_t getPhaseTimeLeftMs() {
+  int64_t limitMs = PhaseScript::getTimeLimitSeconds(currentPhase) * 1000LL;
+  if (phaseSentUs == 0) {
+    return (uint32_t)limitMs;
+  }
+  int64_t playedMs = (esp_timer_get_time() - phaseSentUs) / 1000 -
+                     COUNTDOWN_SECONDS_PHASE_START * 1000LL;
+  if (playedMs < 0) {
+    return (uint32_t)limitMs;
+  }
+  return playedMs < limitMs ? (uint32_t)(limitMs - playedMs) : 0;
 }
 
 void handleOrientationTimeout() {
-  Serial.println("Orientation submission timed out. Restarting phase.");
+  LOG_INFO(LOG_CAT_STATE, "Orientation submission timed out. Restarting phase.");
 
 #ifdef DEVICE_ROLE_MASTER
-  espNowHelper.sendOrientationSubmission(orientationSlave1Address, 0, 0, 0, currentPhase, false);
+  sendSubmission(orientationSlave1Address, 0, 0, 0, false);
   processSubmissionTimeout();
 
 #endif
 #ifdef DEVICE_ROLE_SLAVE_1
-  espNowHelper.sendOrientationSubmission(orientationMasterAddress, 0, 0, 0, currentPhase, false);
+  sendSubmission(orientationMasterAddress, 0, 0, 0, false);
   transitionTo(STATE_TIMEOUT_SUBMISSION);
 #endif
 #ifdef DEVICE_ROLE_SLAVE_2
-  espNowHelper.sendOrientationSubmission(orientationMasterAddress, 0, 0, 0, currentPhase, false);
+  sendSubmission(orientationMasterAddress, 0, 0, 0, false);
   transitionTo(STATE_TIMEOUT_SUBMISSION);
 #endif
 }
@@ -471,17 +1372,42 @@ const char* getStateName(int state) {
 }
 
 void setCurrentState(const int state) {
-  Serial.println("-----------------------------------");
-  Serial.printf("➤ ➤ Transitioning to state: (%d) %s\n ", state, getStateName(state));
-  Serial.println("-----------------------------------");
+  LOG_INFO(LOG_CAT_STATE,
+           "-----------------------------------\n"
+           "➤ ➤ Transitioning to state: (%d) %s\n"
+           "-----------------------------------",
+           state, getStateName(state));
+  if (currentState == STATE_PROCESSING || currentState == STATE_TIMED_PROCESSING) {
+    orientationPredictor.printError();
+    stopOrientationStream();
+  }
+  if (state == STATE_PROCESSING || state == STATE_TIMED_PROCESSING) {
+    orientationPredictor.resetError();
+    startOrientationStream();
+  }
   currentState = state;
+  TraceRecorder::recordState(esp_timer_get_time(), state);
+  LinkProbe::setPaused(state == STATE_PROCESSING || state == STATE_TIMED_PROCESSING);
+  PhaseScriptTransfer::setPaused(state == STATE_PROCESSING || state == STATE_TIMED_PROCESSING);
+  adoptPhaseScriptIfIdle();
+  requestedSensorProfile = getSensorProfileForState(state);
+
+  powerManager.request(getPowerModeForState(state));  // applied by the next loop() pass
+
+  if (isResumableState(state)) {
+    checkpointSession(state);
+  }
 }
 
 void transitionTo(const int state) {
+  boostPowerMode();
+  TimerWheel::cancel(TIMER_COUNTDOWN);
+  TimerWheel::cancel(TIMER_PHASE_TIMEOUT);
+
   switch (state) {
     case STATE_BOOTING:
       setCurrentState(STATE_BOOTING);
-      OLEDController::renderBootScreen(oled, COUNTDOWN_SECONDS_BOOT);
+      OLEDController::renderBootScreen(oled);
       break;
     case STATE_OFFSETS_SETUP:
       setCurrentState(STATE_OFFSETS_SETUP);
@@ -489,7 +1415,7 @@ void transitionTo(const int state) {
       break;
     case STATE_PHASE_STAGED:
       setCurrentState(STATE_PHASE_STAGED);
-      OLEDController::renderPhaseStaged(oled, currentPhase, NUM_PHASES);
+      OLEDController::renderPhaseStaged(oled, currentPhase, PhaseScript::getPhaseCount());
       break;
     case STATE_PHASE_LOADING:
       setCurrentState(STATE_PHASE_LOADING);
@@ -497,16 +1423,30 @@ void transitionTo(const int state) {
       break;
     case STATE_PROCESSING:
       OLEDController::renderOrientationLayout(oled);
+#ifdef AUTO_SUBMIT_ENABLED
+      autoSubmitDetector.reset();
+#endif
       setCurrentState(STATE_PROCESSING);
+      TimerWheel::schedule(TIMER_ORIENTATION_REFRESH, 0);
       break;
     case STATE_TIMED_PROCESSING:
       OLEDController::renderOrientationLayout(oled);
+#ifdef AUTO_SUBMIT_ENABLED
+      autoSubmitDetector.reset();
+#endif
       setCurrentState(STATE_TIMED_PROCESSING);
       processingPhaseStartTime = millis();
+      TimerWheel::schedule(TIMER_PHASE_TIMEOUT,
+                           PhaseScript::getTimeLimitSeconds(currentPhase) * 1000000UL);
+      TimerWheel::schedule(TIMER_ORIENTATION_REFRESH, 0);
       break;
     case STATE_MASTER_WAITING:
       setCurrentState(STATE_MASTER_WAITING);
+#ifdef ORIENTATION_STREAM_ENABLED
+      renderPlayerStatus();
+#else
       OLEDController::renderMasterWaitScreen(oled);
+#endif
       break;
     case STATE_SLAVE_WAITING:
       setCurrentState(STATE_SLAVE_WAITING);
@@ -522,55 +1462,392 @@ void transitionTo(const int state) {
       break;
     case STATE_INVALID_SUBMISSION:
       setCurrentState(STATE_INVALID_SUBMISSION);
-      OLEDController::renderInvalidSubmissionScreen(oled, COUNTDOWN_SECONDS_INVALID_SUBMISSION);
+      OLEDController::renderInvalidSubmissionScreen(oled);
       break;
     case STATE_TIMEOUT_SUBMISSION:
       setCurrentState(STATE_TIMEOUT_SUBMISSION);
-      OLEDController::renderTimeoutSubmissionScreen(oled, COUNTDOWN_SECONDS_TIMEOUT_SUBMISSION);
+      OLEDController::renderTimeoutSubmissionScreen(oled);
       break;
     default:
-      Serial.printf("✗ Unknown state transition requested: %d\n", state);
+      LOG_ERROR(LOG_CAT_STATE, "✗ Unknown state transition requested: %d", state);
+  }
+
+  if (powerManager.markRendered(esp_timer_get_time())) {
+    printWakeLatency();
   }
 }
 
+// Screens with a countdown hold for it on the timer wheel; the loop keeps running meanwhile
 void transitionToAndThen(const int state, const int nextState) {
   transitionTo(state);
-  transitionTo(nextState);
+
+  int seconds = getCountdownSeconds(state);
+  if (seconds == 0) {
+    transitionTo(nextState);
+    return;
+  }
+  countdownSecondsLeft = seconds;
+  countdownNextState = nextState;
+  TimerWheel::schedule(TIMER_COUNTDOWN, 1000000UL);
+}
+
+void advanceCountdown() {
+  countdownSecondsLeft--;
+  if (currentState == STATE_PHASE_LOADING) {
+    OLEDController::renderPhaseLoading(oled, currentPhase, countdownSecondsLeft);
+  }
+  if (countdownSecondsLeft > 0) {
+    TimerWheel::schedule(TIMER_COUNTDOWN, 1000000UL);
+    return;
+  }
+  transitionTo(countdownNextState);
+}
+
+int getCountdownSeconds(int state) {
+  switch (state) {
+    case STATE_PHASE_LOADING:
+      return COUNTDOWN_SECONDS_PHASE_START;
+    case STATE_INVALID_SUBMISSION:
+      return COUNTDOWN_SECONDS_INVALID_SUBMISSION;
+    case STATE_TIMEOUT_SUBMISSION:
+      return COUNTDOWN_SECONDS_TIMEOUT_SUBMISSION;
+    default:
+      return 0;
+  }
 }
 
 int getProcessingStateType() {
-  return phaseMetas[currentPhase].isTimed ? STATE_TIMED_PROCESSING : STATE_PROCESSING;
+  return PhaseScript::getTimeLimitSeconds(currentPhase) > 0 ? STATE_TIMED_PROCESSING
+                                                           : STATE_PROCESSING;
+}
+
+// Enters the timed phase with only timeLeftMs of its limit to go; the timer bar starts part-drawn
+void resumeTimedPhase(uint32_t timeLeftMs) {
+  uint32_t limitMs = PhaseScript::getTimeLimitSeconds(currentPhase) * 1000UL;
+  if (timeLeftMs > limitMs) {
+    timeLeftMs = limitMs;
+  }
+
+  transitionTo(STATE_TIMED_PROCESSING);
+  processingPhaseStartTime = millis() - (limitMs - timeLeftMs);
+  TimerWheel::schedule(TIMER_PHASE_TIMEOUT, timeLeftMs * 1000UL);
 }
 
-void setCurrentOrientation() {
+int getInitialState() {
+#ifdef DEVICE_ROLE_MASTER
+  return isCalibrated() ? STATE_TRANSMIT_STAGED : STATE_PHASE_STAGED;
+#else
+  return STATE_SLAVE_WAITING;
+#endif
+}
+
+// Transient states (countdowns, result screens) resume into the state that follows them instead
+bool isResumableState(int state) {
+  switch (state) {
+    case STATE_PHASE_STAGED:
+    case STATE_PROCESSING:
+    case STATE_TIMED_PROCESSING:
+    case STATE_MASTER_WAITING:
+    case STATE_SLAVE_WAITING:
+    case STATE_TRANSMIT_STAGED:
+    case STATE_TRANSMIT_COMPLETE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void checkpointSession(int state) {
+  SessionSnapshot snapshot = {};
+  snapshot.state = state;
+  snapshot.phase = currentPhase;
+  for (int i = 0; i < PhaseScript::getPhaseCount(); i++) {
+    snapshot.phaseCompleted[i] = phaseCompleted[i];
+  }
+  for (int i = 0; i < NUM_PLAYERS; i++) {
+    snapshot.submissions[i] = playerSubmissions[i].success;
+  }
+  snapshot.yaw = orientationHistory.newest().z;
+  SessionCheckpoint::save(snapshot);
+}
+
+void resumeSession() {
+  currentPhase = resumedSession.phase;
+  for (int i = 0; i < PhaseScript::getPhaseCount(); i++) {
+    phaseCompleted[i] = resumedSession.phaseCompleted[i];
+  }
+  for (int i = 0; i < NUM_PLAYERS; i++) {
+    playerSubmissions[i].success = resumedSession.submissions[i];
+  }
+
+  // The gyro integrator restarted at zero; offset it so yaw carries on from where it was
+  angleZOffset = mpu.getAngleZ() + resumedSession.yaw;
+
+#ifdef DEVICE_ROLE_MASTER
+  for (int i = 0; i < PhaseScript::getPhaseCount(); i++) {
+    if (phaseCompleted[i]) {
+      leds[i] = CRGB::Green;
+    }
+  }
+  FastLED.show();
+#endif
+
+  int state = isResumableState(resumedSession.state) ? resumedSession.state : getInitialState();
+  LOG_INFO(LOG_CAT_STATE, "Resuming session at phase %d in %s", currentPhase + 1,
+           getStateName(state));
+  transitionTo(state);
+
+#if defined(DEVICE_ROLE_SLAVE_1) || defined(DEVICE_ROLE_SLAVE_2)
+  // The master played on without this device; it says where the session stands now
+  rejoinAttemptsLeft = SESSION_REJOIN_MAX_ATTEMPTS;
+  requestRejoin();
+#endif
+}
+
+// A received phase script replaces the current one only before the first phase is played
+bool adoptPhaseScriptIfIdle() {
+  if (PhaseScript::getInstalledScriptId() == 0 || currentPhase != 0 ||
+      (currentState != STATE_PHASE_STAGED && currentState != STATE_SLAVE_WAITING)) {
+    return false;
+  }
+  return PhaseScript::adoptInstalled();
+}
+
+void HOT_CODE setCurrentOrientation() {
   currentOrientation.x = (int)mpu.getAngleX() * -1;
   currentOrientation.y = (int)mpu.getAngleY();
   currentOrientation.z = (int)(mpu.getAngleZ() - angleZOffset) * -1;
 }
 
-bool orientationMatches(const Orientation& target, int x, int y, int z) {
-  return abs(target.x - x) <= ORIENTATION_TOLERANCE && abs(target.y - y) <= ORIENTATION_TOLERANCE &&
-         abs(target.z - z) <= ORIENTATION_TOLERANCE;
+// Raw readings, with the offsets added back, so a replay can re-run calibration and filtering
+void recordTraceSample() {
+  float acc[3] = {mpu.getAccX() + mpu.getAccXoffset(), mpu.getAccY() + mpu.getAccYoffset(),
+                  mpu.getAccZ() + mpu.getAccZoffset()};
+  float gyro[3] = {mpu.getGyroX() + mpu.getGyroXoffset(), mpu.getGyroY() + mpu.getGyroYoffset(),
+                   mpu.getGyroZ() + mpu.getGyroZoffset()};
+  int64_t nowUs = esp_timer_get_time();
+  TraceRecorder::recordImu(nowUs, acc, gyro);
+  TraceRecorder::recordTemperature(nowUs, mpu.getTemp());
+}
+
+void processSerialCommands() {
+  while (Serial.available() > 0) {
+    switch (Serial.read()) {
+#ifdef TRACE_RECORDER_ENABLED
+      case 'd':
+        TraceRecorder::requestDump();
+        break;
+#endif
+      case 'l':
+        LinkProbe::printReport();
+        break;
+      case 'w':
+        DeadlineMonitor::printReport();
+        break;
+#ifdef LOOP_PROFILER_ENABLED
+      case 'p':
+        LoopProfiler::printReport();
+        break;
+#endif
+    }
+  }
+}
+
+void HOT_CODE recordOrientationSample() {
+  OrientationSample sample = {esp_timer_get_time(), mpu.getAngleX() * -1, mpu.getAngleY(),
+                              (mpu.getAngleZ() - angleZOffset) * -1};
+  orientationHistory.push(sample);
+  orientationPredictor.update(sample, mpu.getGyroX() * -1, mpu.getGyroY(), mpu.getGyroZ() * -1);
+}
+
+OrientationSample getOrientationSampleAt(int64_t timestampUs) {
+  OrientationSample sample;
+  if (!orientationHistory.sampleAt(timestampUs, sample)) {
+    return {timestampUs, (float)currentOrientation.x, (float)currentOrientation.y,
+            (float)currentOrientation.z};
+  }
+  return sample;
+}
+
+// Hands-free submission: fires once the windowed orientation has been steady on target for the
+// dwell time, so a device still swinging through the target never submits
+#ifdef AUTO_SUBMIT_ENABLED
+bool evaluateAutoSubmit() {
+  if (currentPhase >= PhaseScript::getPhaseCount()) {
+    return false;
+  }
+
+  const OrientationSample& sample = orientationHistory.newest();
+  autoSubmitDetector.addSample(sample);
+
+  OrientationSample mean = autoSubmitDetector.getMean();
+  int x = (int)mean.x;
+  int y = (int)mean.y;
+  int z = (int)mean.z;
+  bool onTarget = autoSubmitDetector.isStable() &&
+                  orientationMatches(PhaseScript::getTarget(currentPhase), mean);
+
+  if (!autoSubmitDetector.holdElapsed(onTarget, sample.timestampUs)) {
+    return false;
+  }
+
+  LOG_INFO(LOG_CAT_INPUT, "Auto submit: x=%d, y=%d, z=%d", x, y, z);
+  processOrientationMatch();
+  return true;
+}
+#endif
+
+bool orientationMatches(const OrientationTarget& target, const OrientationSample& sample) {
+  return target.matches(OrientationPose::fromEuler(sample.x, sample.y, sample.z));
 }
 
-void processOrientationMatch(uint16_t x, uint16_t y, uint16_t z) {
+#ifdef MATCH_BENCHMARK
+// Compares the per-axis integer check this firmware used to run against the geometric check,
+// with and without the once-per-sample pose conversion
+void runMatchBenchmark() {
+  const int iterations = 10000;
+  const OrientationTarget& target = PhaseScript::getTarget(0);
+  OrientationPose pose = OrientationPose::fromEuler(0.4f, -0.7f, 10.9f);
+  volatile int hits = 0;
+
+  uint32_t start = ESP.getCycleCount();
+  for (int i = 0; i < iterations; i++) {
+    int x = i & 1, y = -(i & 1), z = 10 + (i & 3);
+    hits += abs(0 - x) <= ORIENTATION_TOLERANCE && abs(0 - y) <= ORIENTATION_TOLERANCE &&
+            abs(10 - z) <= ORIENTATION_TOLERANCE;
+  }
+  uint32_t axisCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (int i = 0; i < iterations; i++) {
+    pose.q.w += (i & 1) * 1e-7f;
+    hits += target.matches(pose);
+  }
+  uint32_t geometricCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (int i = 0; i < iterations; i++) {
+    hits += target.matches(OrientationPose::fromEuler(0.4f, -0.7f, 10.0f + (i & 3)));
+  }
+  uint32_t withPoseCycles = ESP.getCycleCount() - start;
+
+  Serial.println("Orientation match benchmark (cycles per check):");
+  Serial.printf("  legacy per-axis int:    %u\n", axisCycles / iterations);
+  Serial.printf("  geometric cone:         %u\n", geometricCycles / iterations);
+  Serial.printf("  geometric cone + pose:  %u\n", withPoseCycles / iterations);
+}
+#endif
+
+void processOrientationMatch() {
 #ifdef DEVICE_ROLE_MASTER
   transitionTo(STATE_MASTER_WAITING);
 
   submitAndPossiblyCompletePhase(DEVICE_ID);
 #endif
 #ifdef DEVICE_ROLE_SLAVE_1
-  espNowHelper.sendOrientationSubmission(orientationMasterAddress, x, y, z, currentPhase, true);
+  sendPredictedSubmission();
   transitionTo(STATE_SLAVE_WAITING);
 #endif
 #ifdef DEVICE_ROLE_SLAVE_2
-  espNowHelper.sendOrientationSubmission(orientationMasterAddress, x, y, z, currentPhase, true);
+  sendPredictedSubmission();
   transitionTo(STATE_SLAVE_WAITING);
 #endif
 }
 
+// Players stream to the master while they play; the master only listens
+void startOrientationStream() {
+#if defined(ORIENTATION_STREAM_ENABLED) && !defined(DEVICE_ROLE_MASTER)
+  orientationStream.reset();
+  TimerWheel::schedule(TIMER_ORIENTATION_STREAM, 0);
+#endif
+}
+
+void stopOrientationStream() {
+#if defined(ORIENTATION_STREAM_ENABLED) && !defined(DEVICE_ROLE_MASTER)
+  TimerWheel::cancel(TIMER_ORIENTATION_STREAM);
+  LOG_INFO(LOG_CAT_RADIO, "Orientation stream: %u frames, %u bytes, %u us on air",
+           orientationStream.getFramesSent(), orientationStream.getBytesSent(),
+           orientationStream.getAirtimeUs());
+#endif
+}
+
+void streamOrientation() {
+#ifdef ORIENTATION_STREAM_ENABLED
+  if (currentState != STATE_PROCESSING && currentState != STATE_TIMED_PROCESSING) {
+    return;
+  }
+  uint8_t frame[OrientationStreamEncoder::maxFrameSize];
+  size_t length = orientationStream.encode(orientationHistory.newest(), frame);
+  if (length > 0) {
+    EspNowLink::queue(orientationMasterAddress, LINK_FRAME_ORIENTATION, frame, length);
+  }
+  TimerWheel::schedule(TIMER_ORIENTATION_STREAM, 1000000UL / ORIENTATION_STREAM_RATE_HZ);
+#endif
+}
+
+void HOT_CODE receiveOrientationFrame(const uint8_t* mac, const uint8_t* payload, size_t length) {
+#ifdef ORIENTATION_STREAM_ENABLED
+  uint8_t deviceId = 0;
+  if (memcmp(mac, orientationSlave1Address, sizeof(orientationSlave1Address)) == 0) {
+    deviceId = SLAVE_DEVICE_ID_1;
+  } else if (memcmp(mac, orientationSlave2Address, sizeof(orientationSlave2Address)) == 0) {
+    deviceId = SLAVE_DEVICE_ID_2;
+  }
+
+  for (int i = 0; i < NUM_PLAYERS; i++) {
+    if (playerSubmissions[i].deviceId == deviceId) {
+      streamedPlayers[i].apply(payload, length, esp_timer_get_time());
+      return;
+    }
+  }
+#endif
+}
+
+// How far each other player is from the phase target, refreshed while the master waits on them
+void renderPlayerStatus() {
+#ifdef ORIENTATION_STREAM_ENABLED
+  if (currentPhase >= PhaseScript::getPhaseCount()) {
+    return;
+  }
+  const OrientationTarget& target = PhaseScript::getTarget(currentPhase);
+  int64_t nowUs = esp_timer_get_time();
+
+  PlayerStatus players[NUM_PLAYERS];
+  int count = 0;
+  for (int i = 0; i < NUM_PLAYERS; i++) {
+    if (playerSubmissions[i].deviceId == DEVICE_ID) {
+      continue;
+    }
+    const StreamedOrientation& stream = streamedPlayers[i];
+    float x, y, z;
+    stream.get(x, y, z);
+    PlayerStatus& status = players[count++];
+    status.player = i + 1;
+    status.submitted = playerSubmissions[i].success;
+    status.live = stream.isLive(nowUs);
+    status.distance = target.distance(OrientationPose::fromEuler(x, y, z));
+  }
+
+  OLEDController::renderPlayerStatus(oled, players, count);
+  TimerWheel::schedule(TIMER_PLAYER_STATUS, PLAYER_STATUS_REFRESH_MS * 1000UL);
+#endif
+}
+
+// The match is judged at the press; the angles reported to the master are extrapolated to when
+// the message lands. The air time comes from link probing once the master has answered a ping.
+void sendPredictedSubmission() {
+  int64_t sampledUs = orientationHistory.newest().timestampUs;
+  OrientationSample sent = orientationPredictor.predictAhead(LATENCY_PATH_RADIO);
+
+  sendSubmission(orientationMasterAddress, (int)sent.x, (int)sent.y, (int)sent.z, true);
+
+  uint32_t localUs = (uint32_t)(esp_timer_get_time() - sampledUs);
+  uint32_t airUs = LinkProbe::getOneWayUs(orientationMasterAddress, PREDICTION_RADIO_AIR_TIME_US);
+  orientationPredictor.observeLatency(LATENCY_PATH_RADIO, localUs + airUs);
+}
+
 void processOrientationMismatch() {
-  Serial.printf("Phase %d not matched. Try again.\n", currentPhase + 1);
+  LOG_INFO(LOG_CAT_STATE, "Phase %d not matched. Try again.", currentPhase + 1);
   transitionToAndThen(STATE_INVALID_SUBMISSION, getProcessingStateType());
 }
 
@@ -580,7 +1857,7 @@ void submitAndPossiblyCompletePhase(uint8_t deviceId) {
   if (allPlayersSubmitted()) {
     processAllPlayersSubmitted();
   } else {
-    Serial.println("Waiting for all players to submit...");
+    LOG_INFO(LOG_CAT_STATE, "Waiting for all players to submit...");
   }
 }
 
@@ -609,10 +1886,10 @@ void resetPlayerSubmissions() {
 }
 
 void processAllPlayersSubmitted() {
-  Serial.println("All players submitted successfully for this phase!");
+  LOG_INFO(LOG_CAT_STATE, "All players submitted successfully for this phase!");
   completePhase();
 
-  if (currentPhase < NUM_PHASES) {
+  if (currentPhase < PhaseScript::getPhaseCount()) {
     transitionTo(STATE_PHASE_STAGED);
   } else {
     transitionTo(STATE_TRANSMIT_STAGED);
@@ -625,6 +1902,8 @@ void completePhase() {
   resetPlayerSubmissions();
   phaseCompleted[currentPhase] = true;
   currentPhase++;
+  checkpointSession(SESSION_STATE_UNKNOWN);
+  EventQueue::post({EVENT_CHECKPOINT, esp_timer_get_time()});  // journaled once the loop is free
 
   playPhaseCompletionEffects(completedPhase);
 }
@@ -632,9 +1911,10 @@ void completePhase() {
 void completeTransmit() {
   transitionTo(STATE_TRANSMIT_COMPLETE);
 
+  LinkProbe::noteSend(hubAddress, esp_timer_get_time());
   espNowHelper.sendModuleUpdated(hubAddress, true);
-  espNowHelper.sendOrientationTransmission(orientationSlave1Address, true);
-  espNowHelper.sendOrientationTransmission(orientationSlave2Address, true);
+  sendTransmission(orientationSlave1Address);
+  sendTransmission(orientationSlave2Address);
 
   playTransmitCompletionEffects();
 }
@@ -651,25 +1931,40 @@ void playTransmitCompletionEffects() {
   FastLED.clear(true);
   FastLED.setBrightness(10);
 
-  for (int i = 0; i < NUM_LEDS; i++) {
-    // Chase one full lap around the ring, with the dot landing on position i
-    for (int step = 0; step < NUM_LEDS; step++) {
-      int chasePos = (i + 1 + step) % NUM_LEDS;
+  ledChaseLocked = 0;
+  ledChaseStep = 0;
+  advanceLedChase();
+}
 
-      for (int j = 0; j < i; j++) {
-        leds[j] = CRGB::Green;
-      }
-      leds[chasePos] = CRGB::White;
-      FastLED.show();
-      delay(25);
-      leds[chasePos] = CRGB::Black;
-    }
+// For each LED, the dot chases one full lap around the ring and lands on it, locking it in green.
+// One call per frame, paced by TIMER_LED_ANIMATION.
+void advanceLedChase() {
+  int i = ledChaseLocked;
+  if (i >= NUM_LEDS) {
+    BuzzerController::playTriumphMelody();
+    return;
+  }
 
-    // Lock in this LED permanently
-    leds[i] = CRGB::Green;
+  if (ledChaseStep > 0) {
+    leds[(i + ledChaseStep) % NUM_LEDS] = CRGB::Black;  // clear the previous frame's dot
+  }
+
+  if (ledChaseStep < NUM_LEDS) {
+    int chasePos = (i + 1 + ledChaseStep) % NUM_LEDS;
+    for (int j = 0; j < i; j++) {
+      leds[j] = CRGB::Green;
+    }
+    leds[chasePos] = CRGB::White;
     FastLED.show();
-    delay(150);
+    ledChaseStep++;
+    TimerWheel::schedule(TIMER_LED_ANIMATION, LED_CHASE_STEP_MS * 1000UL);
+    return;
   }
 
-  BuzzerController::playTriumphMelody();
+  // Lock in this LED permanently
+  leds[i] = CRGB::Green;
+  FastLED.show();
+  ledChaseLocked++;
+  ledChaseStep = 0;
+  TimerWheel::schedule(TIMER_LED_ANIMATION, LED_CHASE_LOCK_MS * 1000UL);
 }
@@ -0,0 +1,111 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core the tested modules use
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+static const uint8_t SDA = 21;
+static const uint8_t SCL = 22;
+
+// The I2C lines as the bus sees them. Both are open drain: a line is low while the master or any
+// slave pulls it down. Tests inject a slave stuck mid-byte through sdaHeldForPulses.
+struct HostI2CLines {
+    int sdaHeldForPulses;  // SCL pulses until the slave lets SDA go; -1 never
+    bool sclHeldLow;       // a slave stretching the clock without end
+    int sclPulses;         // falling edges the master has driven on SCL
+    int sdaMaster;         // what the master drives on each line
+    int sclMaster;
+};
+
+inline HostI2CLines& hostI2CLines() {
+  static HostI2CLines lines = {0, false, 0, HIGH, HIGH};
+  return lines;
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  HostI2CLines& lines = hostI2CLines();
+  if (mode == INPUT_PULLUP || mode == INPUT) {
+    if (pin == SDA) {
+      lines.sdaMaster = HIGH;
+    } else if (pin == SCL) {
+      lines.sclMaster = HIGH;
+    }
+  }
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  HostI2CLines& lines = hostI2CLines();
+  if (pin == SDA) {
+    lines.sdaMaster = value;
+  } else if (pin == SCL) {
+    if (lines.sclMaster == HIGH && value == LOW) {
+      lines.sclPulses++;
+      if (lines.sdaHeldForPulses > 0) {
+        lines.sdaHeldForPulses--;
+      }
+    }
+    lines.sclMaster = value;
+  }
+}
+
+inline int digitalRead(uint8_t pin) {
+  HostI2CLines& lines = hostI2CLines();
+  if (pin == SDA) {
+    return lines.sdaHeldForPulses != 0 ? LOW : lines.sdaMaster;
+  }
+  if (pin == SCL) {
+    return lines.sclHeldLow ? LOW : lines.sclMaster;
+  }
+  return LOW;
+}
+
+inline void delay(uint32_t ms) {
+}
+
+inline void delayMicroseconds(uint32_t us) {
+}
+
+inline bool setCpuFrequencyMhz(uint32_t mhz) {
+  return true;
+}
+
+class HostSerial {
+  public:
+    void print(const char* text) {
+      fputs(text, stdout);
+    }
+
+    void println(const char* text = "") {
+      puts(text);
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+      return fwrite(data, 1, length, stdout);
+    }
+
+    template <typename... Args>
+    void printf(const char* format, Args... args) {
+      ::printf(format, args...);
+    }
+};
+
+static HostSerial Serial __attribute__((unused));
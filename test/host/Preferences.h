@@ -0,0 +1,46 @@
+#pragma once
+
+// Host stand-in for the NVS Preferences API, backed by memory for the life of the process
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stddef.h>
+#include <string.h>
+
+class Preferences {
+  public:
+    bool begin(const char* name, bool readOnly = false) {
+      space = name;
+      return true;
+    }
+
+    void end() {
+    }
+
+    size_t getBytesLength(const char* key) {
+      return entries()[space + "/" + key].size();
+    }
+
+    size_t getBytes(const char* key, void* data, size_t length) {
+      std::vector<uint8_t>& bytes = entries()[space + "/" + key];
+      length = length < bytes.size() ? length : bytes.size();
+      memcpy(data, bytes.data(), length);
+      return length;
+    }
+
+    size_t putBytes(const char* key, const void* data, size_t length) {
+      const uint8_t* bytes = (const uint8_t*)data;
+      entries()[space + "/" + key].assign(bytes, bytes + length);
+      return length;
+    }
+
+  private:
+    std::string space;
+
+    static std::map<std::string, std::vector<uint8_t>>& entries() {
+      static std::map<std::string, std::vector<uint8_t>> stored;
+      return stored;
+    }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+// Host stand-in for the Arduino Wire library on a simulated bus. Devices ACK when present and
+// not failed; while a slave holds SDA (see HostI2CLines) every transaction times out.
+
+#include "Arduino.h"
+
+struct HostI2CBus {
+    bool present[128];
+    bool failed[128];  // present but NACKs everything, as a wedged device does
+    bool running;
+    int begins;
+    int transactions;
+};
+
+inline HostI2CBus& hostI2CBus() {
+  static HostI2CBus bus = {};
+  return bus;
+}
+
+class TwoWire {
+  public:
+    bool begin() {
+      hostI2CBus().running = true;
+      hostI2CBus().begins++;
+      return true;
+    }
+
+    bool end() {
+      hostI2CBus().running = false;
+      return true;
+    }
+
+    void setTimeOut(uint16_t timeoutMs) {
+    }
+
+    void beginTransmission(uint8_t address) {
+      this->address = address & 0x7F;
+    }
+
+    // 0 success, 2 NACK on address, 4 bus not running, 5 timeout
+    uint8_t endTransmission(bool sendStop = true) {
+      HostI2CBus& bus = hostI2CBus();
+      bus.transactions++;
+      if (!bus.running) {
+        return 4;
+      }
+      if (digitalRead(SDA) == LOW || digitalRead(SCL) == LOW) {
+        return 5;
+      }
+      return bus.present[address] && !bus.failed[address] ? 0 : 2;
+    }
+
+  private:
+    uint8_t address = 0;
+};
+
+static TwoWire Wire;
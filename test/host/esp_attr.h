@@ -0,0 +1,8 @@
+#pragma once
+
+// Host stand-in: code and data placement means nothing off the chip
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
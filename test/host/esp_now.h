@@ -0,0 +1,60 @@
+#pragma once
+
+// Host stand-in for ESP-NOW. Sent frames are kept for the test to inspect; a test delivers a
+// frame with hostRadioReceive(), which calls the receive callback as the WiFi task would.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "esp_err.h"
+
+#define ESP_NOW_MAX_DATA_LEN 250
+
+enum esp_now_send_status_t {
+  ESP_NOW_SEND_SUCCESS = 0,
+  ESP_NOW_SEND_FAIL,
+};
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac, const uint8_t* data, int length);
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac, esp_now_send_status_t status);
+
+struct HostFrame {
+    uint8_t mac[6];
+    std::vector<uint8_t> data;
+};
+
+struct HostRadio {
+    esp_now_recv_cb_t receive;
+    esp_now_send_cb_t sent;
+    std::vector<HostFrame> frames;  // everything sent, oldest first
+};
+
+inline HostRadio& hostRadio() {
+  static HostRadio radio = {};
+  return radio;
+}
+
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback) {
+  hostRadio().receive = callback;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_now_register_send_cb(esp_now_send_cb_t callback) {
+  hostRadio().sent = callback;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_now_send(const uint8_t* mac, const uint8_t* data, size_t length) {
+  HostFrame frame;
+  memcpy(frame.mac, mac, sizeof(frame.mac));
+  frame.data.assign(data, data + length);
+  hostRadio().frames.push_back(frame);
+  return ESP_OK;
+}
+
+inline void hostRadioReceive(const uint8_t* mac, const uint8_t* data, size_t length) {
+  hostRadio().receive(mac, data, (int)length);
+}
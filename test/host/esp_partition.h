@@ -0,0 +1,125 @@
+#pragma once
+
+// Host stand-in for flash partitions, held in RAM. Flash rules apply: erase sets whole sectors to
+// 0xFF and a write can only clear bits. A test creates the partitions it needs with
+// hostAddPartition() and can cut the power by making writes fail with failWritesAfter.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "esp_err.h"
+
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+typedef int esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+
+#define ESP_PARTITION_SUBTYPE_ANY 0xff
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+enum esp_partition_mmap_memory_t {
+  ESP_PARTITION_MMAP_DATA,
+  ESP_PARTITION_MMAP_INST,
+};
+
+struct esp_partition_t {
+    esp_partition_type_t type;
+    uint32_t size;
+    const char* label;
+    uint8_t* data;
+    int failWritesAfter;  // writes still allowed before every write fails; -1 never fails
+    uint32_t erases;
+};
+
+static const uint32_t HOST_FLASH_SECTOR_SIZE = 4096;
+
+inline std::vector<esp_partition_t*>& hostPartitions() {
+  static std::vector<esp_partition_t*> partitions;
+  return partitions;
+}
+
+inline esp_partition_t* hostAddPartition(esp_partition_type_t type, const char* label,
+                                         uint32_t size) {
+  esp_partition_t* partition = new esp_partition_t();
+  partition->type = type;
+  partition->size = size;
+  partition->label = label;
+  partition->data = new uint8_t[size];
+  memset(partition->data, 0xFF, size);
+  partition->failWritesAfter = -1;
+  hostPartitions().push_back(partition);
+  return partition;
+}
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                       esp_partition_subtype_t subtype,
+                                                       const char* label) {
+  for (esp_partition_t* partition : hostPartitions()) {
+    if (partition->type == type && (label == nullptr || strcmp(partition->label, label) == 0)) {
+      return partition;
+    }
+  }
+  return nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* out,
+                                    size_t length) {
+  if (offset + length > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(out, partition->data + offset, length);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset,
+                                     const void* data, size_t length) {
+  if (offset + length > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  esp_partition_t* writable = const_cast<esp_partition_t*>(partition);
+  if (writable->failWritesAfter == 0) {
+    return ESP_FAIL;
+  }
+  if (writable->failWritesAfter > 0) {
+    writable->failWritesAfter--;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < length; i++) {
+    writable->data[offset + i] &= bytes[i];
+  }
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset,
+                                          size_t length) {
+  if (offset % HOST_FLASH_SECTOR_SIZE != 0 || length % HOST_FLASH_SECTOR_SIZE != 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (offset + length > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  esp_partition_t* writable = const_cast<esp_partition_t*>(partition);
+  memset(writable->data + offset, 0xFF, length);
+  writable->erases++;
+  return ESP_OK;
+}
+
+// The mapping is the partition's RAM itself, so later writes show through as they would in flash
+inline esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                                    esp_partition_mmap_memory_t memory, const void** out,
+                                    esp_partition_mmap_handle_t* handle) {
+  if (offset + size > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  *out = partition->data + offset;
+  *handle = (esp_partition_mmap_handle_t)offset;
+  return ESP_OK;
+}
+
+inline void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+}
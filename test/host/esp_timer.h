@@ -0,0 +1,97 @@
+#pragma once
+
+// Host stand-in for esp_timer on a virtual clock. Time only moves when a test calls
+// hostSetTimeUs() or hostRunTimersUntil(); the latter fires one-shot timers as it passes them.
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "esp_err.h"
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+struct esp_timer_create_args_t {
+    esp_timer_cb_t callback;
+    void* arg;
+    int dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+};
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    bool armed;
+    int64_t alarmUs;
+    uint32_t fired;
+};
+
+typedef esp_timer* esp_timer_handle_t;
+
+inline int64_t& hostTimeUs() {
+  static int64_t nowUs = 0;
+  return nowUs;
+}
+
+inline std::vector<esp_timer*>& hostTimers() {
+  static std::vector<esp_timer*> timers;
+  return timers;
+}
+
+inline void hostSetTimeUs(int64_t nowUs) {
+  hostTimeUs() = nowUs;
+}
+
+inline int64_t esp_timer_get_time() {
+  return hostTimeUs();
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  esp_timer* timer = new esp_timer();
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  hostTimers().push_back(timer);
+  *out = timer;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+  if (timer->armed) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->armed = true;
+  timer->alarmUs = hostTimeUs() + (int64_t)timeoutUs;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  bool wasArmed = timer->armed;
+  timer->armed = false;
+  return wasArmed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+// Moves the clock to untilUs, stopping at each alarm on the way to run its callback
+inline void hostRunTimersUntil(int64_t untilUs) {
+  while (true) {
+    esp_timer* next = nullptr;
+    for (esp_timer* timer : hostTimers()) {
+      if (timer->armed && timer->alarmUs <= untilUs &&
+          (next == nullptr || timer->alarmUs < next->alarmUs)) {
+        next = timer;
+      }
+    }
+    if (next == nullptr) {
+      break;
+    }
+    if (next->alarmUs > hostTimeUs()) {
+      hostTimeUs() = next->alarmUs;
+    }
+    next->armed = false;
+    next->fired++;
+    next->callback(next->arg);
+  }
+  if (untilUs > hostTimeUs()) {
+    hostTimeUs() = untilUs;
+  }
+}
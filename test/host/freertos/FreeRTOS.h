@@ -0,0 +1,35 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS types and critical sections. Tests run on one thread, so a
+// critical section has nothing to exclude.
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define configMAX_PRIORITIES 25
+
+typedef void (*TaskFunction_t)(void* arg);
+
+struct StaticTask_t {
+    TaskFunction_t function;
+    const char* name;
+};
+
+struct portMUX_TYPE {
+    int owner;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portYIELD_FROM_ISR()
@@ -0,0 +1,59 @@
+#pragma once
+
+// Host stand-in for statically allocated FreeRTOS queues. Nothing ever blocks: a call that would
+// wait returns as if its timeout had passed.
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+struct StaticQueue_t {
+    uint8_t* storage;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+typedef StaticQueue_t* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize,
+                                        uint8_t* storage, StaticQueue_t* queue) {
+  queue->storage = storage;
+  queue->length = length;
+  queue->itemSize = itemSize;
+  queue->head = 0;
+  queue->count = 0;
+  return queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait) {
+  if (queue->count == queue->length) {
+    return pdFALSE;
+  }
+  UBaseType_t tail = (queue->head + queue->count) % queue->length;
+  memcpy(queue->storage + tail * queue->itemSize, item, queue->itemSize);
+  queue->count++;
+  return pdTRUE;
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+  return xQueueSend(queue, item, 0);
+}
+
+inline BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t wait) {
+  if (queue->count == 0) {
+    return pdFALSE;
+  }
+  memcpy(item, queue->storage + queue->head * queue->itemSize, queue->itemSize);
+  return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait) {
+  if (xQueuePeek(queue, item, wait) != pdTRUE) {
+    return pdFALSE;
+  }
+  queue->head = (queue->head + 1) % queue->length;
+  queue->count--;
+  return pdTRUE;
+}
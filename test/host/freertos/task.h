@@ -0,0 +1,36 @@
+#pragma once
+
+// Host stand-in for FreeRTOS tasks. Tests run on one thread: a task is created but never runs,
+// and a delay returns at once.
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+enum eTaskState {
+  eRunning = 0,
+  eReady,
+  eBlocked,
+  eSuspended,
+  eDeleted,
+};
+
+inline TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char* name,
+                                                  uint32_t stackSize, void* arg,
+                                                  UBaseType_t priority, StackType_t* stack,
+                                                  StaticTask_t* task, BaseType_t core) {
+  task->function = function;
+  task->name = name;
+  return task;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return nullptr;
+}
+
+inline eTaskState eTaskGetState(TaskHandle_t task) {
+  return eReady;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+}
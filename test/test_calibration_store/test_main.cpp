@@ -0,0 +1,150 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "CalibrationStore.h"
+#include "Crc.h"
+
+// NVS stand-in: the record's bytes in a file, so each test can reopen them as a reboot would
+class FileCalibrationStorage : public CalibrationStorage {
+  public:
+    explicit FileCalibrationStorage(const char* path) : path(path), failWrites(false) {
+    }
+
+    size_t read(void* data, size_t length) override {
+      FILE* file = fopen(path, "rb");
+      if (file == NULL) {
+        return 0;
+      }
+      size_t bytesRead = fread(data, 1, length, file);
+      fclose(file);
+      return bytesRead;
+    }
+
+    bool write(const void* data, size_t length) override {
+      FILE* file = failWrites ? NULL : fopen(path, "wb");
+      if (file == NULL) {
+        return false;
+      }
+      bool written = fwrite(data, 1, length, file) == length;
+      fclose(file);
+      return written;
+    }
+
+    const char* path;
+    bool failWrites;
+};
+
+static const char* RECORD_PATH = "calibration_store_test.bin";
+static const float GYRO[3] = {-1.25f, 0.5f, 2.75f};
+static const float ACC[3] = {0.01f, -0.02f, 0.03f};
+
+static CalibrationRecord readRaw() {
+  CalibrationRecord record = {};
+  FileCalibrationStorage(RECORD_PATH).read(&record, sizeof(record));
+  return record;
+}
+
+static void writeRaw(const void* data, size_t length) {
+  FileCalibrationStorage(RECORD_PATH).write(data, length);
+}
+
+void setUp(void) {
+  remove(RECORD_PATH);
+}
+
+void tearDown(void) {
+  remove(RECORD_PATH);
+}
+
+void test_saved_offsets_load_after_reopen(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  TEST_ASSERT_TRUE(CalibrationStore(storage).save(GYRO, ACC, 31.5f));
+
+  FileCalibrationStorage reopened(RECORD_PATH);
+  CalibrationRecord record;
+  TEST_ASSERT_TRUE(CalibrationStore(reopened).load(record));
+  for (int axis = 0; axis < 3; axis++) {
+    TEST_ASSERT_EQUAL_FLOAT(GYRO[axis], record.gyroOffsets[axis]);
+    TEST_ASSERT_EQUAL_FLOAT(ACC[axis], record.accOffsets[axis]);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(31.5f, record.temperatureC);
+}
+
+void test_missing_record_does_not_load(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  CalibrationRecord record;
+  TEST_ASSERT_FALSE(CalibrationStore(storage).load(record));
+}
+
+void test_truncated_record_does_not_load(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  CalibrationStore(storage).save(GYRO, ACC, 25.0f);
+  CalibrationRecord record = readRaw();
+  writeRaw(&record, sizeof(record) - 1);
+
+  TEST_ASSERT_FALSE(CalibrationStore(storage).load(record));
+}
+
+void test_every_flipped_byte_is_caught(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  CalibrationStore(storage).save(GYRO, ACC, 25.0f);
+  CalibrationRecord saved = readRaw();
+
+  for (size_t i = 0; i < sizeof(saved); i++) {
+    CalibrationRecord corrupted = saved;
+    ((uint8_t*)&corrupted)[i] ^= 0x10;
+    writeRaw(&corrupted, sizeof(corrupted));
+
+    CalibrationRecord record;
+    TEST_ASSERT_FALSE(CalibrationStore(storage).load(record));
+  }
+}
+
+// A record from another firmware version is refused even when its checksum holds
+void test_other_version_does_not_load(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  CalibrationStore(storage).save(GYRO, ACC, 25.0f);
+  CalibrationRecord record = readRaw();
+  record.version++;
+  record.crc = Crc::crc32(&record, offsetof(CalibrationRecord, crc));
+  writeRaw(&record, sizeof(record));
+
+  TEST_ASSERT_FALSE(CalibrationStore(storage).load(record));
+}
+
+void test_failed_write_is_reported_and_keeps_the_old_record(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  CalibrationStore store(storage);
+  store.save(GYRO, ACC, 25.0f);
+
+  storage.failWrites = true;
+  float other[3] = {9.0f, 9.0f, 9.0f};
+  TEST_ASSERT_FALSE(store.save(other, other, 40.0f));
+
+  CalibrationRecord record;
+  TEST_ASSERT_TRUE(store.load(record));
+  TEST_ASSERT_EQUAL_FLOAT(GYRO[0], record.gyroOffsets[0]);
+}
+
+void test_nvs_storage_keys_are_independent(void) {
+  NvsCalibrationStorage offsets;
+  NvsCalibrationStorage other("other");
+  CalibrationStore(offsets).save(GYRO, ACC, 25.0f);
+
+  CalibrationRecord record;
+  TEST_ASSERT_TRUE(CalibrationStore(offsets).load(record));
+  TEST_ASSERT_FALSE(CalibrationStore(other).load(record));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_saved_offsets_load_after_reopen);
+  RUN_TEST(test_missing_record_does_not_load);
+  RUN_TEST(test_truncated_record_does_not_load);
+  RUN_TEST(test_every_flipped_byte_is_caught);
+  RUN_TEST(test_other_version_does_not_load);
+  RUN_TEST(test_failed_write_is_reported_and_keeps_the_old_record);
+  RUN_TEST(test_nvs_storage_keys_are_independent);
+  return UNITY_END();
+}
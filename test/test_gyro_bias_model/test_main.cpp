@@ -0,0 +1,279 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "Crc.h"
+#include "GyroBiasModel.h"
+
+// NVS stand-in: the record's bytes in a file, so each test can reopen them as a reboot would
+class FileCalibrationStorage : public CalibrationStorage {
+  public:
+    explicit FileCalibrationStorage(const char* path) : path(path) {
+    }
+
+    size_t read(void* data, size_t length) override {
+      FILE* file = fopen(path, "rb");
+      if (file == NULL) {
+        return 0;
+      }
+      size_t bytesRead = fread(data, 1, length, file);
+      fclose(file);
+      return bytesRead;
+    }
+
+    bool write(const void* data, size_t length) override {
+      FILE* file = fopen(path, "wb");
+      if (file == NULL) {
+        return false;
+      }
+      bool written = fwrite(data, 1, length, file) == length;
+      fclose(file);
+      return written;
+    }
+
+    const char* path;
+};
+
+static const char* RECORD_PATH = "gyro_bias_model_test.bin";
+static const float COOL[3] = {-1.2f, 0.4f, 2.0f};  // learned at 18 C, a node
+static const float WARM[3] = {-0.4f, 0.8f, 3.6f};  // learned at 34 C, four nodes up
+
+static GyroBiasRecord readRaw() {
+  GyroBiasRecord record = {};
+  FileCalibrationStorage(RECORD_PATH).read(&record, sizeof(record));
+  return record;
+}
+
+static void writeRaw(const void* data, size_t length) {
+  FileCalibrationStorage(RECORD_PATH).write(data, length);
+}
+
+static void assertLookup(const GyroBiasModel& model, float temperatureC, const float expected[3]) {
+  float bias[3];
+  model.lookup(temperatureC, bias);
+  for (int axis = 0; axis < 3; axis++) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, expected[axis], bias[axis]);
+  }
+}
+
+// A model that has learned COOL and WARM at their nodes, each to full weight
+static void learnTwoNodes(GyroBiasModel& model) {
+  model.observe(18.0f, COOL, BIAS_MODEL_MAX_WEIGHT);
+  model.observe(34.0f, WARM, BIAS_MODEL_MAX_WEIGHT);
+}
+
+static void between(float t, float out[3]) {
+  for (int axis = 0; axis < 3; axis++) {
+    out[axis] = COOL[axis] + t * (WARM[axis] - COOL[axis]);
+  }
+}
+
+void setUp(void) {
+  remove(RECORD_PATH);
+}
+
+void tearDown(void) {
+  remove(RECORD_PATH);
+}
+
+void test_unlearned_nodes_interpolate_between_learned_ones(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+
+  static const float TEMPERATURES_C[] = {18.0f, 20.0f, 23.5f, 26.0f, 31.0f, 34.0f};
+  for (float temperatureC : TEMPERATURES_C) {
+    float expected[3];
+    between((temperatureC - 18.0f) / 16.0f, expected);
+    assertLookup(model, temperatureC, expected);
+  }
+  TEST_ASSERT_EQUAL_INT(2, model.getLearnedNodes());
+  TEST_ASSERT_TRUE(model.covers(19.0f));
+  TEST_ASSERT_FALSE(model.covers(26.0f));
+}
+
+void test_ends_hold_flat(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+
+  assertLookup(model, -20.0f, COOL);
+  assertLookup(model, 10.0f, COOL);
+  assertLookup(model, 15.0f, COOL);
+  assertLookup(model, 40.0f, WARM);
+  assertLookup(model, 54.0f, WARM);
+  assertLookup(model, 90.0f, WARM);
+}
+
+// A running mean up to BIAS_MODEL_MAX_WEIGHT windows, an exponential one after
+void test_weight_saturates(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  TEST_ASSERT_TRUE(model.isEmpty());
+
+  float sum = 0.0f;
+  for (int i = 0; i < BIAS_MODEL_MAX_WEIGHT; i++) {
+    float bias[3] = {(float)i, 0.0f, 0.0f};
+    sum += i;
+    model.observe(26.0f, bias, 1);
+  }
+  float mean[3] = {sum / BIAS_MODEL_MAX_WEIGHT, 0.0f, 0.0f};
+  assertLookup(model, 26.0f, mean);
+  TEST_ASSERT_FALSE(model.isEmpty());
+
+  float far[3] = {mean[0] + 16.0f, 0.0f, 0.0f};
+  model.observe(26.0f, far, 1);
+  float moved[3] = {mean[0] + 16.0f / BIAS_MODEL_MAX_WEIGHT, 0.0f, 0.0f};
+  assertLookup(model, 26.0f, moved);
+
+  // More weight than the node can hold replaces it outright
+  model.observe(26.0f, COOL, BIAS_MODEL_MAX_WEIGHT + 4);
+  assertLookup(model, 26.0f, COOL);
+}
+
+// After a calibration the model reads what it measured, however long the node had learned for
+void test_calibration_is_read_back_at_its_temperature(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+
+  static const float TEMPERATURES_C[] = {18.0f, 27.3f, 34.0f, 45.0f, 5.0f};
+  for (float temperatureC : TEMPERATURES_C) {
+    float before18[3];
+    float before34[3];
+    model.lookup(18.0f, before18);
+    model.lookup(34.0f, before34);
+    float calibrated[3];
+    model.lookup(temperatureC, calibrated);
+    calibrated[0] += 0.5f;
+    calibrated[2] -= 0.25f;
+
+    model.calibrate(temperatureC, calibrated);
+    assertLookup(model, temperatureC, calibrated);
+    // The sensor shifted as a whole, so the rest of the curve moved with it
+    float shifted18[3] = {before18[0] + 0.5f, before18[1], before18[2] - 0.25f};
+    float shifted34[3] = {before34[0] + 0.5f, before34[1], before34[2] - 0.25f};
+    assertLookup(model, 18.0f, shifted18);
+    assertLookup(model, 34.0f, shifted34);
+    TEST_ASSERT_TRUE(model.covers(temperatureC));
+  }
+}
+
+// The windows after a calibration average on from its weight
+void test_calibration_restarts_its_node(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+  model.calibrate(18.0f, WARM);
+  assertLookup(model, 18.0f, WARM);
+
+  float next[3] = {WARM[0] + 9.0f, WARM[1], WARM[2]};
+  model.observe(18.0f, next, 1);
+  float expected[3] = {WARM[0] + 9.0f / (BIAS_MODEL_CALIBRATION_WEIGHT + 1), WARM[1], WARM[2]};
+  assertLookup(model, 18.0f, expected);
+}
+
+void test_calibration_seeds_an_empty_model(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  model.calibrate(30.0f, COOL);
+
+  TEST_ASSERT_FALSE(model.isEmpty());
+  TEST_ASSERT_TRUE(model.isDirty());
+  TEST_ASSERT_EQUAL_INT(1, model.getLearnedNodes());
+  assertLookup(model, 0.0f, COOL);
+  assertLookup(model, 30.0f, COOL);
+  assertLookup(model, 60.0f, COOL);
+}
+
+void test_saved_model_loads_after_reopen(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+  model.calibrate(27.0f, COOL);
+  TEST_ASSERT_TRUE(model.save());
+  TEST_ASSERT_FALSE(model.isDirty());
+
+  FileCalibrationStorage reopened(RECORD_PATH);
+  GyroBiasModel loaded(reopened);
+  TEST_ASSERT_TRUE(loaded.load());
+  TEST_ASSERT_FALSE(loaded.isDirty());
+  TEST_ASSERT_EQUAL_INT(model.getLearnedNodes(), loaded.getLearnedNodes());
+  for (float temperatureC = 0.0f; temperatureC <= 60.0f; temperatureC += 1.5f) {
+    float expected[3];
+    float bias[3];
+    model.lookup(temperatureC, expected);
+    loaded.lookup(temperatureC, bias);
+    for (int axis = 0; axis < 3; axis++) {
+      TEST_ASSERT_FLOAT_WITHIN(0.0011f, expected[axis], bias[axis]);  // stored in milli-deg/s
+    }
+  }
+}
+
+void test_missing_or_truncated_record_does_not_load(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  TEST_ASSERT_FALSE(model.load());
+
+  learnTwoNodes(model);
+  model.save();
+  GyroBiasRecord record = readRaw();
+  writeRaw(&record, sizeof(record) - 1);
+  GyroBiasModel loaded(storage);
+  TEST_ASSERT_FALSE(loaded.load());
+  TEST_ASSERT_TRUE(loaded.isEmpty());
+}
+
+void test_every_flipped_byte_is_caught(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+  model.save();
+  GyroBiasRecord saved = readRaw();
+
+  for (size_t i = 0; i < offsetof(GyroBiasRecord, crc) + sizeof(saved.crc); i++) {
+    GyroBiasRecord corrupted = saved;
+    ((uint8_t*)&corrupted)[i] ^= 0x10;
+    writeRaw(&corrupted, sizeof(corrupted));
+
+    GyroBiasModel loaded(storage);
+    TEST_ASSERT_FALSE(loaded.load());
+    TEST_ASSERT_TRUE(loaded.isEmpty());
+  }
+}
+
+// A record from another firmware version or node layout is refused even when its checksum holds
+void test_other_version_or_layout_does_not_load(void) {
+  FileCalibrationStorage storage(RECORD_PATH);
+  GyroBiasModel model(storage);
+  learnTwoNodes(model);
+  model.save();
+  GyroBiasRecord saved = readRaw();
+
+  GyroBiasRecord record = saved;
+  record.version++;
+  record.crc = Crc::crc32(&record, offsetof(GyroBiasRecord, crc));
+  writeRaw(&record, sizeof(record));
+  TEST_ASSERT_FALSE(GyroBiasModel(storage).load());
+
+  record = saved;
+  record.nodes--;
+  record.crc = Crc::crc32(&record, offsetof(GyroBiasRecord, crc));
+  writeRaw(&record, sizeof(record));
+  TEST_ASSERT_FALSE(GyroBiasModel(storage).load());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_unlearned_nodes_interpolate_between_learned_ones);
+  RUN_TEST(test_ends_hold_flat);
+  RUN_TEST(test_weight_saturates);
+  RUN_TEST(test_calibration_is_read_back_at_its_temperature);
+  RUN_TEST(test_calibration_restarts_its_node);
+  RUN_TEST(test_calibration_seeds_an_empty_model);
+  RUN_TEST(test_saved_model_loads_after_reopen);
+  RUN_TEST(test_missing_or_truncated_record_does_not_load);
+  RUN_TEST(test_every_flipped_byte_is_caught);
+  RUN_TEST(test_other_version_or_layout_does_not_load);
+  return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+
+#include "I2CBus.h"
+#include "I2CHealth.h"
+#include "Wire.h"
+#include "hardware_config.h"
+
+// Faults are injected into the Wire and GPIO stand-ins: devices that leave the bus or stop
+// answering, and a slave that holds SDA low until it is clocked out
+
+static unsigned long nowMs;
+static float reading[6];
+
+static void healthyBus() {
+  HostI2CBus& bus = hostI2CBus();
+  memset(&bus, 0, sizeof(bus));
+  bus.present[MPU_I2C_ADDRESS] = true;
+  bus.present[OLED_I2C_ADDRESS] = true;
+  hostI2CLines() = {0, false, 0, HIGH, HIGH};
+  I2CBus::begin();
+}
+
+// A live sensor never repeats a reading exactly
+static void nextReading() {
+  reading[0] += 0.001f;
+  reading[5] -= 0.01f;
+}
+
+// Runs samples one millisecond apart; returns how many asked for a recovery
+static int runSamples(I2CHealth& health, int samples, bool frozen) {
+  int recoveries = 0;
+  for (int i = 0; i < samples; i++) {
+    nowMs++;
+    if (!frozen) {
+      nextReading();
+    }
+    if (health.check(reading, nowMs)) {
+      health.noteRecovery(nowMs);
+      recoveries++;
+    }
+  }
+  return recoveries;
+}
+
+void setUp(void) {
+  healthyBus();
+  nowMs = 10000;
+  memset(reading, 0, sizeof(reading));
+}
+
+void tearDown(void) {
+}
+
+void test_healthy_bus_is_left_alone(void) {
+  I2CHealth health;
+  I2CFaultCounters before = I2CBus::getFaultCounters();
+
+  TEST_ASSERT_EQUAL_INT(0, runSamples(health, 1000, false));
+  TEST_ASSERT_EQUAL_UINT32(before.deviceFaults[I2C_DEVICE_MPU],
+                           I2CBus::getFaultCounters().deviceFaults[I2C_DEVICE_MPU]);
+  TEST_ASSERT_EQUAL_UINT32(before.deviceFaults[I2C_DEVICE_OLED],
+                           I2CBus::getFaultCounters().deviceFaults[I2C_DEVICE_OLED]);
+}
+
+void test_frozen_samples_call_for_recovery(void) {
+  I2CHealth health;
+  runSamples(health, 5, false);
+  uint32_t faults = I2CBus::getFaultCounters().deviceFaults[I2C_DEVICE_MPU];
+
+  TEST_ASSERT_EQUAL_INT(0, runSamples(health, I2C_FROZEN_SAMPLE_LIMIT - 1, true));
+  TEST_ASSERT_EQUAL_INT(1, runSamples(health, 1, true));
+  TEST_ASSERT_EQUAL_UINT32(faults + 1, I2CBus::getFaultCounters().deviceFaults[I2C_DEVICE_MPU]);
+}
+
+void test_probes_run_on_their_interval(void) {
+  I2CHealth health;
+  runSamples(health, 1, false);
+  int transactions = hostI2CBus().transactions;
+
+  runSamples(health, I2C_HEALTH_CHECK_INTERVAL_MS * 10, false);
+  TEST_ASSERT_EQUAL_INT(2 * 10, hostI2CBus().transactions - transactions);
+}
+
+void test_missing_display_is_found_by_its_probe(void) {
+  I2CHealth health;
+  runSamples(health, 1, false);
+  uint32_t faults = I2CBus::getFaultCounters().deviceFaults[I2C_DEVICE_OLED];
+
+  hostI2CBus().present[OLED_I2C_ADDRESS] = false;
+  TEST_ASSERT_EQUAL_INT(1, runSamples(health, I2C_HEALTH_CHECK_INTERVAL_MS, false));
+  TEST_ASSERT_EQUAL_UINT32(faults + 1, I2CBus::getFaultCounters().deviceFaults[I2C_DEVICE_OLED]);
+}
+
+// A device that stays down is faulted on every probe but recovered at most once per backoff
+void test_recoveries_back_off(void) {
+  I2CHealth health;
+  hostI2CBus().failed[MPU_I2C_ADDRESS] = true;
+
+  int recoveries = runSamples(health, I2C_RECOVERY_BACKOFF_MS * 4, false);
+  TEST_ASSERT_TRUE(recoveries >= 3);
+  TEST_ASSERT_TRUE(recoveries <= 4);
+}
+
+void test_recover_clocks_out_a_stuck_slave(void) {
+  hostI2CLines().sdaHeldForPulses = 5;
+  TEST_ASSERT_FALSE(I2CBus::probe(MPU_I2C_ADDRESS));
+
+  int begins = hostI2CBus().begins;
+  TEST_ASSERT_TRUE(I2CBus::recover());
+  TEST_ASSERT_EQUAL_INT(5, hostI2CLines().sclPulses);
+  TEST_ASSERT_EQUAL_INT(begins + 1, hostI2CBus().begins);
+  TEST_ASSERT_TRUE(I2CBus::probe(MPU_I2C_ADDRESS));
+}
+
+void test_recover_leaves_a_free_bus_unclocked(void) {
+  TEST_ASSERT_TRUE(I2CBus::recover());
+  TEST_ASSERT_EQUAL_INT(0, hostI2CLines().sclPulses);
+}
+
+void test_recover_reports_a_bus_it_cannot_free(void) {
+  hostI2CLines().sdaHeldForPulses = -1;
+  TEST_ASSERT_FALSE(I2CBus::recover());
+  TEST_ASSERT_EQUAL_INT(9, hostI2CLines().sclPulses);
+
+  healthyBus();
+  hostI2CLines().sclHeldLow = true;
+  TEST_ASSERT_FALSE(I2CBus::recover());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_healthy_bus_is_left_alone);
+  RUN_TEST(test_frozen_samples_call_for_recovery);
+  RUN_TEST(test_probes_run_on_their_interval);
+  RUN_TEST(test_missing_display_is_found_by_its_probe);
+  RUN_TEST(test_recoveries_back_off);
+  RUN_TEST(test_recover_clocks_out_a_stuck_slave);
+  RUN_TEST(test_recover_leaves_a_free_bus_unclocked);
+  RUN_TEST(test_recover_reports_a_bus_it_cannot_free);
+  return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#include <unity.h>
+
+#include <math.h>
+
+#include "LinkStats.h"
+
+// A simulated link between us and one peer, run the way LinkProbe runs it: a ping every
+// PING_PERIOD_US, stamped on both clocks. The peer's crystal runs driftPpm fast of ours, and each
+// direction takes a fixed delay plus exponential jitter, as ESP-NOW retries give.
+
+static const int64_t PING_PERIOD_US = 2000000;  // LinkProbe's turn for each of two slaves
+static const int64_t PEER_TURNAROUND_US = 150;
+// The fastest exchange in a window can still be late in one direction, by up to twice this
+static const int TOLERANCE_US = 500;
+
+struct SimulatedLink {
+    int64_t nowUs;           // our clock
+    double peerStartUs;      // the peer's clock when ours read 0
+    double driftPpm;
+    int64_t baseUs;          // each direction
+    double forwardJitterUs;  // means of the exponential jitter
+    double reverseJitterUs;
+    uint32_t seed;
+};
+
+static SimulatedLink makeLink(double driftPpm) {
+  return {0, 5e8, driftPpm, 1200, 700.0, 250.0, 12345};
+}
+
+static double uniform(SimulatedLink& link) {
+  link.seed = link.seed * 1664525u + 1013904223u;
+  return ((link.seed >> 8) + 0.5) / 16777216.0;
+}
+
+static int64_t peerClockUs(const SimulatedLink& link, int64_t ourUs) {
+  return (int64_t)(link.peerStartUs + ourUs * (1.0 + link.driftPpm * 1e-6));
+}
+
+static int64_t trueOffsetUs(const SimulatedLink& link, int64_t ourUs) {
+  return peerClockUs(link, ourUs) - ourUs;
+}
+
+// One ping and its pong; the forward delay as it really was
+static int64_t exchange(SimulatedLink& link, LinkStats& stats, int64_t forwardUs,
+                        int64_t reverseUs) {
+  int64_t sentUs = link.nowUs;
+  int64_t peerReceivedUs = peerClockUs(link, sentUs + forwardUs);
+  int64_t peerSentUs = peerClockUs(link, sentUs + forwardUs + PEER_TURNAROUND_US);
+  int64_t receivedUs = sentUs + forwardUs + PEER_TURNAROUND_US + reverseUs;
+  stats.recordPingSent();
+  stats.recordExchange(sentUs, peerReceivedUs, peerSentUs, receivedUs);
+  link.nowUs += PING_PERIOD_US;
+  return forwardUs;
+}
+
+static int64_t exchange(SimulatedLink& link, LinkStats& stats) {
+  int64_t forwardUs = link.baseUs + (int64_t)(-link.forwardJitterUs * log(uniform(link)));
+  int64_t reverseUs = link.baseUs + (int64_t)(-link.reverseJitterUs * log(uniform(link)));
+  return exchange(link, stats, forwardUs, reverseUs);
+}
+
+// How far the offset estimate is off, at the time of the last exchange
+static int offsetErrorUs(const SimulatedLink& link, const LinkStats& stats) {
+  int64_t atUs = link.nowUs - PING_PERIOD_US;
+  return (int)llabs(stats.getClockOffsetUs(atUs) - trueOffsetUs(link, atUs));
+}
+
+// The largest offset error over the exchanges, taken after each one
+static int runFor(SimulatedLink& link, LinkStats& stats, int exchanges) {
+  int worstUs = 0;
+  for (int i = 0; i < exchanges; i++) {
+    exchange(link, stats);
+    int errorUs = offsetErrorUs(link, stats);
+    worstUs = errorUs > worstUs ? errorUs : worstUs;
+  }
+  return worstUs;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Two hours at 40 ppm drift the clocks 288 ms apart; the estimate has to follow
+void test_offset_follows_drifting_clocks(void) {
+  static const double DRIFTS_PPM[] = {40.0, -25.0, 0.0};
+  for (double driftPpm : DRIFTS_PPM) {
+    SimulatedLink link = makeLink(driftPpm);
+    LinkStats stats;
+    runFor(link, stats, 150);  // five minutes to measure the drift
+    TEST_ASSERT_FLOAT_WITHIN(3.0f, (float)driftPpm, stats.getDriftPpm());
+    TEST_ASSERT_LESS_THAN(TOLERANCE_US, runFor(link, stats, 3600));
+    TEST_ASSERT_FLOAT_WITHIN(3.0f, (float)driftPpm, stats.getDriftPpm());
+  }
+}
+
+void test_one_way_estimate_tracks_the_forward_delay(void) {
+  SimulatedLink link = makeLink(30.0);
+  LinkStats stats;
+  runFor(link, stats, 3600);
+
+  // The mean forward delay is base plus mean jitter; the estimate is a smoothed sample of it
+  double meanForwardUs = link.baseUs + link.forwardJitterUs;
+  double sumUs = 0;
+  for (int i = 0; i < 200; i++) {
+    exchange(link, stats);
+    sumUs += stats.getOneWayEstimateUs();
+  }
+  TEST_ASSERT_FLOAT_WITHIN(300.0f, (float)meanForwardUs, (float)(sumUs / 200));
+  TEST_ASSERT_EQUAL_UINT32(3800, stats.getPongsReceived());
+  TEST_ASSERT_EQUAL_UINT32(0, stats.getForward().getBucket(0));  // never clamped at zero
+}
+
+// An exchange fast in one direction only has the shortest round trip and the most lopsided
+// offset. It sets the offset while it is in the window, and not after.
+void test_lucky_exchange_ages_out(void) {
+  SimulatedLink link = makeLink(20.0);
+  LinkStats stats;
+  runFor(link, stats, 150);
+
+  exchange(link, stats, 100, link.baseUs);
+  TEST_ASSERT_GREATER_THAN(TOLERANCE_US, offsetErrorUs(link, stats));
+
+  runFor(link, stats, LINK_PROBE_OFFSET_WINDOW);
+  TEST_ASSERT_LESS_THAN(TOLERANCE_US, runFor(link, stats, 600));
+  TEST_ASSERT_FLOAT_WITHIN(5.0f, 20.0f, stats.getDriftPpm());
+}
+
+// A slow exchange is never chosen, however lopsided
+void test_late_frame_does_not_move_the_offset(void) {
+  SimulatedLink link = makeLink(-15.0);
+  LinkStats stats;
+  runFor(link, stats, 150);
+
+  exchange(link, stats, link.baseUs + 80000, link.baseUs);
+  TEST_ASSERT_LESS_THAN(TOLERANCE_US, offsetErrorUs(link, stats));
+  TEST_ASSERT_LESS_THAN(TOLERANCE_US, runFor(link, stats, 300));
+}
+
+// The peer's clock starts again from zero; its offset is taken afresh from the next exchange
+void test_peer_restart_resets_the_offset(void) {
+  SimulatedLink link = makeLink(35.0);
+  LinkStats stats;
+  runFor(link, stats, 600);
+
+  link.peerStartUs = -(double)link.nowUs * (1.0 + link.driftPpm * 1e-6);
+  exchange(link, stats);
+  TEST_ASSERT_LESS_THAN(2000, offsetErrorUs(link, stats));
+
+  runFor(link, stats, 150);
+  TEST_ASSERT_LESS_THAN(TOLERANCE_US, runFor(link, stats, 600));
+  TEST_ASSERT_FLOAT_WITHIN(3.0f, 35.0f, stats.getDriftPpm());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_offset_follows_drifting_clocks);
+  RUN_TEST(test_one_way_estimate_tracks_the_forward_delay);
+  RUN_TEST(test_lucky_exchange_ages_out);
+  RUN_TEST(test_late_frame_does_not_move_the_offset);
+  RUN_TEST(test_peer_restart_resets_the_offset);
+  return UNITY_END();
+}
@@ -0,0 +1,168 @@
+#include <unity.h>
+
+#include "OrientationStream.h"
+
+// A player's encoder and the master's view of it, with the frames between them handed over by the
+// test, so any one can be dropped
+
+static const int64_t SAMPLE_PERIOD_US = 1000000 / ORIENTATION_STREAM_RATE_HZ;
+static const size_t KEYFRAME_SIZE = 7;
+static const size_t DELTA_SIZE = 4;
+static const uint32_t SHARE_US = ORIENTATION_STREAM_AIRTIME_US / (NUM_PLAYERS - 1);
+
+static OrientationStreamEncoder encoder;
+static StreamedOrientation received;
+static uint8_t frame[OrientationStreamEncoder::maxFrameSize];
+
+static size_t send(int64_t atUs, float x, float y, float z) {
+  return encoder.encode({atUs, x, y, z}, frame);
+}
+
+// Encodes a sample and applies whatever frame it gave; returns the frame length
+static size_t stream(int64_t atUs, float x, float y, float z) {
+  size_t length = send(atUs, x, y, z);
+  if (length > 0) {
+    TEST_ASSERT_TRUE(received.apply(frame, length, atUs));
+  }
+  return length;
+}
+
+static void assertReceived(float x, float y, float z) {
+  float gotX, gotY, gotZ;
+  received.get(gotX, gotY, gotZ);
+  TEST_ASSERT_EQUAL_FLOAT(x, gotX);
+  TEST_ASSERT_EQUAL_FLOAT(y, gotY);
+  TEST_ASSERT_EQUAL_FLOAT(z, gotZ);
+}
+
+void setUp(void) {
+  encoder.reset();
+  received = StreamedOrientation();
+}
+
+void tearDown(void) {
+}
+
+void test_keyframe_and_deltas_round_trip(void) {
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE, stream(0, 12.5f, -30.0f, 170.5f));
+  assertReceived(12.5f, -30.0f, 170.5f);
+  TEST_ASSERT_TRUE(received.isLive(0));
+
+  TEST_ASSERT_EQUAL_UINT32(DELTA_SIZE, stream(SAMPLE_PERIOD_US, 15.0f, -33.5f, 168.0f));
+  assertReceived(15.0f, -33.5f, 168.0f);
+
+  // Quantized to the nearest ORIENTATION_STREAM_QUANTUM_DEG
+  TEST_ASSERT_EQUAL_UINT32(DELTA_SIZE, stream(2 * SAMPLE_PERIOD_US, 20.2f, -40.3f, 160.1f));
+  assertReceived(20.0f, -40.5f, 160.0f);
+  TEST_ASSERT_EQUAL_UINT32(3, encoder.getFramesSent());
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE + 2 * DELTA_SIZE, encoder.getBytesSent());
+}
+
+void test_small_changes_send_nothing_until_the_heartbeat(void) {
+  stream(0, 10.0f, 10.0f, 10.0f);
+  int64_t atUs = SAMPLE_PERIOD_US;
+  for (; atUs < ORIENTATION_STREAM_KEYFRAME_MS * 1000LL; atUs += SAMPLE_PERIOD_US) {
+    TEST_ASSERT_EQUAL_UINT32(0, stream(atUs, 10.5f, 9.5f, 10.0f));
+  }
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE, stream(atUs, 10.5f, 9.5f, 10.0f));
+  assertReceived(10.5f, 9.5f, 10.0f);
+
+  TEST_ASSERT_TRUE(received.isLive(atUs + 2 * ORIENTATION_STREAM_KEYFRAME_MS * 1000LL - 1));
+  TEST_ASSERT_FALSE(received.isLive(atUs + 2 * ORIENTATION_STREAM_KEYFRAME_MS * 1000LL));
+}
+
+// A delta is one signed byte of quanta per axis from the keyframe; past that a keyframe goes out
+void test_delta_past_int8_sends_a_keyframe(void) {
+  stream(0, 0.0f, 0.0f, 0.0f);
+  float edge = INT8_MAX * ORIENTATION_STREAM_QUANTUM_DEG;
+  TEST_ASSERT_EQUAL_UINT32(DELTA_SIZE, stream(SAMPLE_PERIOD_US, edge, -edge, 0.0f));
+  assertReceived(edge, -edge, 0.0f);
+
+  float past = edge + ORIENTATION_STREAM_QUANTUM_DEG;
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE, stream(2 * SAMPLE_PERIOD_US, past, -edge, 0.0f));
+  assertReceived(past, -edge, 0.0f);
+
+  // Deltas now count from the new keyframe
+  TEST_ASSERT_EQUAL_UINT32(DELTA_SIZE, stream(3 * SAMPLE_PERIOD_US, past - 50.0f, -edge, 0.0f));
+  assertReceived(past - 50.0f, -edge, 0.0f);
+
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE, stream(4 * SAMPLE_PERIOD_US, past, edge, -edge));
+  assertReceived(past, edge, -edge);
+}
+
+// Deltas after a lost keyframe are relative to values the master never had
+void test_lost_keyframe_rejects_the_deltas_after_it(void) {
+  stream(0, 0.0f, 0.0f, 0.0f);
+  stream(SAMPLE_PERIOD_US, 5.0f, 0.0f, 0.0f);
+
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE, send(2 * SAMPLE_PERIOD_US, 90.0f, 0.0f, 0.0f));  // lost
+  TEST_ASSERT_EQUAL_UINT32(DELTA_SIZE, send(3 * SAMPLE_PERIOD_US, 95.0f, 0.0f, 0.0f));
+  TEST_ASSERT_FALSE(received.apply(frame, DELTA_SIZE, 3 * SAMPLE_PERIOD_US));
+  assertReceived(5.0f, 0.0f, 0.0f);
+
+  TEST_ASSERT_EQUAL_UINT32(KEYFRAME_SIZE, stream(4 * SAMPLE_PERIOD_US, 95.0f, 90.0f, 0.0f));
+  assertReceived(95.0f, 90.0f, 0.0f);
+  TEST_ASSERT_EQUAL_UINT32(DELTA_SIZE, stream(5 * SAMPLE_PERIOD_US, 100.0f, 90.0f, 0.0f));
+  assertReceived(100.0f, 90.0f, 0.0f);
+}
+
+void test_malformed_frames_are_rejected(void) {
+  StreamedOrientation fresh;
+  uint8_t delta[DELTA_SIZE] = {0, 1, 2, 3};
+  TEST_ASSERT_FALSE(fresh.apply(delta, sizeof(delta), 0));  // no keyframe yet
+  TEST_ASSERT_FALSE(fresh.isLive(0));
+
+  send(0, 1.0f, 2.0f, 3.0f);
+  TEST_ASSERT_FALSE(fresh.apply(frame, KEYFRAME_SIZE - 1, 0));
+  frame[0] &= 0x7F;  // keyframe length without the keyframe flag
+  TEST_ASSERT_FALSE(fresh.apply(frame, KEYFRAME_SIZE, 0));
+  TEST_ASSERT_FALSE(fresh.isLive(0));
+}
+
+// A player moving all the time, sampled far faster than it streams, stays within its share of
+// the budget
+void test_budget_holds_a_player_to_its_share(void) {
+  const int seconds = 30;
+  const int64_t periodUs = 1000;
+  int64_t atUs = 0;
+  for (; atUs < seconds * 1000000LL; atUs += periodUs) {
+    float angle = (atUs / periodUs % 2) * 10.0f;
+    stream(atUs, angle, -angle, angle);
+  }
+
+  // The burst a full bucket allows on top of the steady rate
+  int allowedUs = SHARE_US * seconds + SHARE_US / 4;
+  int airtimeUs = encoder.getAirtimeUs();
+  TEST_ASSERT_LESS_OR_EQUAL(allowedUs, airtimeUs);
+  TEST_ASSERT_GREATER_THAN(allowedUs - 2 * (int)AirtimeBudget::frameAirtimeUs(KEYFRAME_SIZE),
+                           airtimeUs);
+  TEST_ASSERT_LESS_THAN(seconds * 1000 / 10, (int)encoder.getFramesSent());
+}
+
+// A change the bucket holds back is still sent once it has refilled, without another move
+void test_held_back_change_goes_out_once_the_budget_allows(void) {
+  int frames = 0;
+  while (stream(0, frames * 10.0f, 0.0f, 0.0f) > 0) {
+    frames++;
+  }
+  TEST_ASSERT_EQUAL_INT(SHARE_US / 4 / AirtimeBudget::frameAirtimeUs(DELTA_SIZE), frames);
+  float held = frames * 10.0f;
+  assertReceived(held - 10.0f, 0.0f, 0.0f);
+
+  int64_t refillUs = (int64_t)AirtimeBudget::frameAirtimeUs(DELTA_SIZE) * 1000000 / SHARE_US;
+  TEST_ASSERT_EQUAL_UINT32(0, stream(1000, held, 0.0f, 0.0f));
+  TEST_ASSERT_GREATER_THAN(0, (int)stream(refillUs + SAMPLE_PERIOD_US, held, 0.0f, 0.0f));
+  assertReceived(held, 0.0f, 0.0f);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_keyframe_and_deltas_round_trip);
+  RUN_TEST(test_small_changes_send_nothing_until_the_heartbeat);
+  RUN_TEST(test_delta_past_int8_sends_a_keyframe);
+  RUN_TEST(test_lost_keyframe_rejects_the_deltas_after_it);
+  RUN_TEST(test_malformed_frames_are_rejected);
+  RUN_TEST(test_budget_holds_a_player_to_its_share);
+  RUN_TEST(test_held_back_change_goes_out_once_the_budget_allows);
+  return UNITY_END();
+}
@@ -0,0 +1,492 @@
+#include <unity.h>
+
+#include <stddef.h>
+
+#include "Crc.h"
+#include "EspNowLink.h"
+#include "EventQueue.h"
+#include "PhaseScript.h"
+#include "PhaseScriptTransfer.h"
+#include "TimerWheel.h"
+
+// One host process plays the master and a slave at once: tests hand it the frames the other end
+// would send and read back what it sent. The "phases" partition lives in RAM and keeps its
+// contents from test to test as flash would, so script ids only ever go up.
+
+// tools/phase_script.py compile of:
+//     script 7
+//     phase cone 0 0 10 2
+//     phase box 0 0 15 3 20
+//     phase yaw-free 30 0 0 5 30
+//     phase cone -45 20 170 4
+//     phase box 10 -30 -90 6 45
+//     phase yaw-free -20 60 0 8
+//     phase cone 0 90 0 3 10
+static const uint8_t COMPILED_SCRIPT[] = {
+    0x31, 0x53, 0x48, 0x50, 0x01, 0x00, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x97, 0x04, 0x52, 0x33,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x41,
+    0x00, 0x00, 0x00, 0x40, 0x9e, 0x06, 0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xb6, 0x7e, 0xb2, 0x3d, 0x05, 0xf6, 0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x41, 0x00, 0x00, 0x40, 0x40,
+    0x55, 0xcf, 0x7d, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa8, 0xa8, 0x05, 0x3e,
+    0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x41,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa0, 0x40, 0xea, 0x46, 0x77, 0x3f,
+    0xee, 0x83, 0x84, 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9e, 0x06, 0x7f, 0x3f,
+    0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x34, 0xc2, 0x00, 0x00, 0xa0, 0x41,
+    0x00, 0x00, 0x2a, 0x43, 0x00, 0x00, 0x80, 0x40, 0xea, 0x9b, 0x56, 0x3c, 0x33, 0x4a, 0x45, 0xbe,
+    0x62, 0x10, 0xb9, 0xbe, 0x2f, 0x84, 0x69, 0x3f, 0x14, 0xd8, 0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x41, 0x00, 0x00, 0xf0, 0xc1, 0x00, 0x00, 0xb4, 0xc2,
+    0x00, 0x00, 0xc0, 0x40, 0xed, 0x44, 0x32, 0x3f, 0x2c, 0x78, 0xfb, 0xbd, 0x27, 0xa6, 0x77, 0xbe,
+    0x40, 0x1a, 0x2a, 0xbf, 0x00, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xa0, 0xc1, 0x00, 0x00, 0x70, 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x41,
+    0x98, 0x55, 0x5a, 0x3f, 0x31, 0xfe, 0x19, 0xbe, 0x5c, 0x1c, 0xfc, 0x3e, 0xd4, 0xd0, 0xb1, 0x3d,
+    0x35, 0x82, 0x7d, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xb4, 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x40, 0xf3, 0x04, 0x35, 0x3f,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x04, 0x35, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x8b, 0xe9, 0x7f, 0x3f,
+    0x0a, 0x00, 0x00, 0x00,
+};
+
+// What the firmware builds for the same phases
+static const PhaseRecord EXPECTED_PHASES[] = {
+    {OrientationTarget::cone(0, 0, 10, 2), 0},
+    {OrientationTarget::box(0, 0, 15, 3), 20},
+    {OrientationTarget::yawFree(30, 0, 5), 30},
+    {OrientationTarget::cone(-45, 20, 170, 4), 0},
+    {OrientationTarget::box(10, -30, -90, 6), 45},
+    {OrientationTarget::yawFree(-20, 60, 8), 0},
+    {OrientationTarget::cone(0, 90, 0, 3), 10},
+};
+
+static const uint32_t SCRIPT_SIZE = sizeof(COMPILED_SCRIPT);
+static const uint32_t CHUNK_SIZE = 192;
+static const uint8_t LINK_MAGIC = 0x7E;  // EspNowLink's first byte, ahead of the frame type
+
+static const uint8_t MASTER_MAC[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+static const uint8_t SLAVE_MAC[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x02};
+
+// PhaseScriptTransfer's frames as they go over the air
+struct __attribute__((packed)) Offer {
+    uint32_t scriptId;
+    uint32_t size;
+    uint32_t crc;
+};
+
+struct __attribute__((packed)) Request {
+    uint32_t scriptId;
+    uint32_t offset;
+};
+
+struct __attribute__((packed)) Chunk {
+    uint32_t scriptId;
+    uint32_t offset;
+    uint16_t length;
+    uint8_t data[CHUNK_SIZE];
+};
+
+static esp_partition_t* phases;
+static size_t framesSeen = 0;
+
+// The compiled script under another id. The id is in the header, outside the record CRC.
+static void makeScript(uint8_t blob[], uint32_t scriptId) {
+  memcpy(blob, COMPILED_SCRIPT, SCRIPT_SIZE);
+  reinterpret_cast<PhaseScriptHeader*>(blob)->scriptId = scriptId;
+}
+
+static void resealScript(uint8_t blob[]) {
+  PhaseScriptHeader* header = reinterpret_cast<PhaseScriptHeader*>(blob);
+  header->crc = Crc::crc32(blob + sizeof(PhaseScriptHeader), SCRIPT_SIZE - sizeof(*header));
+}
+
+// The slot an install writes to: whichever one is not mapped
+static const uint8_t* spareSlot() {
+  const uint8_t* first = phases->data;
+  return PhaseScript::getBlob() == first ? first + PhaseScript::slotSize : first;
+}
+
+static uint32_t chunkLength(uint32_t offset) {
+  return SCRIPT_SIZE - offset < CHUNK_SIZE ? SCRIPT_SIZE - offset : CHUNK_SIZE;
+}
+
+// The main loop's share of the work, as processEvents does it
+static void runLoop() {
+  Event event;
+  while (EventQueue::poll(event)) {
+    TimerId id;
+    if (event.type == EVENT_SCRIPT_FRAME) {
+      PhaseScriptTransfer::service();
+    } else if (event.type == EVENT_TIMER_EXPIRED && TimerWheel::claimExpiry(event.value, id)) {
+      if (id == TIMER_SCRIPT_OFFER) {
+        PhaseScriptTransfer::offer();
+      } else if (id == TIMER_SCRIPT_TRANSFER) {
+        PhaseScriptTransfer::retry();
+      } else if (id == TIMER_LINK_FLUSH) {
+        EspNowLink::flush();
+      }
+    }
+  }
+}
+
+// In 10 ms steps, so each expiry is handled before the next one is due
+static void advanceMs(uint32_t ms) {
+  int64_t untilUs = hostTimeUs() + ms * 1000LL;
+  while (hostTimeUs() < untilUs) {
+    int64_t stepUs = hostTimeUs() + 10000;
+    hostRunTimersUntil(stepUs < untilUs ? stepUs : untilUs);
+    runLoop();
+  }
+}
+
+static void deliver(const uint8_t* mac, LinkFrameType type, const void* payload, size_t length) {
+  uint8_t frame[ESP_NOW_MAX_DATA_LEN] = {LINK_MAGIC, type};
+  memcpy(frame + 2, payload, length);
+  hostRadioReceive(mac, frame, 2 + length);
+  runLoop();
+}
+
+static void deliverOffer(uint32_t scriptId, const uint8_t blob[]) {
+  Offer offer = {scriptId, SCRIPT_SIZE, Crc::crc32(blob, SCRIPT_SIZE)};
+  deliver(MASTER_MAC, LINK_FRAME_SCRIPT_OFFER, &offer, sizeof(offer));
+}
+
+static void deliverChunk(uint32_t scriptId, const uint8_t blob[], uint32_t offset) {
+  Chunk chunk;
+  chunk.scriptId = scriptId;
+  chunk.offset = offset;
+  chunk.length = chunkLength(offset);
+  memcpy(chunk.data, blob + offset, chunk.length);
+  deliver(MASTER_MAC, LINK_FRAME_SCRIPT_CHUNK, &chunk, offsetof(Chunk, data) + chunk.length);
+}
+
+// Payloads of the frames of one type sent to mac since the last call; other frames are skipped
+static int takeSent(LinkFrameType type, const uint8_t* mac, uint8_t out[][ESP_NOW_MAX_DATA_LEN],
+                    size_t lengths[], int capacity) {
+  int count = 0;
+  std::vector<HostFrame>& frames = hostRadio().frames;
+  for (; framesSeen < frames.size(); framesSeen++) {
+    const HostFrame& frame = frames[framesSeen];
+    if (frame.data[0] == LINK_MAGIC && frame.data[1] == type &&
+        memcmp(frame.mac, mac, sizeof(frame.mac)) == 0 && count < capacity) {
+      lengths[count] = frame.data.size() - 2;
+      memcpy(out[count], frame.data.data() + 2, lengths[count]);
+      count++;
+    }
+  }
+  return count;
+}
+
+// Requests the slave side sent to the master since the last call
+static int takeRequests(Request requests[], int capacity) {
+  uint8_t payloads[16][ESP_NOW_MAX_DATA_LEN];
+  size_t lengths[16];
+  int count = takeSent(LINK_FRAME_SCRIPT_REQUEST, MASTER_MAC, payloads, lengths,
+                       capacity < 16 ? capacity : 16);
+  for (int i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT32(sizeof(Request), lengths[i]);
+    memcpy(&requests[i], payloads[i], sizeof(Request));
+  }
+  return count;
+}
+
+static void expectRequest(uint32_t scriptId, uint32_t offset) {
+  Request requests[4];
+  TEST_ASSERT_EQUAL_INT(1, takeRequests(requests, 4));
+  TEST_ASSERT_EQUAL_UINT32(scriptId, requests[0].scriptId);
+  TEST_ASSERT_EQUAL_UINT32(offset, requests[0].offset);
+}
+
+void setUp(void) {
+  advanceMs(60000);  // whatever the last test left scheduled runs out
+  framesSeen = hostRadio().frames.size();
+}
+
+void tearDown(void) {
+}
+
+void test_compiled_script_is_the_firmware_layout(void) {
+  TEST_ASSERT_TRUE(PhaseScript::validate(COMPILED_SCRIPT, SCRIPT_SIZE));
+
+  const PhaseScriptHeader* header = reinterpret_cast<const PhaseScriptHeader*>(COMPILED_SCRIPT);
+  const PhaseRecord* records = reinterpret_cast<const PhaseRecord*>(header + 1);
+  int count = sizeof(EXPECTED_PHASES) / sizeof(EXPECTED_PHASES[0]);
+  TEST_ASSERT_EQUAL_UINT32(7, header->scriptId);
+  TEST_ASSERT_EQUAL_INT(count, header->phaseCount);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(PhaseScriptHeader) + count * sizeof(PhaseRecord), SCRIPT_SIZE);
+
+  for (int i = 0; i < count; i++) {
+    const OrientationTarget& expected = EXPECTED_PHASES[i].target;
+    const OrientationTarget& actual = records[i].target;
+    TEST_ASSERT_EQUAL_UINT8(expected.shape, actual.shape);
+    TEST_ASSERT_EQUAL_FLOAT(expected.roll, actual.roll);
+    TEST_ASSERT_EQUAL_FLOAT(expected.pitch, actual.pitch);
+    TEST_ASSERT_EQUAL_FLOAT(expected.yaw, actual.yaw);
+    TEST_ASSERT_EQUAL_FLOAT(expected.tolerance, actual.tolerance);
+    // Python's math library against the firmware's compile-time series
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected.q.w, actual.q.w);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected.q.x, actual.q.x);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected.q.y, actual.q.y);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected.q.z, actual.q.z);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected.threshold, actual.threshold);
+    TEST_ASSERT_EQUAL_UINT32(EXPECTED_PHASES[i].timeLimitSeconds, records[i].timeLimitSeconds);
+  }
+}
+
+void test_damaged_scripts_fail_validation(void) {
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+  PhaseScriptHeader* header = reinterpret_cast<PhaseScriptHeader*>(blob);
+  PhaseRecord* records = reinterpret_cast<PhaseRecord*>(header + 1);
+
+  makeScript(blob, 7);
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, sizeof(PhaseScriptHeader) - 1));
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, SCRIPT_SIZE - 1));
+
+  header->magic ^= 1;
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, SCRIPT_SIZE));
+
+  makeScript(blob, 7);
+  header->version = PhaseScript::version + 1;
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, SCRIPT_SIZE));
+
+  makeScript(blob, 7);
+  header->phaseCount = 0;
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, SCRIPT_SIZE));
+  header->phaseCount = MAX_PHASES + 1;
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, SCRIPT_SIZE));
+
+  // Every record byte is covered by the CRC
+  for (uint32_t offset = sizeof(PhaseScriptHeader); offset < SCRIPT_SIZE; offset++) {
+    makeScript(blob, 7);
+    blob[offset] ^= 0x10;
+    TEST_ASSERT_FALSE_MESSAGE(PhaseScript::validate(blob, SCRIPT_SIZE), "flipped bit passed");
+  }
+
+  // A shape this firmware does not know fails even with a matching CRC
+  makeScript(blob, 7);
+  records[3].target.shape = (ToleranceShape)(TOLERANCE_YAW_FREE + 1);
+  resealScript(blob);
+  TEST_ASSERT_FALSE(PhaseScript::validate(blob, SCRIPT_SIZE));
+}
+
+// Whatever the pieces, the slot only validates once finishInstall has written the header
+void test_install_validates_only_once_finished(void) {
+  static const uint32_t PIECES[] = {1, 7, 15, 16, 17, 44, 191, SCRIPT_SIZE};
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+
+  uint32_t scriptId = 10;
+  for (uint32_t piece : PIECES) {
+    makeScript(blob, scriptId);
+    TEST_ASSERT_TRUE(PhaseScript::beginInstall(scriptId, SCRIPT_SIZE));
+    for (uint32_t offset = 0; offset < SCRIPT_SIZE; offset += piece) {
+      uint32_t length = SCRIPT_SIZE - offset < piece ? SCRIPT_SIZE - offset : piece;
+      TEST_ASSERT_TRUE(PhaseScript::writeInstall(offset, blob + offset, length));
+      TEST_ASSERT_FALSE(PhaseScript::validate(spareSlot(), PhaseScript::maxSize));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, PhaseScript::getInstalledScriptId());
+
+    TEST_ASSERT_TRUE(PhaseScript::finishInstall(Crc::crc32(blob, SCRIPT_SIZE)));
+    TEST_ASSERT_EQUAL_UINT32(scriptId, PhaseScript::getInstalledScriptId());
+    TEST_ASSERT_TRUE(PhaseScript::validate(spareSlot(), PhaseScript::maxSize));
+    TEST_ASSERT_EQUAL_MEMORY(blob, spareSlot(), SCRIPT_SIZE);
+    scriptId++;
+  }
+
+  // Past the size it was begun with, and a CRC that does not match what was written
+  makeScript(blob, scriptId);
+  TEST_ASSERT_TRUE(PhaseScript::beginInstall(scriptId, SCRIPT_SIZE));
+  TEST_ASSERT_FALSE(PhaseScript::writeInstall(SCRIPT_SIZE - 4, blob, 8));
+  TEST_ASSERT_TRUE(PhaseScript::writeInstall(0, blob, SCRIPT_SIZE));
+  TEST_ASSERT_FALSE(PhaseScript::finishInstall(Crc::crc32(blob, SCRIPT_SIZE) ^ 1));
+  TEST_ASSERT_EQUAL_UINT32(0, PhaseScript::getInstalledScriptId());
+  TEST_ASSERT_FALSE(PhaseScript::validate(spareSlot(), PhaseScript::maxSize));
+}
+
+// Power lost as the header goes down: nothing is mapped at the next boot
+void test_interrupted_install_is_not_mapped_after_restart(void) {
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+  makeScript(blob, 20);
+  TEST_ASSERT_TRUE(PhaseScript::beginInstall(20, SCRIPT_SIZE));
+  TEST_ASSERT_TRUE(PhaseScript::writeInstall(0, blob, SCRIPT_SIZE));
+  phases->failWritesAfter = 0;
+  TEST_ASSERT_FALSE(PhaseScript::finishInstall(Crc::crc32(blob, SCRIPT_SIZE)));
+  phases->failWritesAfter = -1;
+  TEST_ASSERT_EQUAL_UINT32(0, PhaseScript::getInstalledScriptId());
+
+  PhaseScript::begin();
+  TEST_ASSERT_EQUAL_UINT32(0, PhaseScript::getScriptId());
+  TEST_ASSERT_NULL(PhaseScript::getBlob());
+}
+
+void test_slave_receives_a_script_chunk_by_chunk(void) {
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+  makeScript(blob, 30);
+
+  deliverOffer(30, blob);
+  expectRequest(30, 0);
+  deliverChunk(30, blob, 0);
+  expectRequest(30, CHUNK_SIZE);
+  deliverChunk(30, blob, CHUNK_SIZE);
+  expectRequest(30, SCRIPT_SIZE);  // received, so the master can stop offering
+  TEST_ASSERT_FALSE(TimerWheel::isPending(TIMER_SCRIPT_TRANSFER));
+  TEST_ASSERT_EQUAL_UINT32(30, PhaseScript::getInstalledScriptId());
+
+  TEST_ASSERT_TRUE(PhaseScript::adoptInstalled());
+  TEST_ASSERT_EQUAL_UINT32(30, PhaseScript::getScriptId());
+  TEST_ASSERT_EQUAL_INT(7, PhaseScript::getPhaseCount());
+  TEST_ASSERT_EQUAL_UINT32(45, PhaseScript::getTimeLimitSeconds(4));
+  TEST_ASSERT_EQUAL_MEMORY(blob, PhaseScript::getBlob(), SCRIPT_SIZE);
+
+  PhaseScript::begin();
+  TEST_ASSERT_EQUAL_UINT32(30, PhaseScript::getScriptId());
+}
+
+void test_stalled_transfer_resumes_where_it_stopped(void) {
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+  makeScript(blob, 31);
+
+  deliverOffer(31, blob);
+  expectRequest(31, 0);
+  deliverChunk(31, blob, 0);
+  expectRequest(31, CHUNK_SIZE);
+  uint32_t erases = phases->erases;
+
+  // The next chunk never comes: the slave asks again, then waits for the next offer
+  advanceMs(PHASE_SCRIPT_RETRY_MS * (PHASE_SCRIPT_MAX_RETRIES + 4));
+  Request requests[16];
+  int count = takeRequests(requests, 16);
+  TEST_ASSERT_EQUAL_INT(PHASE_SCRIPT_MAX_RETRIES, count);
+  for (int i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT32(31, requests[i].scriptId);
+    TEST_ASSERT_EQUAL_UINT32(CHUNK_SIZE, requests[i].offset);
+  }
+
+  // A chunk that was not asked for, such as a late answer to a retry, changes nothing
+  deliverChunk(31, blob, 0);
+  TEST_ASSERT_EQUAL_INT(0, takeRequests(requests, 16));
+
+  deliverOffer(31, blob);
+  expectRequest(31, CHUNK_SIZE);
+  TEST_ASSERT_EQUAL_UINT32(erases, phases->erases);
+  deliverChunk(31, blob, CHUNK_SIZE);
+  expectRequest(31, SCRIPT_SIZE);
+  TEST_ASSERT_EQUAL_UINT32(31, PhaseScript::getInstalledScriptId());
+  TEST_ASSERT_EQUAL_MEMORY(blob, spareSlot(), SCRIPT_SIZE);
+}
+
+void test_changed_offer_starts_the_transfer_over(void) {
+  uint8_t first[sizeof(COMPILED_SCRIPT)];
+  uint8_t second[sizeof(COMPILED_SCRIPT)];
+  makeScript(first, 32);
+  makeScript(second, 32);
+  reinterpret_cast<PhaseRecord*>(second + sizeof(PhaseScriptHeader))[6].timeLimitSeconds = 90;
+  resealScript(second);
+
+  deliverOffer(32, first);
+  expectRequest(32, 0);
+  deliverChunk(32, first, 0);
+  expectRequest(32, CHUNK_SIZE);
+
+  // Same id, other contents: the master was reflashed mid-transfer
+  deliverOffer(32, second);
+  expectRequest(32, 0);
+  deliverChunk(32, second, 0);
+  expectRequest(32, CHUNK_SIZE);
+  deliverChunk(32, second, CHUNK_SIZE);
+  expectRequest(32, SCRIPT_SIZE);
+  TEST_ASSERT_EQUAL_UINT32(32, PhaseScript::getInstalledScriptId());
+  TEST_ASSERT_EQUAL_MEMORY(second, spareSlot(), SCRIPT_SIZE);
+}
+
+void test_offer_of_a_script_already_held_is_declined(void) {
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+  makeScript(blob, 32);
+  uint32_t erases = phases->erases;
+
+  deliverOffer(32, blob);
+  expectRequest(32, SCRIPT_SIZE);
+  deliverOffer(30, blob);
+  expectRequest(30, SCRIPT_SIZE);
+  TEST_ASSERT_EQUAL_UINT32(erases, phases->erases);
+  TEST_ASSERT_FALSE(TimerWheel::isPending(TIMER_SCRIPT_TRANSFER));
+}
+
+void test_script_that_fails_its_crc_is_received_again(void) {
+  uint8_t blob[sizeof(COMPILED_SCRIPT)];
+  makeScript(blob, 33);
+  Offer offer = {33, SCRIPT_SIZE, Crc::crc32(blob, SCRIPT_SIZE) ^ 1};
+
+  deliver(MASTER_MAC, LINK_FRAME_SCRIPT_OFFER, &offer, sizeof(offer));
+  expectRequest(33, 0);
+  deliverChunk(33, blob, 0);
+  expectRequest(33, CHUNK_SIZE);
+  deliverChunk(33, blob, CHUNK_SIZE);
+  Request requests[4];
+  TEST_ASSERT_EQUAL_INT(0, takeRequests(requests, 4));
+  TEST_ASSERT_EQUAL_UINT32(0, PhaseScript::getInstalledScriptId());
+  TEST_ASSERT_EQUAL_UINT32(30, PhaseScript::getScriptId());
+
+  deliverOffer(33, blob);
+  expectRequest(33, 0);
+}
+
+void test_master_serves_its_script_until_the_slave_has_it(void) {
+  uint8_t payloads[4][ESP_NOW_MAX_DATA_LEN];
+  size_t lengths[4];
+  const uint8_t* blob = PhaseScript::getBlob();
+  TEST_ASSERT_EQUAL_UINT32(30, PhaseScript::getScriptId());
+  TEST_ASSERT_TRUE(PhaseScriptTransfer::addPeer(SLAVE_MAC));
+
+  PhaseScriptTransfer::offer();
+  advanceMs(LINK_AGGREGATION_WINDOW_US / 1000 + 10);
+  TEST_ASSERT_EQUAL_INT(1, takeSent(LINK_FRAME_SCRIPT_OFFER, SLAVE_MAC, payloads, lengths, 4));
+  Offer offer;
+  memcpy(&offer, payloads[0], sizeof(offer));
+  TEST_ASSERT_EQUAL_UINT32(30, offer.scriptId);
+  TEST_ASSERT_EQUAL_UINT32(SCRIPT_SIZE, offer.size);
+  TEST_ASSERT_EQUAL_UINT32(Crc::crc32(blob, SCRIPT_SIZE), offer.crc);
+
+  for (uint32_t offset = 0; offset < SCRIPT_SIZE; offset += CHUNK_SIZE) {
+    Request request = {30, offset};
+    deliver(SLAVE_MAC, LINK_FRAME_SCRIPT_REQUEST, &request, sizeof(request));
+    TEST_ASSERT_EQUAL_INT(1, takeSent(LINK_FRAME_SCRIPT_CHUNK, SLAVE_MAC, payloads, lengths, 4));
+    Chunk chunk;
+    memcpy(&chunk, payloads[0], lengths[0]);
+    TEST_ASSERT_EQUAL_UINT32(offset, chunk.offset);
+    TEST_ASSERT_EQUAL_UINT16(chunkLength(offset), chunk.length);
+    TEST_ASSERT_EQUAL_UINT32(offsetof(Chunk, data) + chunkLength(offset), lengths[0]);
+    TEST_ASSERT_EQUAL_MEMORY(blob + offset, chunk.data, chunk.length);
+  }
+
+  // An older id than the master's is not served
+  Request stale = {29, 0};
+  deliver(SLAVE_MAC, LINK_FRAME_SCRIPT_REQUEST, &stale, sizeof(stale));
+  TEST_ASSERT_EQUAL_INT(0, takeSent(LINK_FRAME_SCRIPT_CHUNK, SLAVE_MAC, payloads, lengths, 4));
+
+  Request done = {30, SCRIPT_SIZE};
+  deliver(SLAVE_MAC, LINK_FRAME_SCRIPT_REQUEST, &done, sizeof(done));
+  advanceMs(PHASE_SCRIPT_OFFER_INTERVAL_MS * 2);
+  TEST_ASSERT_EQUAL_INT(0, takeSent(LINK_FRAME_SCRIPT_OFFER, SLAVE_MAC, payloads, lengths, 4));
+  TEST_ASSERT_FALSE(TimerWheel::isPending(TIMER_SCRIPT_OFFER));
+}
+
+int main(int argc, char** argv) {
+  phases = hostAddPartition(PHASE_SCRIPT_PARTITION_TYPE, PHASE_SCRIPT_PARTITION_LABEL,
+                            2 * PhaseScript::slotSize);
+  EventQueue::begin();
+  TimerWheel::begin();
+  EspNowLink::begin();
+  PhaseScript::begin();
+  PhaseScriptTransfer::beginMaster();
+  PhaseScriptTransfer::beginSlave();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_compiled_script_is_the_firmware_layout);
+  RUN_TEST(test_damaged_scripts_fail_validation);
+  RUN_TEST(test_install_validates_only_once_finished);
+  RUN_TEST(test_interrupted_install_is_not_mapped_after_restart);
+  RUN_TEST(test_slave_receives_a_script_chunk_by_chunk);
+  RUN_TEST(test_stalled_transfer_resumes_where_it_stopped);
+  RUN_TEST(test_changed_offer_starts_the_transfer_over);
+  RUN_TEST(test_offer_of_a_script_already_held_is_declined);
+  RUN_TEST(test_script_that_fails_its_crc_is_received_again);
+  RUN_TEST(test_master_serves_its_script_until_the_slave_has_it);
+  return UNITY_END();
+}
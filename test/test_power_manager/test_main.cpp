@@ -0,0 +1,130 @@
+#include <unity.h>
+
+#include "PowerManager.h"
+#include "hardware_config.h"
+
+// Records what the policy asked of the chip
+class MockPowerHal : public PowerHal {
+  public:
+    void setCpuFrequencyMhz(uint32_t mhz) override {
+      frequencyMhz = mhz;
+      frequencyChanges++;
+    }
+
+    void setAutoLightSleep(bool enabled) override {
+      lightSleep = enabled;
+    }
+
+    uint32_t frequencyMhz = ACTIVE_CPU_FREQ_MHZ;
+    int frequencyChanges = 0;
+    bool lightSleep = false;
+};
+
+static MockPowerHal* hal;
+static PowerManager* power;
+
+static void idle() {
+  power->request(POWER_MODE_IDLE);
+  power->apply();
+}
+
+void setUp(void) {
+  hal = new MockPowerHal();
+  power = new PowerManager(*hal);
+}
+
+void tearDown(void) {
+  delete power;
+  delete hal;
+}
+
+void test_starts_active_without_touching_the_clock(void) {
+  TEST_ASSERT_EQUAL(POWER_MODE_ACTIVE, power->getMode());
+  TEST_ASSERT_FALSE(power->apply());
+  TEST_ASSERT_EQUAL(0, hal->frequencyChanges);
+}
+
+void test_requested_mode_takes_effect_on_apply(void) {
+  power->request(POWER_MODE_IDLE);
+  TEST_ASSERT_EQUAL(POWER_MODE_ACTIVE, power->getMode());
+  TEST_ASSERT_EQUAL(0, hal->frequencyChanges);
+
+  TEST_ASSERT_TRUE(power->apply());
+  TEST_ASSERT_EQUAL(POWER_MODE_IDLE, power->getMode());
+  TEST_ASSERT_EQUAL(IDLE_CPU_FREQ_MHZ, hal->frequencyMhz);
+
+  TEST_ASSERT_FALSE(power->apply());
+  TEST_ASSERT_EQUAL(1, hal->frequencyChanges);
+}
+
+void test_boost_raises_the_clock_at_once(void) {
+  idle();
+  power->boost();
+  TEST_ASSERT_EQUAL(POWER_MODE_ACTIVE, power->getMode());
+  TEST_ASSERT_EQUAL(ACTIVE_CPU_FREQ_MHZ, hal->frequencyMhz);
+
+  power->boost();
+  TEST_ASSERT_EQUAL(2, hal->frequencyChanges);
+}
+
+// A wake into a state that idles again draws at full clock, then drops back
+void test_apply_after_boost_settles_on_the_requested_mode(void) {
+  idle();
+  power->boost();
+  TEST_ASSERT_TRUE(power->apply());
+  TEST_ASSERT_EQUAL(POWER_MODE_IDLE, power->getMode());
+  TEST_ASSERT_EQUAL(IDLE_CPU_FREQ_MHZ, hal->frequencyMhz);
+}
+
+void test_wake_while_active_is_not_measured(void) {
+  power->markWake(1000);
+  TEST_ASSERT_FALSE(power->markRendered(5000));
+  TEST_ASSERT_EQUAL_UINT32(0, power->getWakeCount());
+}
+
+void test_latency_runs_from_the_wake_to_the_render(void) {
+  idle();
+  power->markWake(1000);
+  power->boost();
+  TEST_ASSERT_TRUE(power->markRendered(4000));
+  TEST_ASSERT_EQUAL_INT64(3000, power->getLastLatencyUs());
+  TEST_ASSERT_EQUAL_UINT32(1, power->getWakeCount());
+}
+
+// Later renders belong to no wake until the device idles and wakes again
+void test_each_wake_is_measured_once(void) {
+  idle();
+  power->markWake(1000);
+  power->markRendered(2000);
+  TEST_ASSERT_FALSE(power->markRendered(9000));
+
+  power->apply();
+  power->markWake(10000);
+  power->markRendered(16000);
+  TEST_ASSERT_EQUAL_UINT32(2, power->getWakeCount());
+  TEST_ASSERT_EQUAL_INT64(6000, power->getLastLatencyUs());
+  TEST_ASSERT_EQUAL_INT64(6000, power->getMaxLatencyUs());
+  TEST_ASSERT_EQUAL_INT64(3500, power->getAverageLatencyUs());
+}
+
+// A second wake before anything was drawn restarts the measurement
+void test_later_wake_replaces_an_earlier_one(void) {
+  idle();
+  power->markWake(1000);
+  power->markWake(7000);
+  power->markRendered(8000);
+  TEST_ASSERT_EQUAL_INT64(1000, power->getLastLatencyUs());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_starts_active_without_touching_the_clock);
+  RUN_TEST(test_requested_mode_takes_effect_on_apply);
+  RUN_TEST(test_boost_raises_the_clock_at_once);
+  RUN_TEST(test_apply_after_boost_settles_on_the_requested_mode);
+  RUN_TEST(test_wake_while_active_is_not_measured);
+  RUN_TEST(test_latency_runs_from_the_wake_to_the_render);
+  RUN_TEST(test_each_wake_is_measured_once);
+  RUN_TEST(test_later_wake_replaces_an_earlier_one);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+
+#include "StillnessDetector.h"
+
+static const int WINDOW = STILLNESS_WINDOW_SAMPLES;
+static const float LEVEL[3] = {0.0f, 0.0f, 1.0f};
+
+static StillnessDetector detector;
+
+// Gyro noise well inside the stillness limits, alternating so its mean over a window is the rate
+static void addRest(int samples, float rateZ) {
+  for (int i = 0; i < samples; i++) {
+    float noise = (i % 2 == 0) ? 0.05f : -0.05f;
+    float gyro[3] = {noise, -noise, rateZ + noise};
+    detector.addSample(gyro, LEVEL);
+  }
+}
+
+static void addMotion(int samples) {
+  for (int i = 0; i < samples; i++) {
+    float gyro[3] = {30.0f, -12.0f, (i % 2 == 0) ? 45.0f : -45.0f};
+    float acc[3] = {0.3f, 0.1f, 0.9f};
+    detector.addSample(gyro, acc);
+  }
+}
+
+void setUp(void) {
+  detector.reset();
+}
+
+void tearDown(void) {
+}
+
+void test_rest_is_still_once_the_window_fills(void) {
+  addRest(WINDOW - 1, 0.0f);
+  TEST_ASSERT_FALSE(detector.isStill());
+  addRest(1, 0.0f);
+  TEST_ASSERT_TRUE(detector.isStill());
+}
+
+// Rest is seen as soon as the last moving sample leaves the window, wherever the motion ended
+void test_window_slides_past_motion(void) {
+  for (int motion = 1; motion <= WINDOW; motion += 7) {
+    detector.reset();
+    addRest(WINDOW, 0.0f);
+    addMotion(motion);
+    TEST_ASSERT_FALSE(detector.isStill());
+
+    addRest(WINDOW - 1, 0.0f);
+    TEST_ASSERT_FALSE(detector.isStill());
+    addRest(1, 0.0f);
+    TEST_ASSERT_TRUE(detector.isStill());
+  }
+}
+
+void test_slow_turn_is_not_still(void) {
+  addRest(4 * WINDOW, STILLNESS_MAX_GYRO_MEAN_DPS * 1.5f);
+  TEST_ASSERT_FALSE(detector.isStill());
+  TEST_ASSERT_EQUAL_INT(0, detector.getRunSamples());
+}
+
+void test_bias_sized_rate_is_still(void) {
+  addRest(WINDOW, STILLNESS_MAX_GYRO_MEAN_DPS * 0.5f);
+  TEST_ASSERT_TRUE(detector.isStill());
+}
+
+void test_tilted_or_shaken_is_not_still(void) {
+  float gyro[3] = {0.0f, 0.0f, 0.0f};
+  float light[3] = {0.0f, 0.0f, 0.9f};
+  for (int i = 0; i < WINDOW; i++) {
+    detector.addSample(gyro, light);
+  }
+  TEST_ASSERT_FALSE(detector.isStill());
+}
+
+void test_run_mean_covers_the_whole_rest(void) {
+  addRest(WINDOW, 0.1f);
+  TEST_ASSERT_EQUAL_INT(WINDOW, detector.getRunSamples());
+  addRest(WINDOW, 0.2f);
+  TEST_ASSERT_EQUAL_INT(2 * WINDOW, detector.getRunSamples());
+
+  float mean[3];
+  detector.getRunMean(mean);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.15f, mean[2]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, mean[0]);
+
+  detector.restartRun();
+  addRest(WINDOW, 0.2f);
+  detector.getRunMean(mean);
+  TEST_ASSERT_EQUAL_INT(WINDOW, detector.getRunSamples());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.2f, mean[2]);
+}
+
+void test_motion_ends_the_run(void) {
+  addRest(2 * WINDOW, 0.0f);
+  addMotion(1);
+  TEST_ASSERT_EQUAL_INT(0, detector.getRunSamples());
+
+  addRest(WINDOW, 0.1f);
+  float mean[3];
+  detector.getRunMean(mean);
+  TEST_ASSERT_EQUAL_INT(WINDOW, detector.getRunSamples());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.1f, mean[2]);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rest_is_still_once_the_window_fills);
+  RUN_TEST(test_window_slides_past_motion);
+  RUN_TEST(test_slow_turn_is_not_still);
+  RUN_TEST(test_bias_sized_rate_is_still);
+  RUN_TEST(test_tilted_or_shaken_is_not_still);
+  RUN_TEST(test_run_mean_covers_the_whole_rest);
+  RUN_TEST(test_motion_ends_the_run);
+  return UNITY_END();
+}
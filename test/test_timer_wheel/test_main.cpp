@@ -0,0 +1,181 @@
+#include <unity.h>
+
+#include "EventQueue.h"
+#include "TimerWheel.h"
+
+// The wheel runs on the virtual clock of the esp_timer stand-in. Most tests call advance()
+// directly; the ticker tests let hostRunTimersUntil() fire the one-shot esp_timer instead.
+
+static const int64_t TICK_US = TIMER_WHEEL_TICK_US;
+
+struct Expiry {
+    TimerId id;
+    int64_t atUs;
+};
+
+// Claims every expiry in the queue, in the order the wheel posted them
+static int collectExpiries(Expiry expiries[], int capacity) {
+  int count = 0;
+  Event event;
+  while (EventQueue::poll(event)) {
+    TimerId id;
+    if (event.type == EVENT_TIMER_EXPIRED && TimerWheel::claimExpiry(event.value, id) &&
+        count < capacity) {
+      expiries[count++] = {id, event.timestampUs};
+    }
+  }
+  return count;
+}
+
+static void advanceTo(int64_t nowUs) {
+  hostSetTimeUs(nowUs);
+  TimerWheel::advance(nowUs);
+}
+
+void setUp(void) {
+  for (int id = 0; id < TIMER_COUNT; id++) {
+    TimerWheel::cancel((TimerId)id);
+  }
+  Event event;
+  while (EventQueue::poll(event)) {
+  }
+  hostSetTimeUs(hostTimeUs() + 12345);  // off the tick grid, and never back in time
+}
+
+void tearDown(void) {
+}
+
+void test_timer_fires_on_its_deadline_and_never_early(void) {
+  static const uint32_t DELAYS_US[] = {
+      0,         1,          999,         1000,         1001,      63 * 1000, 64 * 1000,
+      65 * 1000, 4095 * 1000, 4096 * 1000, 4097 * 1000, 262144 * 1000, 20000000,
+  };
+
+  for (uint32_t delayUs : DELAYS_US) {
+    int64_t startUs = hostTimeUs();
+    int64_t deadlineUs = startUs + delayUs;
+    TimerWheel::schedule(TIMER_PHASE_TIMEOUT, delayUs);
+
+    Expiry expiries[TIMER_COUNT];
+    if (delayUs > 0) {
+      advanceTo(deadlineUs - 1);
+      TEST_ASSERT_EQUAL_INT_MESSAGE(0, collectExpiries(expiries, TIMER_COUNT), "fired early");
+    }
+    advanceTo(deadlineUs + TICK_US);
+    TEST_ASSERT_EQUAL_INT(1, collectExpiries(expiries, TIMER_COUNT));
+    TEST_ASSERT_EQUAL_INT(TIMER_PHASE_TIMEOUT, expiries[0].id);
+    TEST_ASSERT_FALSE(TimerWheel::isPending(TIMER_PHASE_TIMEOUT));
+  }
+}
+
+void test_cancelled_timer_never_fires(void) {
+  TimerWheel::schedule(TIMER_COUNTDOWN, 5000);
+  TimerWheel::cancel(TIMER_COUNTDOWN);
+  TEST_ASSERT_FALSE(TimerWheel::isPending(TIMER_COUNTDOWN));
+
+  advanceTo(hostTimeUs() + 10000);
+  Expiry expiries[TIMER_COUNT];
+  TEST_ASSERT_EQUAL_INT(0, collectExpiries(expiries, TIMER_COUNT));
+}
+
+void test_rescheduling_moves_the_deadline(void) {
+  int64_t startUs = hostTimeUs();
+  TimerWheel::schedule(TIMER_MELODY, 10000);
+  TimerWheel::schedule(TIMER_MELODY, 50000);
+
+  Expiry expiries[TIMER_COUNT];
+  advanceTo(startUs + 49000);
+  TEST_ASSERT_EQUAL_INT(0, collectExpiries(expiries, TIMER_COUNT));
+  advanceTo(startUs + 51000);
+  TEST_ASSERT_EQUAL_INT(1, collectExpiries(expiries, TIMER_COUNT));
+  TEST_ASSERT_EQUAL_INT(TIMER_MELODY, expiries[0].id);
+}
+
+// An expiry already queued when its timer is scheduled again must not be acted on
+void test_stale_expiry_is_not_claimed(void) {
+  TimerWheel::schedule(TIMER_LINK_PROBE, 2000);
+  advanceTo(hostTimeUs() + 3000);
+  TimerWheel::schedule(TIMER_LINK_PROBE, 2000);
+
+  Event event;
+  TEST_ASSERT_TRUE(EventQueue::poll(event));
+  TEST_ASSERT_EQUAL_INT(EVENT_TIMER_EXPIRED, event.type);
+  TimerId id;
+  TEST_ASSERT_FALSE(TimerWheel::claimExpiry(event.value, id));
+  TEST_ASSERT_TRUE(TimerWheel::isPending(TIMER_LINK_PROBE));
+}
+
+void test_timers_expire_in_deadline_order(void) {
+  static const struct {
+      TimerId id;
+      uint32_t delayUs;
+  } SCHEDULE[] = {
+      {TIMER_PHASE_TIMEOUT, 300000},   {TIMER_COUNTDOWN, 1000},
+      {TIMER_LED_ANIMATION, 70000},    {TIMER_MELODY, 5000000},
+      {TIMER_ORIENTATION_STREAM, 64000}, {TIMER_PLAYER_STATUS, 4500},
+  };
+  static const int COUNT = sizeof(SCHEDULE) / sizeof(SCHEDULE[0]);
+
+  int64_t startUs = hostTimeUs();
+  for (const auto& entry : SCHEDULE) {
+    TimerWheel::schedule(entry.id, entry.delayUs);
+  }
+
+  Expiry expiries[TIMER_COUNT];
+  int count = 0;
+  for (int64_t nowUs = startUs; nowUs <= startUs + 5100000; nowUs += 700) {
+    advanceTo(nowUs);
+    count += collectExpiries(expiries + count, TIMER_COUNT - count);
+  }
+
+  TEST_ASSERT_EQUAL_INT(COUNT, count);
+  for (int i = 0; i < count; i++) {
+    uint32_t delayUs = 0;
+    for (const auto& entry : SCHEDULE) {
+      if (entry.id == expiries[i].id) {
+        delayUs = entry.delayUs;
+      }
+    }
+    TEST_ASSERT_TRUE(expiries[i].atUs >= startUs + delayUs);
+    TEST_ASSERT_TRUE(expiries[i].atUs < startUs + delayUs + TICK_US + 700);
+    if (i > 0) {
+      TEST_ASSERT_TRUE(expiries[i].atUs >= expiries[i - 1].atUs);
+    }
+  }
+}
+
+// Driven by its own esp_timer, the wheel still fires on time and only wakes every 64 ticks
+// while the deadline is far off
+void test_ticker_sleeps_until_a_deadline_is_near(void) {
+  esp_timer* ticker = hostTimers().back();
+  uint32_t firedBefore = ticker->fired;
+  int64_t startUs = hostTimeUs();
+  int64_t deadlineUs = startUs + 10000000;
+  TimerWheel::schedule(TIMER_SCRIPT_OFFER, 10000000);
+
+  Expiry expiries[TIMER_COUNT];
+  hostRunTimersUntil(deadlineUs - 1);
+  TEST_ASSERT_EQUAL_INT(0, collectExpiries(expiries, TIMER_COUNT));
+  hostRunTimersUntil(deadlineUs + TICK_US);
+  TEST_ASSERT_EQUAL_INT(1, collectExpiries(expiries, TIMER_COUNT));
+  TEST_ASSERT_TRUE(expiries[0].atUs >= deadlineUs);
+  TEST_ASSERT_TRUE(expiries[0].atUs <= deadlineUs + TICK_US);
+
+  uint32_t wakeups = ticker->fired - firedBefore;
+  TEST_ASSERT_TRUE(wakeups <= 10000000 / (64 * TICK_US) + 2);
+  TEST_ASSERT_FALSE(ticker->armed);
+}
+
+int main(int argc, char** argv) {
+  EventQueue::begin();
+  TimerWheel::begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_timer_fires_on_its_deadline_and_never_early);
+  RUN_TEST(test_cancelled_timer_never_fires);
+  RUN_TEST(test_rescheduling_moves_the_deadline);
+  RUN_TEST(test_stale_expiry_is_not_claimed);
+  RUN_TEST(test_timers_expire_in_deadline_order);
+  RUN_TEST(test_ticker_sleeps_until_a_deadline_is_near);
+  return UNITY_END();
+}
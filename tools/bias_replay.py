@@ -0,0 +1,376 @@
+#!/usr/bin/env python3
+"""Replays recorded warm-up traces through the gyro bias strategies and compares what is left.
+
+Record a session from a cold start on a device built with TRACE_RECORDER_ENABLED, dump it with
+'d' and run:
+
+    python tools/bias_replay.py warmup.txt
+    python tools/bias_replay.py warmup1.txt warmup2.txt --warm
+
+IMU records carry raw rates (offsets added back) and the die temperature is recorded as it
+moves, so each strategy sees the sensor exactly as the firmware did:
+
+    fixed  the offsets from the first still window, as a boot calibration leaves them
+    zupt   the firmware before the bias model: half of each still window's mean folded in
+    model  GyroBiasModel, seeded from the first still window and learning from the rest, except
+           from windows too far from that calibration for the temperature to explain
+
+Traces are replayed in order, and the model carries over from one to the next as it does across
+boots. With --warm, the model first learns from every trace, and only then is scored.
+
+Still windows are the firmware's. StillnessDetector decides on every sample over the last
+STILLNESS_WINDOW_SAMPLES, and each GYRO_BIAS_MIN_STILL_MS of rest, counted from the last moving
+sample, is one window. Each strategy runs its own detector on the rates with its own offsets
+applied, mean check included, and learns only from the windows that detector finds: a slow turn
+reads more than STILLNESS_MAX_GYRO_MEAN_DPS and is not learned from. The learned column counts
+those windows.
+
+Strategies are scored on the same windows, found on the noise and accelerometer checks alone,
+since a strategy whose offsets have fallen behind fails the mean check on the very rests where it
+does worst. A slow turn that holds steady enough is scored as rest as well. The residual of a
+window is its mean rate with the strategy's offsets applied, before that window is learned from.
+A residual over CALIBRATION_MAX_GYRO_BIAS_DPS on any axis is what would call for a
+recalibration.
+
+The z deg/min column is the yaw drift left at rest: what fixed leaves is the drift without
+tracking, and what model leaves is the drift with it.
+
+Zupt is scored at its best on back-to-back still windows, having just been corrected by the one
+before. The windows that follow at least --motion-s of motion are scored on their own as well:
+they show what was applied while the device moved and the temperature went on changing, which is
+where the model is meant to help.
+"""
+
+import argparse
+import collections
+import math
+import sys
+
+from trace_decode import HEADER, decode_page, read_pages
+
+# hardware_config.h
+STILLNESS_WINDOW_SAMPLES = 64
+STILLNESS_MAX_GYRO_STDDEV_DPS = 0.3
+STILLNESS_MAX_GYRO_MEAN_DPS = 0.3
+STILLNESS_MAX_ACCEL_STDDEV_G = 0.01
+STILLNESS_MAX_ACCEL_ERROR_G = 0.05
+CALIBRATION_MAX_GYRO_BIAS_DPS = 0.5
+GYRO_BIAS_MIN_STILL_MS = 3000
+GYRO_BIAS_MAX_DEVIATION_DPS = 0.5
+GYRO_BIAS_TEMPCO_DPS_PER_C = 0.05
+ZUPT_GAIN = 0.5  # the tracking gain the firmware used before the model
+BIAS_MODEL_MIN_C = 10.0
+BIAS_MODEL_STEP_C = 4.0
+BIAS_MODEL_NODES = 12
+BIAS_MODEL_MAX_WEIGHT = 16
+BIAS_MODEL_CALIBRATION_WEIGHT = 8
+
+
+class GyroBiasModel:
+    """GyroBiasModel.cpp, step for step."""
+
+    def __init__(self):
+        self.learned = [[0.0] * 3 for _ in range(BIAS_MODEL_NODES)]
+        self.weight = [0] * BIAS_MODEL_NODES
+        self.base = [[0.0] * 3 for _ in range(BIAS_MODEL_NODES)]
+
+    @staticmethod
+    def nearest_node(temperature):
+        node = int(math.floor((temperature - BIAS_MODEL_MIN_C) / BIAS_MODEL_STEP_C + 0.5))
+        return min(max(node, 0), BIAS_MODEL_NODES - 1)
+
+    def empty(self):
+        return not any(self.weight)
+
+    def calibrate(self, temperature, bias):
+        current = self.lookup(temperature)
+        calibrated = self.nearest_node(temperature)
+        for node in range(BIAS_MODEL_NODES):
+            if self.weight[node] or node == calibrated:
+                self.learned[node] = [self.base[node][a] + bias[a] - current[a] for a in range(3)]
+        self.weight[calibrated] = BIAS_MODEL_CALIBRATION_WEIGHT
+        self.rebuild()
+
+    def observe(self, temperature, bias, weight):
+        node = self.nearest_node(temperature)
+        total = min(self.weight[node] + weight, BIAS_MODEL_MAX_WEIGHT)
+        share = min(float(weight) / total, 1.0)
+        for axis in range(3):
+            self.learned[node][axis] += share * (bias[axis] - self.learned[node][axis])
+        self.weight[node] = total
+        self.rebuild()
+
+    def rebuild(self):
+        previous = -1
+        for node in range(BIAS_MODEL_NODES):
+            if not self.weight[node]:
+                continue
+            for fill in range(previous + 1, node + 1):
+                t = 1.0 if previous < 0 else (fill - previous) / float(node - previous)
+                start = self.learned[node] if previous < 0 else self.learned[previous]
+                self.base[fill] = [start[a] + t * (self.learned[node][a] - start[a])
+                                   for a in range(3)]
+            previous = node
+        for fill in range(previous + 1, BIAS_MODEL_NODES if previous >= 0 else 0):
+            self.base[fill] = list(self.learned[previous])
+
+    def lookup(self, temperature):
+        x = (temperature - BIAS_MODEL_MIN_C) / BIAS_MODEL_STEP_C
+        x = min(max(x, 0.0), BIAS_MODEL_NODES - 1)
+        node = int(x)
+        fraction = x - node
+        upper = self.base[min(node + 1, BIAS_MODEL_NODES - 1)]
+        return [self.base[node][a] + fraction * (upper[a] - self.base[node][a]) for a in range(3)]
+
+
+def load_samples(dump):
+    """(timestamp, gyro[3], accel magnitude, temperature) per IMU sample, in time order."""
+    records = []
+    for page in read_pages(dump):
+        result = decode_page(page) if len(page) >= HEADER.size else None
+        if result is not None:
+            records.extend(result[2])
+    records.sort(key=lambda record: record[0])
+
+    samples = []
+    temperature = None
+    for timestamp, kind, values in records:
+        if kind == "temperature":
+            temperature = values[0]
+        elif kind == "imu" and temperature is not None:
+            acc = values[:3]
+            samples.append((timestamp, values[3:], math.sqrt(sum(a * a for a in acc)),
+                            temperature))
+    return samples
+
+
+class StillnessDetector:
+    """StillnessDetector.cpp: a decision on every sample over the last STILLNESS_WINDOW_SAMPLES,
+    from running sums as the firmware keeps them, and the mean rate over the run of rest."""
+
+    def __init__(self, max_gyro_mean=STILLNESS_MAX_GYRO_MEAN_DPS):
+        self.max_gyro_mean = max_gyro_mean
+        self.reset()
+
+    def reset(self):
+        self.window = collections.deque()
+        self.sums = [0.0] * 4
+        self.squares = [0.0] * 4
+        self.still = False
+        self.running = False
+        self.restart_run()
+
+    def restart_run(self):
+        self.run_sum = [0.0] * 3
+        self.run_samples = 0
+
+    def add(self, gyro, acc_magnitude):
+        values = list(gyro) + [acc_magnitude]
+        self.window.append(values)
+        for c in range(4):
+            self.sums[c] += values[c]
+            self.squares[c] += values[c] * values[c]
+        if len(self.window) > STILLNESS_WINDOW_SAMPLES:
+            oldest = self.window.popleft()
+            for c in range(4):
+                self.sums[c] -= oldest[c]
+                self.squares[c] -= oldest[c] * oldest[c]
+
+        self.still = self.evaluate()
+        if not self.still:
+            self.running = False
+            self.restart_run()
+        elif not self.running:
+            self.running = True
+            self.run_samples = STILLNESS_WINDOW_SAMPLES
+            self.run_sum = self.sums[:3]
+        else:
+            self.run_samples += 1
+            self.run_sum = [self.run_sum[a] + gyro[a] for a in range(3)]
+
+    def evaluate(self):
+        n = STILLNESS_WINDOW_SAMPLES
+        if len(self.window) < n:
+            return False
+        means = [total / n for total in self.sums]
+        variances = [max(self.squares[c] / n - means[c] * means[c], 0.0) for c in range(4)]
+        return (variances[3] <= STILLNESS_MAX_ACCEL_STDDEV_G ** 2 and
+                abs(means[3] - 1.0) <= STILLNESS_MAX_ACCEL_ERROR_G and
+                all(variances[a] <= STILLNESS_MAX_GYRO_STDDEV_DPS ** 2 and
+                    abs(means[a]) <= self.max_gyro_mean for a in range(3)))
+
+    def run_mean(self):
+        return [total / self.run_samples for total in self.run_sum]
+
+
+class RestTracker:
+    """trackGyroBias's timing: each GYRO_BIAS_MIN_STILL_MS of rest, counted from the last sample
+    that was not still, ends a window. add() returns the window's mean rate and its length."""
+
+    def __init__(self, detector, timestamp):
+        self.detector = detector
+        self.reset(timestamp)
+
+    def reset(self, timestamp):
+        self.detector.reset()
+        self.moved_us = timestamp
+
+    def add(self, timestamp, gyro, acc_magnitude):
+        self.detector.add(gyro, acc_magnitude)
+        if not self.detector.still:
+            self.moved_us = timestamp
+            return None
+        if timestamp - self.moved_us < GYRO_BIAS_MIN_STILL_MS * 1000:
+            return None
+        self.moved_us = timestamp
+        window = (self.detector.run_mean(), self.detector.run_samples)
+        self.detector.restart_run()
+        return window
+
+
+def rest_windows(samples):
+    """(first, last) sample of each window of rest, found on the noise and accelerometer checks
+    alone. Every strategy is scored on these, whatever its own offsets let it learn from."""
+    if not samples:
+        return []
+    tracker = RestTracker(StillnessDetector(float("inf")), samples[0][0])
+    windows = []
+    for i, (timestamp, gyro, acc_magnitude, _) in enumerate(samples):
+        window = tracker.add(timestamp, gyro, acc_magnitude)
+        if window is not None:
+            windows.append((i - window[1] + 1, i))
+    return windows
+
+
+class Strategy:
+    def __init__(self, name):
+        self.name = name
+        self.offsets = None
+        self.calibration = None  # offsets and temperature of the boot calibration
+        self.model = GyroBiasModel()
+        self.residuals = []
+        self.after_motion = []
+        self.learned = 0
+
+    def offsets_for(self, temperature):
+        if self.name == "model" and not self.model.empty():
+            return self.model.lookup(temperature)
+        return self.offsets
+
+    def replay(self, samples, windows, score, motion_us):
+        """One boot: the first window of rest is the boot calibration, and from there on the
+        strategy's own detector runs on the rates with its offsets applied, as the firmware's does.
+        A rest those offsets leave reading more than STILLNESS_MAX_GYRO_MEAN_DPS is not learned
+        from."""
+        self.offsets = None  # the model persists; the calibration does not
+        tracker = RestTracker(StillnessDetector(), samples[0][0] if samples else 0)
+        applied = []
+        next_window = 0
+        for i, (timestamp, raw, acc_magnitude, temperature) in enumerate(samples):
+            offsets = self.offsets_for(temperature) if self.offsets is not None else [0.0] * 3
+            applied.append(offsets)
+            if self.offsets is not None:
+                learnt = tracker.add(timestamp, [raw[a] - offsets[a] for a in range(3)],
+                                     acc_magnitude)
+                if learnt is not None:
+                    self.learn(learnt[0], offsets, temperature)
+
+            if next_window < len(windows) and windows[next_window][1] == i:
+                first, last = windows[next_window]
+                window = samples[first:last + 1]
+                if self.offsets is None:
+                    self.calibrate(window)
+                    tracker.reset(timestamp)
+                elif score:
+                    after_motion = samples[first][0] - samples[windows[next_window - 1][1]][0]
+                    self.score(window, applied[first:last + 1], after_motion >= motion_us)
+                next_window += 1
+
+    def calibrate(self, window):
+        raw = [sum(s[1][axis] for s in window) / len(window) for axis in range(3)]
+        temperature = window[-1][3]
+        self.offsets = raw
+        self.calibration = (raw, temperature)
+        if self.name == "model":
+            self.model.calibrate(temperature, raw)
+
+    # Offsets are applied per sample, so the model's follow the temperature through the window
+    def score(self, window, applied, after_motion):
+        residual = [sum(s[1][axis] - a[axis] for s, a in zip(window, applied)) / len(window)
+                    for axis in range(3)]
+        self.residuals.append(residual)
+        if after_motion:
+            self.after_motion.append(residual)
+
+    def learn(self, residual, offsets, temperature):
+        if self.name == "zupt":
+            self.offsets = [self.offsets[a] + ZUPT_GAIN * residual[a] for a in range(3)]
+            self.learned += 1
+        elif self.name == "model":
+            bias = [offsets[a] + residual[a] for a in range(3)]
+            if self.plausible(bias, temperature):
+                self.model.observe(temperature, bias, 1)
+                self.learned += 1
+
+    def plausible(self, bias, temperature):
+        offsets, calibrated_c = self.calibration
+        limit = (GYRO_BIAS_MAX_DEVIATION_DPS +
+                 GYRO_BIAS_TEMPCO_DPS_PER_C * abs(temperature - calibrated_c))
+        return all(abs(bias[a] - offsets[a]) <= limit for a in range(3))
+
+
+def replay(traces, strategies, score, motion_us):
+    for samples in traces:
+        windows = rest_windows(samples)
+        for strategy in strategies:
+            strategy.replay(samples, windows, score, motion_us)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dumps", type=argparse.FileType("r"), nargs="+")
+    parser.add_argument("--warm", action="store_true", help="score with a model learned first")
+    parser.add_argument("--motion-s", type=float, default=10.0,
+                        help="motion before a still window for it to count as after motion")
+    args = parser.parse_args()
+
+    traces = [load_samples(dump) for dump in args.dumps]
+    for dump, samples in zip(args.dumps, traces):
+        if not samples:
+            sys.exit("%s: no IMU samples with a temperature; was it recorded with this firmware?"
+                     % dump.name)
+        print("%s: %d samples, %.1f to %.1f C" % (dump.name, len(samples),
+                                                  min(s[3] for s in samples),
+                                                  max(s[3] for s in samples)))
+
+    strategies = [Strategy("fixed"), Strategy("zupt"), Strategy("model")]
+    motion_us = int(args.motion_s * 1e6)
+    if args.warm:
+        replay(traces, strategies, False, motion_us)
+        for strategy in strategies:
+            strategy.learned = 0
+    replay(traces, strategies, True, motion_us)
+    if not strategies[0].residuals:
+        sys.exit("fewer than two still windows; nothing to score")
+
+    for title, name in (("all still windows", "residuals"), ("after motion", "after_motion")):
+        count = len(getattr(strategies[0], name))
+        print()
+        print("%s: %d" % (title, count))
+        if not count:
+            continue
+        print("%-6s %8s %8s %8s %12s %8s %8s" % ("", "|x| dps", "|y| dps", "|z| dps",
+                                                 "z deg/min", "recal", "learned"))
+        for strategy in strategies:
+            residuals = getattr(strategy, name)
+            mean_abs = [sum(abs(r[axis]) for r in residuals) / count for axis in range(3)]
+            over = sum(1 for r in residuals
+                       if max(abs(v) for v in r) > CALIBRATION_MAX_GYRO_BIAS_DPS)
+            print("%-6s %8.3f %8.3f %8.3f %12.1f %7.1f%% %8d" % (strategy.name, *mean_abs,
+                                                                 mean_abs[2] * 60.0,
+                                                                 100.0 * over / count,
+                                                                 strategy.learned))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Reports flash and RAM use per subsystem from the linker map.
+
+Every build writes firmware.map next to firmware.elf. After building:
+
+    python tools/footprint.py .pio/build/tm-device-orientation/firmware.map
+    python tools/footprint.py .pio/build/tm-device-orientation-static/firmware.map --top 15
+
+Each source file in src/ is its own subsystem. Libraries are grouped by archive, framework
+components as sdk:<component>. Flash counts everything stored in the image, including the
+initial values of .data and IRAM code; IRAM, data and bss are the RAM regions they occupy.
+
+The IRAM total is checked against --iram-budget (the ESP32's 128 KiB by default), and the
+script exits non-zero when it is over. Compare builds with and without HOT_PATH_IN_IRAM to see
+what the hot path costs.
+"""
+
+import argparse
+import os
+import re
+import sys
+from collections import defaultdict
+
+# Output sections by the regions they take up
+FLASH = "flash"
+IRAM = "iram"
+DATA = "data"
+BSS = "bss"
+
+REGIONS = [
+    (re.compile(r"^\.iram0\."), (FLASH, IRAM)),
+    (re.compile(r"^\.dram0\.data$"), (FLASH, DATA)),
+    (re.compile(r"^\.dram0\.bss$|^\.noinit$"), (BSS,)),
+    (re.compile(r"^\.rtc\.(text|data|force_fast|force_slow)"), (FLASH,)),
+    (re.compile(r"^\.flash\."), (FLASH,)),
+]
+
+ENTRY = re.compile(r"^\s+(\S+)?\s*0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+ARCHIVE = re.compile(r"([^/\\]+)\.a\(([^)]+)\)$")
+
+
+def regions_for(output_section):
+    for pattern, regions in REGIONS:
+        if pattern.search(output_section):
+            return regions
+    return ()
+
+
+def subsystem_for(path):
+    path = path.strip()
+    archive = ARCHIVE.search(path)
+    if archive:
+        name = archive.group(1)
+        name = name[3:] if name.startswith("lib") else name
+        if "framework-arduinoespressif32" in path and "FrameworkArduino" not in name:
+            return "sdk:" + name
+        return "arduino" if name == "FrameworkArduino" else name
+    normalized = path.replace("\\", "/")
+    if "/src/" in normalized:
+        base = os.path.basename(normalized)
+        return os.path.splitext(os.path.splitext(base)[0])[0]  # Foo.cpp.o -> Foo
+    return os.path.basename(normalized)
+
+
+def parse(lines):
+    totals = defaultdict(lambda: defaultdict(int))
+    in_map = False
+    output_section = ""
+    pending_input = None
+
+    for line in lines:
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if line.startswith("."):
+            output_section = line.split()[0]
+            continue
+
+        entry = ENTRY.match(line)
+        if entry is None:
+            stripped = line.strip()
+            # Long input section names sit on a line of their own, followed by the rest
+            pending_input = stripped if stripped.startswith(".") and " " not in stripped else None
+            continue
+
+        size = int(entry.group(3), 16)
+        address = int(entry.group(2), 16)
+        source = entry.group(4)
+        if entry.group(1) is None and pending_input is None:
+            continue  # a symbol or an assignment, not an input section
+        pending_input = None
+        if size == 0 or address == 0 or source.startswith("*fill*"):
+            continue
+
+        for region in regions_for(output_section):
+            totals[subsystem_for(source)][region] += size
+
+    return totals
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", type=argparse.FileType("r"))
+    parser.add_argument("--top", type=int, default=0, help="only the N largest by RAM")
+    parser.add_argument("--iram-budget", type=int, default=128 * 1024, help="bytes of IRAM code")
+    args = parser.parse_args()
+
+    totals = parse(args.map)
+    if not totals:
+        sys.exit("no input sections found; is this a GNU ld map file?")
+
+    def ram(usage):
+        return usage[IRAM] + usage[DATA] + usage[BSS]
+
+    rows = sorted(totals.items(), key=lambda item: (ram(item[1]), item[1][FLASH]), reverse=True)
+    if args.top:
+        rows = rows[: args.top]
+
+    print("%-28s %9s %9s %9s %9s %9s" % ("subsystem", "flash", "iram", "data", "bss", "ram"))
+    for name, usage in rows:
+        print("%-28s %9d %9d %9d %9d %9d" % (name[:28], usage[FLASH], usage[IRAM], usage[DATA],
+                                             usage[BSS], ram(usage)))
+
+    total = defaultdict(int)
+    for usage in totals.values():
+        for region, size in usage.items():
+            total[region] += size
+    print("%-28s %9d %9d %9d %9d %9d" % ("total", total[FLASH], total[IRAM], total[DATA],
+                                         total[BSS], ram(total)))
+
+    print()
+    print("IRAM: %d of %d bytes (%.1f%%), %d left" % (total[IRAM], args.iram_budget,
+                                                     100.0 * total[IRAM] / args.iram_budget,
+                                                     args.iram_budget - total[IRAM]))
+    if total[IRAM] > args.iram_budget:
+        sys.exit("IRAM over budget")
+
+
+if __name__ == "__main__":
+    main()
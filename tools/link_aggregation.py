@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Replays the link messages in a session trace with and without bundling.
+
+Record a session on a device built with TRACE_RECORDER_ENABLED, dump it with 'd' and run:
+
+    python tools/link_aggregation.py dump.txt
+    python tools/link_aggregation.py dump.txt --window-us 2000 --window-us 10000
+
+Every message EspNowLink was handed is in the trace, before bundling. The replay follows the
+firmware: messages that can wait are held per peer until the flush window runs out, a message
+sent at once takes what is held for its peer along with it, and a bundle is sent early when the
+next message does not fit. Airtime is estimated for ESP-NOW's default 1 Mbps rate with a long
+preamble, counting the ACK, SIFS, DIFS and the mean initial backoff, so the numbers are for
+comparison rather than absolute.
+"""
+
+import argparse
+import sys
+
+from trace_decode import HEADER, decode_page, read_pages
+
+LINK_HEADER = 2  # magic, type
+BUNDLE_OVERHEAD = 1 + 4  # version, CRC-32
+MESSAGE_HEADER = 2  # type, length
+BUNDLE_CAPACITY = 250 - LINK_HEADER - BUNDLE_OVERHEAD
+
+PREAMBLE_US = 192
+MAC_OVERHEAD_BYTES = 24 + 8 + 7 + 4  # header, action category and OUI, vendor element, FCS
+ACK_US = PREAMBLE_US + 14 * 8
+SIFS_US = 10
+DIFS_US = 50
+BACKOFF_US = 15 * 20 / 2
+US_PER_BYTE = 8
+
+
+def airtime_us(payload_bytes):
+    return (PREAMBLE_US + (MAC_OVERHEAD_BYTES + payload_bytes) * US_PER_BYTE + SIFS_US + ACK_US +
+            DIFS_US + BACKOFF_US)
+
+
+def frame_bytes(lengths):
+    if len(lengths) == 1:
+        return LINK_HEADER + lengths[0]
+    return LINK_HEADER + BUNDLE_OVERHEAD + sum(MESSAGE_HEADER + length for length in lengths)
+
+
+def replay(messages, window_us):
+    """Returns the frames sent, each as the list of its message lengths."""
+    frames = []
+    outboxes = {}
+    flush_at = None
+
+    def take(peer):
+        held = outboxes.pop(peer, [])
+        if held:
+            frames.append(held)
+
+    for timestamp, peer, length, deferrable in messages:
+        if flush_at is not None and timestamp >= flush_at:
+            for held_peer in list(outboxes):
+                take(held_peer)
+            flush_at = None
+
+        held = outboxes.setdefault(peer, [])
+        if sum(MESSAGE_HEADER + size for size in held) + MESSAGE_HEADER + length > BUNDLE_CAPACITY:
+            take(peer)
+            held = outboxes.setdefault(peer, [])
+        held.append(length)
+
+        if deferrable and window_us > 0:
+            if flush_at is None:
+                flush_at = timestamp + window_us
+        else:
+            take(peer)
+
+    for peer in list(outboxes):
+        take(peer)
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", type=argparse.FileType("r"))
+    parser.add_argument("--window-us", type=int, action="append",
+                        help="flush window to try (LINK_AGGREGATION_WINDOW_US); repeatable")
+    args = parser.parse_args()
+
+    messages = []
+    for page in read_pages(args.dump):
+        result = decode_page(page) if len(page) >= HEADER.size else None
+        if result is None:
+            continue
+        for timestamp, kind, values in result[2]:
+            if kind == "link":
+                peer, _, length, deferrable = values
+                messages.append((timestamp, peer, length, bool(deferrable)))
+    if not messages:
+        sys.exit("no link messages in the trace; was it recorded with this firmware?")
+    messages.sort()
+
+    baseline = replay(messages, 0)
+    base_airtime = sum(airtime_us(frame_bytes(frame)) for frame in baseline)
+    span_s = (messages[-1][0] - messages[0][0]) / 1e6
+    print("%d messages over %.1f s, %d of them may wait" %
+          (len(messages), span_s, sum(1 for message in messages if message[3])))
+    print()
+    print("%10s %8s %8s %12s %8s" % ("window us", "frames", "saved", "airtime us", "saved"))
+    print("%10s %8d %8s %12d %8s" % ("off", len(baseline), "-", base_airtime, "-"))
+
+    for window_us in args.window_us or [1000, 5000, 10000, 20000]:
+        frames = replay(messages, window_us)
+        airtime = sum(airtime_us(frame_bytes(frame)) for frame in frames)
+        print("%10d %8d %7.1f%% %12d %7.1f%%" %
+              (window_us, len(frames), 100.0 * (len(baseline) - len(frames)) / len(baseline),
+               airtime, 100.0 * (base_airtime - airtime) / base_airtime))
+
+
+if __name__ == "__main__":
+    main()
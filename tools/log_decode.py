@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Decodes binary log frames from a device built with LOG_BINARY_OUTPUT.
+
+Capture the raw serial output to a file (for example with `pio device monitor` logging, or
+`cat /dev/ttyUSB0 > capture.bin`), then run it against the firmware that produced it:
+
+    python tools/log_decode.py .pio/build/tm-device-orientation/firmware.elf capture.bin
+
+Frames carry the address of their format string rather than the text, so the ELF must match the
+firmware exactly. Anything between frames (boot messages, direct prints) is passed through.
+Needs pyelftools (`pip install pyelftools`).
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+MAGIC = b"\xa5\x5a"
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+
+ARG_INT, ARG_UINT, ARG_INT64, ARG_UINT64, ARG_DOUBLE, ARG_STRING = range(6)
+UNPACK = {
+    ARG_INT: "<q",
+    ARG_UINT: "<Q",
+    ARG_INT64: "<q",
+    ARG_UINT64: "<Q",
+    ARG_DOUBLE: "<d",
+}
+
+SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXeEfFgGcsp%])")
+
+
+class FormatStrings:
+    def __init__(self, elf_file):
+        elf = ELFFile(elf_file)
+        self.sections = [(s["sh_addr"], s.data()) for s in elf.iter_sections()
+                         if s["sh_flags"] & 0x2 and s["sh_type"] == "SHT_PROGBITS"]
+        self.cache = {}
+
+    def lookup(self, address):
+        if address not in self.cache:
+            text = None
+            for start, data in self.sections:
+                if start <= address < start + len(data):
+                    end = data.index(b"\0", address - start)
+                    text = data[address - start:end].decode("utf-8", "replace")
+                    break
+            self.cache[address] = text
+        return self.cache[address]
+
+
+def to_python(format_string):
+    def convert(match):
+        flags, _, conversion = match.groups()
+        if conversion == "%":
+            return "%%"
+        if conversion in "iu":
+            conversion = "d"
+        elif conversion == "p":
+            conversion = "x"
+        return "%" + flags + conversion
+
+    return SPEC.sub(convert, format_string)
+
+
+def parse_frame(data, pos):
+    """Returns (level, timestamp, address, args, next position), or None if incomplete."""
+    if pos + 13 > len(data):
+        return None
+    level, _, count = data[pos + 2], data[pos + 3], data[pos + 4]
+    address, timestamp = struct.unpack_from("<II", data, pos + 5)
+    pos += 13
+
+    args = []
+    for _ in range(count):
+        if pos >= len(data):
+            return None
+        kind = data[pos]
+        pos += 1
+        if kind == ARG_STRING:
+            if pos >= len(data):
+                return None
+            size = data[pos]
+            args.append(data[pos + 1:pos + 1 + size].decode("utf-8", "replace"))
+            pos += 1 + size
+        elif kind in UNPACK:
+            if pos + 8 > len(data):
+                return None
+            value = struct.unpack_from(UNPACK[kind], data, pos)[0]
+            if kind in (ARG_INT, ARG_UINT):
+                value &= 0xFFFFFFFF
+                if kind == ARG_INT and value >= 0x80000000:
+                    value -= 1 << 32
+            args.append(value)
+            pos += 8
+        else:
+            return None
+    return level, timestamp, address, args, pos
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", type=argparse.FileType("rb"))
+    parser.add_argument("capture", type=argparse.FileType("rb"))
+    args = parser.parse_args()
+
+    strings = FormatStrings(args.elf)
+    data = args.capture.read()
+    out = sys.stdout
+
+    pos = 0
+    while pos < len(data):
+        start = data.find(MAGIC, pos)
+        if start < 0:
+            out.write(data[pos:].decode("utf-8", "replace"))
+            break
+        out.write(data[pos:start].decode("utf-8", "replace"))
+
+        frame = parse_frame(data, start)
+        if frame is None:
+            out.write(data[start:start + 2].decode("utf-8", "replace"))
+            pos = start + 2
+            continue
+
+        level, timestamp, address, values, pos = frame
+        format_string = strings.lookup(address)
+        if format_string is None:
+            text = "<unknown format 0x%08x> %r" % (address, values)
+        else:
+            try:
+                text = to_python(format_string) % tuple(values)
+            except (TypeError, ValueError):
+                text = "%s %r" % (format_string, values)
+        out.write("%10.6f %s %s\n" % (timestamp / 1e6, LEVELS.get(level, "?"), text))
+
+
+if __name__ == "__main__":
+    main()
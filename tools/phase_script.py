@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Compiles phase scripts into the blobs the firmware maps from its "phases" partition.
+
+A script is a text file, one statement per line, # starting a comment:
+
+    script 4                         # revision; must be higher than the one on the device
+    phase cone 0 0 10 2              # shape roll pitch yaw tolerance, untimed
+    phase box 0 0 15 3 20            # ... with a 20 second limit
+    phase yaw-free 30 0 0 5 30       # yaw is ignored for yaw-free, but still written
+
+Compile it and flash the blob into the first slot of the partition on the master:
+
+    python tools/phase_script.py compile phases.txt phases.bin
+    esptool.py write_flash 0x3D0000 phases.bin
+
+The master hands it on to the slaves over ESP-NOW. `validate` runs the checks the firmware runs
+before it maps a blob, and prints its phases.
+"""
+
+import argparse
+import math
+import struct
+import sys
+import zlib
+
+MAGIC = 0x50485331
+VERSION = 1
+MAX_PHASES = 8  # MAX_PHASES in hardware_config.h
+
+HEADER = struct.Struct("<IHHII")  # magic, version, phaseCount, scriptId, crc
+RECORD = struct.Struct("<B3x4f4ffI")  # shape, roll, pitch, yaw, tolerance, q, threshold, seconds
+
+SHAPES = {"cone": 0, "box": 1, "yaw-free": 2}
+
+
+def wrap180(degrees):
+    while degrees > 180.0:
+        degrees -= 360.0
+    while degrees < -180.0:
+        degrees += 360.0
+    return degrees
+
+
+# OrientationTarget's constexpr constructors: roll about X, pitch about Y, yaw about Z
+def from_euler(roll, pitch, yaw):
+    r, p, y = (math.radians(wrap180(angle)) / 2 for angle in (roll, pitch, yaw))
+    sr, cr = math.sin(r), math.cos(r)
+    sp, cp = math.sin(p), math.cos(p)
+    sy, cy = math.sin(y), math.cos(y)
+    return (cr * cp * cy + sr * sp * sy, sr * cp * cy - cr * sp * sy,
+            cr * sp * cy + sr * cp * sy, cr * cp * sy - sr * sp * cy)
+
+
+def pack_phase(shape, roll, pitch, yaw, tolerance, seconds):
+    if shape == "yaw-free":
+        yaw = 0.0
+    q = from_euler(roll, pitch, yaw)
+    if shape == "cone":
+        threshold = math.cos(math.radians(tolerance) / 2)
+    elif shape == "yaw-free":
+        threshold = math.cos(math.radians(tolerance))
+    else:
+        threshold = 0.0
+    return RECORD.pack(SHAPES[shape], roll, pitch, yaw, tolerance, *q, threshold, seconds)
+
+
+def compile_script(lines):
+    script_id = None
+    records = []
+    for number, line in enumerate(lines, 1):
+        words = line.split("#", 1)[0].split()
+        if not words:
+            continue
+        try:
+            if words[0] == "script" and len(words) == 2:
+                script_id = int(words[1])
+            elif words[0] == "phase" and len(words) in (6, 7) and words[1] in SHAPES:
+                angles = [float(word) for word in words[2:6]]
+                seconds = int(words[6]) if len(words) == 7 else 0
+                records.append(pack_phase(words[1], *angles, seconds))
+            else:
+                raise ValueError("expected 'script <id>' or 'phase <shape> roll pitch yaw "
+                                 "tolerance [seconds]'")
+        except ValueError as error:
+            sys.exit("line %d: %s" % (number, error))
+
+    if script_id is None or not 0 < script_id < 2**32:
+        sys.exit("a script needs a 'script <id>' line with an id above 0")
+    if not 0 < len(records) <= MAX_PHASES:
+        sys.exit("a script holds 1 to %d phases, not %d" % (MAX_PHASES, len(records)))
+
+    body = b"".join(records)
+    return HEADER.pack(MAGIC, VERSION, len(records), script_id, zlib.crc32(body)) + body
+
+
+def validate(blob):
+    if len(blob) < HEADER.size:
+        return "shorter than the header"
+    magic, version, count, script_id, crc = HEADER.unpack_from(blob)
+    if magic != MAGIC or version != VERSION:
+        return "not a version %d phase script" % VERSION
+    if not 0 < count <= MAX_PHASES:
+        return "%d phases; the firmware takes 1 to %d" % (count, MAX_PHASES)
+    body = blob[HEADER.size:HEADER.size + count * RECORD.size]
+    if len(body) != count * RECORD.size:
+        return "truncated"
+    if zlib.crc32(body) != crc:
+        return "CRC mismatch"
+
+    names = {value: name for name, value in SHAPES.items()}
+    print("script %d, %d phases, %d bytes" % (script_id, count, HEADER.size + len(body)))
+    for i in range(count):
+        shape, roll, pitch, yaw, tolerance, *_, seconds = RECORD.unpack_from(body, i * RECORD.size)
+        if shape not in names:
+            return "phase %d has unknown shape %d" % (i + 1, shape)
+        limit = "%d s" % seconds if seconds else "untimed"
+        print("  %d: %-8s roll %g pitch %g yaw %g +/- %g, %s" % (i + 1, names[shape], roll, pitch,
+                                                               yaw, tolerance, limit))
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+    compile_parser = commands.add_parser("compile", help="text script to blob")
+    compile_parser.add_argument("script", type=argparse.FileType("r"))
+    compile_parser.add_argument("output", type=argparse.FileType("wb"))
+    validate_parser = commands.add_parser("validate", help="check a blob as the firmware would")
+    validate_parser.add_argument("blob", type=argparse.FileType("rb"))
+    args = parser.parse_args()
+
+    if args.command == "compile":
+        blob = compile_script(args.script)
+        args.output.write(blob)
+        print("%d bytes" % len(blob))
+    else:
+        error = validate(args.blob.read())
+        if error:
+            sys.exit(error)
+
+
+if __name__ == "__main__":
+    main()
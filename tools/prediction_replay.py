@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Replays recorded traces through OrientationPredictor and scores it against what came next.
+
+Record a session on a device built with TRACE_RECORDER_ENABLED, dump it with 'd' and run:
+
+    python tools/prediction_replay.py session.txt
+    python tools/prediction_replay.py session.txt --latency-ms 10 20 30 40 --max-horizon-ms 40
+
+IMU records carry raw readings (offsets added back). The offsets are taken from the first still
+window, as a boot calibration leaves them, and the angles are rebuilt with MPU6050_light's
+complementary filter, so the replay sees the same orientation samples and gyro rates as
+recordOrientationSample().
+
+From every sample, the orientation is extrapolated the way OrientationPredictor::predict() does
+for each latency given, and compared with the orientation interpolated from the samples either
+side of that time, as scorePrediction() does on the device. The unpredicted column is the error
+of showing the sample as it was. The defaults are the display and radio latency priors. Moving
+samples are those turning faster than --moving-dps; at rest both errors are noise.
+
+When the trace holds state records, only samples taken while a phase was played are scored.
+"""
+
+import argparse
+import math
+import sys
+
+from bias_replay import STILLNESS_WINDOW_SAMPLES, sliding_still
+from trace_decode import HEADER, decode_page, read_pages
+
+# hardware_config.h
+PREDICTION_DISPLAY_LATENCY_PRIOR_US = 30000
+PREDICTION_RADIO_LATENCY_PRIOR_US = 3000
+PREDICTION_RADIO_AIR_TIME_US = 1000
+PREDICTION_MAX_HORIZON_US = 60000
+
+# main.cpp
+STATE_PROCESSING = 3
+STATE_TIMED_PROCESSING = 4
+
+GYRO_COEFFICIENT = 0.98  # MPU6050_light's default, which the firmware keeps
+
+
+def load(dump):
+    """IMU samples as (timestamp, accel[3], gyro[3]) and state changes as (timestamp, state)."""
+    records = []
+    for page in read_pages(dump):
+        result = decode_page(page) if len(page) >= HEADER.size else None
+        if result is not None:
+            records.extend(result[2])
+    records.sort(key=lambda record: record[0])
+
+    samples = [(t, values[:3], values[3:]) for t, kind, values in records if kind == "imu"]
+    states = [(t, values[0]) for t, kind, values in records if kind == "state"]
+    return samples, states
+
+
+def calibrate(samples):
+    """Offsets from the first still window, as calcOffsets() takes them: 1 g is left on z."""
+    stillness = [(t, gyro, math.sqrt(sum(a * a for a in acc)), None) for t, acc, gyro in samples]
+    for i, still in enumerate(sliding_still(stillness)):
+        if still:
+            window = samples[i - STILLNESS_WINDOW_SAMPLES + 1:i + 1]
+            acc = [sum(s[1][axis] for s in window) / len(window) for axis in range(3)]
+            gyro = [sum(s[2][axis] for s in window) / len(window) for axis in range(3)]
+            return [acc[0], acc[1], acc[2] - 1.0], gyro
+    return None
+
+
+def wrap(angle, limit):
+    while angle > limit:
+        angle -= 2 * limit
+    while angle < -limit:
+        angle += 2 * limit
+    return angle
+
+
+def orientations(samples, acc_offsets, gyro_offsets):
+    """(timestamp, x, y, z) and (rate x, y, z) per sample, with main.cpp's axis signs.
+
+    MPU6050::update(), step for step. Its dt comes from millis(), and the first sample seeds the
+    tilt from the accelerometer alone, as begin() does.
+    """
+    angle_x = angle_y = angle_z = 0.0
+    previous_ms = None
+    result = []
+    for t, raw_acc, raw_gyro in samples:
+        ax, ay, az = [raw_acc[a] - acc_offsets[a] for a in range(3)]
+        gx, gy, gz = [raw_gyro[a] - gyro_offsets[a] for a in range(3)]
+
+        sg_z = -1.0 if az < 0 else 1.0
+        acc_x = math.degrees(math.atan2(ay, sg_z * math.sqrt(az * az + ax * ax)))
+        acc_y = -math.degrees(math.atan2(ax, math.sqrt(az * az + ay * ay)))
+
+        now_ms = t // 1000
+        if previous_ms is None:
+            angle_x, angle_y = acc_x, acc_y
+        else:
+            dt = (now_ms - previous_ms) * 1e-3
+            angle_x = wrap(GYRO_COEFFICIENT * (acc_x + wrap(angle_x + gx * dt - acc_x, 180)) +
+                           (1.0 - GYRO_COEFFICIENT) * acc_x, 180)
+            angle_y = wrap(GYRO_COEFFICIENT * (acc_y + wrap(angle_y + sg_z * gy * dt - acc_y, 90)) +
+                           (1.0 - GYRO_COEFFICIENT) * acc_y, 90)
+            angle_z += gz * dt
+        previous_ms = now_ms
+
+        result.append(((t, -angle_x, angle_y, -angle_z), (-gx, gy, -gz)))
+    return result
+
+
+def predict(newest, rates, timestamp, max_horizon_us):
+    """OrientationPredictor::predict()."""
+    horizon = min(max(timestamp - newest[0], 0), max_horizon_us)
+    seconds = horizon / 1e6
+    return (timestamp,) + tuple(newest[1 + a] + rates[a] * seconds for a in range(3))
+
+
+def actual_at(poses, index, timestamp):
+    """The orientation at the timestamp, between the samples either side; None past the end."""
+    while index + 1 < len(poses) and poses[index + 1][0][0] < timestamp:
+        index += 1
+    if index + 1 >= len(poses):
+        return None, index
+    before, after = poses[index][0], poses[index + 1][0]
+    span = after[0] - before[0]
+    t = (timestamp - before[0]) / span if span > 0 else 1.0
+    return (timestamp,) + tuple(before[a] + (after[a] - before[a]) * t for a in (1, 2, 3)), index
+
+
+def error(a, b):
+    return math.sqrt(sum((a[i] - b[i]) ** 2 for i in (1, 2, 3)))
+
+
+def playing(states):
+    """Whether each timestamp falls inside a played phase, for timestamps given in order."""
+    index = -1
+    state = None
+
+    def check(timestamp):
+        nonlocal index, state
+        while index + 1 < len(states) and states[index + 1][0] <= timestamp:
+            index += 1
+            state = states[index][1]
+        return state in (STATE_PROCESSING, STATE_TIMED_PROCESSING)
+
+    return check
+
+
+def score(poses, states, latency_us, max_horizon_us, moving_dps):
+    """Prediction and unpredicted errors, for all scored samples and for the moving ones."""
+    scored = {"all": ([], []), "moving": ([], [])}
+    in_phase = playing(states) if states else (lambda timestamp: True)
+    index = 0
+    for i, (newest, rates) in enumerate(poses):
+        if not in_phase(newest[0]):
+            continue
+        target = newest[0] + latency_us
+        actual, index = actual_at(poses, max(index, i), target)
+        if actual is None:
+            break
+        predicted = predict(newest, rates, target, max_horizon_us)
+        groups = ["all"]
+        if math.sqrt(sum(r * r for r in rates)) > moving_dps:
+            groups.append("moving")
+        for group in groups:
+            scored[group][0].append(error(predicted, actual))
+            scored[group][1].append(error(newest, actual))
+    return scored
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(int(fraction * len(ordered)), len(ordered) - 1)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dumps", type=argparse.FileType("r"), nargs="+")
+    parser.add_argument("--latency-ms", type=float, nargs="+",
+                        default=[PREDICTION_DISPLAY_LATENCY_PRIOR_US / 1000.0,
+                                 (PREDICTION_RADIO_LATENCY_PRIOR_US +
+                                  PREDICTION_RADIO_AIR_TIME_US) / 1000.0],
+                        help="horizons to predict over")
+    parser.add_argument("--max-horizon-ms", type=float,
+                        default=PREDICTION_MAX_HORIZON_US / 1000.0)
+    parser.add_argument("--moving-dps", type=float, default=5.0,
+                        help="rate above which a sample counts as moving")
+    args = parser.parse_args()
+
+    max_horizon_us = int(args.max_horizon_ms * 1000)
+    print("%-24s %6s %8s %10s %8s %8s %12s" % ("", "ms", "samples", "avg deg", "p95 deg",
+                                              "max deg", "unpredicted"))
+    for dump in args.dumps:
+        samples, states = load(dump)
+        offsets = calibrate(samples)
+        if offsets is None:
+            sys.exit("%s: no still window to calibrate from; was it recorded with this firmware?"
+                     % dump.name)
+        poses = orientations(samples, *offsets)
+
+        for latency_ms in args.latency_ms:
+            scored = score(poses, states, int(latency_ms * 1000), max_horizon_us, args.moving_dps)
+            for group in ("all", "moving"):
+                errors, baseline = scored[group]
+                label = "%s %s" % (dump.name[-17:], group)
+                if not errors:
+                    print("%-24s %6.1f %8d" % (label, latency_ms, 0))
+                    continue
+                print("%-24s %6.1f %8d %10.2f %8.2f %8.2f %12.2f" % (
+                    label, latency_ms, len(errors), sum(errors) / len(errors),
+                    percentile(errors, 0.95), max(errors), sum(baseline) / len(baseline)))
+
+
+if __name__ == "__main__":
+    main()
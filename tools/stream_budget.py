@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Measures what the orientation stream costs per player, replayed from recorded traces.
+
+Record a session on each player's module with TRACE_RECORDER_ENABLED, dump them with 'd' and
+run:
+
+    python tools/stream_budget.py player1.txt player2.txt
+    python tools/stream_budget.py player1.txt --players 2 3 5 8 --threshold-deg 2
+
+The angles are rebuilt from the IMU records as prediction_replay does, and sampled every
+1/ORIENTATION_STREAM_RATE_HZ as streamOrientation() samples them. OrientationStreamEncoder and
+its AirtimeBudget run on them step for step; test/test_orientation_stream holds the C++ ones to
+the same frame sizes and share. A session with state records is only streamed while a phase is
+played, as on the device.
+
+Each trace is one player. For every player count, the budget is split between the players
+that stream (all but the master) as the firmware splits it. The table shows the mean bytes and
+estimated airtime each of them sends per second, and the channel share they take together. The
+refused column is the share of due frames the budget held back; those changes reach the master
+late or are overtaken by the next one. Payload bytes include the two byte link header but not
+bundling, which only lowers them.
+"""
+
+import argparse
+import math
+import sys
+
+from prediction_replay import STATE_PROCESSING, STATE_TIMED_PROCESSING, calibrate, load, \
+    orientations
+
+# hardware_config.h
+ORIENTATION_STREAM_RATE_HZ = 20
+ORIENTATION_STREAM_QUANTUM_DEG = 0.5
+ORIENTATION_STREAM_THRESHOLD_DEG = 1.0
+ORIENTATION_STREAM_KEYFRAME_MS = 1000
+ORIENTATION_STREAM_AIRTIME_US = 50000
+
+# OrientationStream.cpp
+PREAMBLE_US = 192
+OVERHEAD_BYTES = 43
+LINK_HEADER_BYTES = 2
+US_PER_BYTE = 8
+ACK_US = 10 + 304 + 50
+KEYFRAME_LENGTH = 1 + 3 * 2
+DELTA_LENGTH = 1 + 3
+
+
+def frame_airtime_us(payload_bytes):
+    return PREAMBLE_US + (OVERHEAD_BYTES + LINK_HEADER_BYTES + payload_bytes) * US_PER_BYTE + ACK_US
+
+
+def quantize(degrees):
+    """roundf(), then clamped to int16."""
+    quanta = degrees / ORIENTATION_STREAM_QUANTUM_DEG
+    rounded = math.copysign(math.floor(abs(quanta) + 0.5), quanta)
+    return int(min(max(rounded, -32768), 32767))
+
+
+class AirtimeBudget:
+    def __init__(self, share_us):
+        self.share_us = share_us
+        self.burst_us = share_us // 4
+        self.last_us = None
+        self.tokens_us = 0
+
+    def spend(self, now_us, cost_us):
+        if self.last_us is None:
+            self.tokens_us = self.burst_us
+        else:
+            earned = (now_us - self.last_us) * self.share_us // 1000000
+            self.tokens_us = min(self.tokens_us + earned, self.burst_us)
+        self.last_us = now_us
+        if self.tokens_us < cost_us:
+            return False
+        self.tokens_us -= cost_us
+        return True
+
+
+class Encoder:
+    """OrientationStreamEncoder::encode(), without the frame bytes."""
+
+    def __init__(self, share_us, threshold_deg):
+        self.budget = AirtimeBudget(share_us)
+        self.threshold_deg = threshold_deg
+        self.key = None
+        self.key_us = 0
+        self.sent = [0, 0, 0]
+        self.frames = self.bytes = self.airtime_us = self.refused = 0
+
+    def encode(self, timestamp, angles):
+        quantized = [quantize(a) for a in angles]
+        keyframe = (self.key is None or
+                    timestamp - self.key_us >= ORIENTATION_STREAM_KEYFRAME_MS * 1000)
+        changed = False
+        for i in range(3):
+            keyframe = keyframe or (self.key is not None and abs(quantized[i] - self.key[i]) > 127)
+            changed = changed or (abs(quantized[i] - self.sent[i]) * ORIENTATION_STREAM_QUANTUM_DEG
+                                  >= self.threshold_deg)
+        if not keyframe and not changed:
+            return
+
+        length = KEYFRAME_LENGTH if keyframe else DELTA_LENGTH
+        cost = frame_airtime_us(length)
+        if not self.budget.spend(timestamp, cost):
+            self.refused += 1
+            return
+
+        if keyframe:
+            self.key = quantized
+            self.key_us = timestamp
+        self.sent = quantized
+        self.frames += 1
+        self.bytes += LINK_HEADER_BYTES + length
+        self.airtime_us += cost
+
+
+def stream_samples(poses, states):
+    """The newest orientation at every stream tick while a phase is played."""
+    period_us = 1000000 // ORIENTATION_STREAM_RATE_HZ
+    in_phase = (STATE_PROCESSING, STATE_TIMED_PROCESSING)
+    state_index = -1
+    playing = not states
+    due_us = None
+    ticks = []
+    for i, (pose, _) in enumerate(poses):
+        timestamp = pose[0]
+        while state_index + 1 < len(states) and states[state_index + 1][0] <= timestamp:
+            state_index += 1
+            playing = states[state_index][1] in in_phase
+            due_us = None  # startOrientationStream() schedules the first tick at once
+        if not playing:
+            continue
+        if due_us is None:
+            due_us = timestamp
+        # Ticks until the next sample arrives see this one as the newest
+        next_us = poses[i + 1][0][0] if i + 1 < len(poses) else timestamp + 1
+        while due_us < next_us:
+            ticks.append(pose)
+            due_us += period_us
+    return ticks
+
+
+def measure(ticks, share_us, threshold_deg):
+    encoder = Encoder(share_us, threshold_deg)
+    for timestamp, x, y, z in ticks:
+        encoder.encode(timestamp, (x, y, z))
+    return encoder
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dumps", type=argparse.FileType("r"), nargs="+")
+    parser.add_argument("--players", type=int, nargs="+", default=[2, 3, 4, 6, 8],
+                        help="player counts, the master included")
+    parser.add_argument("--threshold-deg", type=float, default=ORIENTATION_STREAM_THRESHOLD_DEG)
+    parser.add_argument("--budget-us", type=int, default=ORIENTATION_STREAM_AIRTIME_US,
+                        help="airtime per second shared by the streaming players")
+    args = parser.parse_args()
+
+    streams = []
+    for dump in args.dumps:
+        samples, states = load(dump)
+        offsets = calibrate(samples)
+        if offsets is None:
+            sys.exit("%s: no still window to calibrate from; was it recorded with this firmware?"
+                     % dump.name)
+        ticks = stream_samples(orientations(samples, *offsets), states)
+        if len(ticks) < 2:
+            sys.exit("%s: no samples taken while a phase was played" % dump.name)
+        seconds = (ticks[-1][0] - ticks[0][0]) / 1e6 + 1.0 / ORIENTATION_STREAM_RATE_HZ
+        streams.append((ticks, seconds))
+        print("%s: %.1f s streamed" % (dump.name, seconds))
+
+    unlimited = [measure(ticks, 10 ** 9, args.threshold_deg) for ticks, _ in streams]
+    print()
+    print("unlimited: %.1f frames/s, %.0f B/s, %.2f%% of the channel per player" % (
+        sum(e.frames / s for e, (_, s) in zip(unlimited, streams)) / len(streams),
+        sum(e.bytes / s for e, (_, s) in zip(unlimited, streams)) / len(streams),
+        sum(e.airtime_us / s for e, (_, s) in zip(unlimited, streams)) / len(streams) / 1e4))
+
+    print()
+    print("%7s %9s %9s %8s %10s %9s %8s" % ("players", "share us", "frames/s", "B/s",
+                                            "airtime %", "channel %", "refused"))
+    for players in args.players:
+        streaming = max(players - 1, 1)
+        share_us = args.budget_us // streaming
+        encoders = [measure(ticks, share_us, args.threshold_deg) for ticks, _ in streams]
+        frames = sum(e.frames / s for e, (_, s) in zip(encoders, streams)) / len(streams)
+        rate = sum(e.bytes / s for e, (_, s) in zip(encoders, streams)) / len(streams)
+        airtime = sum(e.airtime_us / s for e, (_, s) in zip(encoders, streams)) / len(streams)
+        due = sum(e.frames + e.refused for e in encoders)
+        refused = sum(e.refused for e in encoders)
+        print("%7d %9d %9.1f %8.0f %10.2f %9.2f %7.1f%%" % (
+            players, share_us, frames, rate, airtime / 1e4, streaming * airtime / 1e4,
+            100.0 * refused / due if due else 0.0))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Decodes a trace recorder dump captured from the serial port.
+
+Send 'd' to a device built with TRACE_RECORDER_ENABLED and save everything it prints, then:
+
+    python tools/trace_decode.py dump.txt > trace.csv
+    python tools/trace_decode.py dump.txt --imu > imu.csv
+
+The first form lists every record in time order. The second keeps only IMU samples
+(time in seconds, accel in g, gyro in deg/s), ready to feed a filter replay.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+HEADER = struct.Struct("<IHHqII")  # sequence, length, records, baseUs, dropped, crc
+
+RECORD_IMU = 1
+RECORD_STATE = 2
+RECORD_BUTTON = 3
+RECORD_MESSAGE = 4
+RECORD_LINK = 5
+RECORD_TEMPERATURE = 6
+
+MESSAGE_KINDS = {1: "submission", 2: "phase", 3: "transmission"}
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def read_pages(lines):
+    pages = []
+    inside = False
+    for line in lines:
+        line = line.strip()
+        if line.startswith("trace-begin"):
+            inside = True
+        elif line == "trace-end":
+            inside = False
+        elif inside and line:
+            try:
+                pages.append(bytes.fromhex(line))
+            except ValueError:
+                pass  # other firmware output interleaved with the dump
+    return pages
+
+
+def decode_page(page):
+    sequence, length, count, base_us, dropped, crc = HEADER.unpack_from(page)
+    payload = page[HEADER.size:HEADER.size + length]
+    expected = zlib.crc32(payload, zlib.crc32(page[:HEADER.size - 4]))
+    if len(payload) != length or expected != crc:
+        return None
+
+    records = []
+    timestamp = base_us
+    imu = [0] * 6
+    pos = 0
+    for _ in range(count):
+        kind = payload[pos]
+        delta, pos = read_varint(payload, pos + 1)
+        timestamp += unzigzag(delta)
+
+        if kind == RECORD_IMU:
+            for i in range(6):
+                value, pos = read_varint(payload, pos)
+                imu[i] += unzigzag(value)
+            records.append((timestamp, "imu", [v / 1000.0 for v in imu[:3]] +
+                            [v / 100.0 for v in imu[3:]]))
+        elif kind in (RECORD_STATE, RECORD_BUTTON):
+            value, pos = read_varint(payload, pos)
+            records.append((timestamp, "state" if kind == RECORD_STATE else "button",
+                            [unzigzag(value)]))
+        elif kind == RECORD_MESSAGE:
+            message_kind, size = payload[pos], payload[pos + 1]
+            body = payload[pos + 2:pos + 2 + size]
+            pos += 2 + size
+            records.append((timestamp, "message",
+                            [MESSAGE_KINDS.get(message_kind, message_kind), body.hex()]))
+        elif kind == RECORD_TEMPERATURE:
+            value, pos = read_varint(payload, pos)
+            records.append((timestamp, "temperature", [unzigzag(value) / 100.0]))
+        elif kind == RECORD_LINK:
+            records.append((timestamp, "link", list(payload[pos:pos + 4])))  # peer type length wait
+            pos += 4
+        else:
+            break  # unknown record type; the rest of the page cannot be framed
+    return sequence, dropped, records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", type=argparse.FileType("r"))
+    parser.add_argument("--imu", action="store_true", help="only output IMU samples")
+    args = parser.parse_args()
+
+    decoded = []
+    corrupt = 0
+    for page in read_pages(args.dump):
+        result = decode_page(page) if len(page) >= HEADER.size else None
+        if result is None:
+            corrupt += 1
+        else:
+            decoded.append(result)
+    decoded.sort(key=lambda entry: entry[0])
+
+    records = []
+    for sequence, dropped, page_records in decoded:
+        if dropped:
+            records.append((page_records[0][0] if page_records else 0, "dropped", [dropped]))
+        records.extend(page_records)
+    records.sort(key=lambda record: record[0])
+
+    out = sys.stdout
+    if args.imu:
+        out.write("t,ax,ay,az,gx,gy,gz\n")
+        for timestamp, kind, values in records:
+            if kind == "imu":
+                out.write("%.6f,%s\n" % (timestamp / 1e6, ",".join("%g" % v for v in values)))
+    else:
+        out.write("t,type,values\n")
+        for timestamp, kind, values in records:
+            out.write("%.6f,%s,%s\n" % (timestamp / 1e6, kind, " ".join(str(v) for v in values)))
+
+    print("%d pages decoded, %d skipped as torn or corrupt" % (len(decoded), corrupt),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()